@@ -1,6 +1,7 @@
 #include "ppsspp_config.h"
 
 #include <errno.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #ifndef _WIN32
@@ -10,6 +11,13 @@
 #include <sys/types.h>
 #include <sys/select.h>
 #include <unistd.h>
+#if PPSSPP_PLATFORM(LINUX) || PPSSPP_PLATFORM(ANDROID)
+#include <sys/sendfile.h>
+#define HAVE_SENDFILE
+#elif PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS)
+#include <sys/uio.h>
+#define HAVE_SENDFILE
+#endif
 #else
 #include <io.h>
 #include <winsock2.h>
@@ -134,6 +142,56 @@ void SetNonBlocking(int sock, bool non_blocking) {
 #endif
 }
 
+int64_t SendFile(int sock, int fileFd, int64_t offset, int64_t length, double timeout) {
+#ifdef HAVE_SENDFILE
+	int64_t sent = 0;
+	while (sent < length) {
+		int64_t pos = offset + sent;
+		// Keep each call reasonably sized, some kernels cap it anyway.
+		int64_t chunk = std::min(length - sent, (int64_t)0x40000000);
+#if PPSSPP_PLATFORM(LINUX) || PPSSPP_PLATFORM(ANDROID)
+		// With a 32-bit off_t, let the caller handle anything past 2GB.
+		if (sizeof(off_t) < sizeof(int64_t) && pos + chunk > 0x7FFFFFFF)
+			break;
+		off_t off = (off_t)pos;
+		ssize_t result = sendfile(sock, fileFd, &off, (size_t)chunk);
+		if (result > 0) {
+			sent += result;
+			continue;
+		} else if (result == 0) {
+			// End of file.
+			break;
+		}
+#else
+		off_t len = (off_t)chunk;
+		int result = sendfile(fileFd, sock, (off_t)pos, &len, nullptr, 0);
+		// Even when interrupted, len says how much went out.
+		sent += len;
+		if (result == 0) {
+			if (len == 0)
+				break;
+			continue;
+		}
+#endif
+		if (errno == EINTR)
+			continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			if (!WaitUntilReady(sock, timeout, true))
+				return -1;
+			continue;
+		}
+		if (sent == 0 && (errno == EINVAL || errno == ENOSYS || errno == ENOTSUP || errno == EOPNOTSUPP)) {
+			// Not supported for this kind of file, caller can copy instead.
+			return 0;
+		}
+		return -1;
+	}
+	return sent;
+#else
+	return 0;
+#endif
+}
+
 std::string GetLocalIP(int sock) {
 	union {
 		struct sockaddr sa;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -19,6 +20,11 @@ bool WaitUntilReady(int fd, double timeout, bool for_write = false);
 
 void SetNonBlocking(int fd, bool non_blocking);
 
+// Sends a range of a file straight to a socket, without copying it through userspace.
+// Returns the number of bytes sent, which may be short (or 0 where unsupported) - the caller
+// should send the rest itself. Returns -1 on socket errors.
+int64_t SendFile(int sock, int fileFd, int64_t offset, int64_t length, double timeout);
+
 std::string GetLocalIP(int sock);
 
 }  // fd_util
@@ -1,3 +1,4 @@
+#include "ppsspp_config.h"
 #include "Common/Net/HTTPClient.h"
 
 #include "Common/TimeUtil.h"
@@ -21,10 +22,16 @@
 #include <io.h>
 #endif
 
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0x00
+#endif
+
 #include "Common/Net/Resolve.h"
 #include "Common/Net/URL.h"
 
@@ -313,7 +320,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 		"Host: %s\r\n"
 		"User-Agent: %s\r\n"
 		"Accept: %s\r\n"
-		"Connection: close\r\n"
+		"Connection: %s\r\n"
 		"%s"
 		"\r\n";
 
@@ -322,6 +329,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 		host_.c_str(),
 		userAgent_.c_str(),
 		req.acceptMime,
+		keepAlive_ ? "keep-alive" : "close",
 		otherHeaders ? otherHeaders : "");
 	buffer.Append(data);
 	bool flushed = buffer.FlushSocket(sock(), dataTimeout_, progress->cancelled);
@@ -332,23 +340,36 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 }
 
 int Client::ReadResponseHeaders(net::Buffer *readbuf, std::vector<std::string> &responseHeaders, RequestProgress *progress) {
-	// Snarf all the data we can into RAM. A little unsafe but hey.
 	static constexpr float CANCEL_INTERVAL = 0.25f;
-	bool ready = false;
 	double endTimeout = time_now_d() + dataTimeout_;
-	while (!ready) {
-		if (progress->cancelled && *progress->cancelled)
-			return -1;
-		ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
-		if (!ready && time_now_d() > endTimeout) {
-			ERROR_LOG(IO, "HTTP headers timed out");
+	auto hasAllHeaders = [&] {
+		std::string peek;
+		readbuf->PeekAll(&peek);
+		return peek.find("\r\n\r\n") != peek.npos;
+	};
+
+	// With keep-alive, a previous read may already have pulled in this response.
+	while (!hasAllHeaders()) {
+		bool ready = false;
+		while (!ready) {
+			if (progress->cancelled && *progress->cancelled)
+				return -1;
+			ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
+			if (!ready && time_now_d() > endTimeout) {
+				ERROR_LOG(IO, "HTTP headers timed out");
+				return -1;
+			}
+		};
+
+		size_t before = readbuf->size();
+		if (readbuf->Read(sock(), 4096) < 0) {
+			ERROR_LOG(IO, "Failed to read HTTP headers :(");
 			return -1;
 		}
-	};
-	// Let's hope all the headers are available in a single packet...
-	if (readbuf->Read(sock(), 4096) < 0) {
-		ERROR_LOG(IO, "Failed to read HTTP headers :(");
-		return -1;
+		if (readbuf->size() == before) {
+			// Readable but nothing came, so the connection was closed.  Parse what we have.
+			break;
+		}
 	}
 
 	// Grab the first header line that contains the http code.
@@ -384,6 +405,46 @@ int Client::ReadResponseHeaders(net::Buffer *readbuf, std::vector<std::string> &
 	return code;
 }
 
+int Client::ReadResponseBody(net::Buffer *readbuf, char *dest, size_t length, RequestProgress *progress) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	size_t buffered = std::min(readbuf->size(), length);
+	readbuf->Take(buffered, dest);
+
+	size_t pos = buffered;
+	double endTimeout = time_now_d() + dataTimeout_;
+	while (pos < length) {
+		if (progress->cancelled && *progress->cancelled)
+			return -1;
+		if (!fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false)) {
+			if (time_now_d() > endTimeout) {
+				ERROR_LOG(IO, "HTTP body timed out");
+				return -1;
+			}
+			continue;
+		}
+
+		int retval = recv(sock(), dest + pos, (int)std::min(length - pos, (size_t)0x40000000), MSG_NOSIGNAL);
+		if (retval == 0) {
+			ERROR_LOG(IO, "Connection closed with %d bytes of body left", (int)(length - pos));
+			return -1;
+		} else if (retval < 0) {
+#if PPSSPP_PLATFORM(WINDOWS)
+			if (WSAGetLastError() != WSAEWOULDBLOCK) {
+#else
+			if (errno != EWOULDBLOCK) {
+#endif
+				ERROR_LOG(IO, "Error reading HTTP body: %i", retval);
+				return -1;
+			}
+			continue;
+		}
+		pos += retval;
+		endTimeout = time_now_d() + dataTimeout_;
+		progress->progress = (float)pos / (float)length;
+	}
+	return 0;
+}
+
 int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::string> &responseHeaders, Buffer *output, RequestProgress *progress) {
 	bool gzip = false;
 	bool chunked = false;
@@ -82,6 +82,10 @@ class Client : public net::Connection {
 	int ReadResponseHeaders(net::Buffer *readbuf, std::vector<std::string> &responseHeaders, RequestProgress *progress);
 	// If your response contains a response, you must read it.
 	int ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::string> &responseHeaders, Buffer *output, RequestProgress *progress);
+	// Reads exactly length bytes of body, starting with whatever is left in readbuf.
+	// Unlike ReadResponseEntity, this leaves the connection ready for the next response.
+	// Like the other calls, progress must not be null.
+	int ReadResponseBody(net::Buffer *readbuf, char *dest, size_t length, RequestProgress *progress);
 
 	void SetDataTimeout(double t) {
 		dataTimeout_ = t;
@@ -91,10 +95,16 @@ class Client : public net::Connection {
 		userAgent_ = value;
 	}
 
+	// Asks the server to keep the connection open, so several requests can share it.
+	void SetKeepAlive(bool keepAlive) {
+		keepAlive_ = keepAlive;
+	}
+
 protected:
 	std::string userAgent_;
 	const char *httpVersion_;
 	double dataTimeout_ = 900.0;
+	bool keepAlive_ = false;
 };
 
 // Not particularly efficient, but hey - it's a background download, that's pretty cool :P
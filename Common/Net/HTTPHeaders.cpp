@@ -97,6 +97,8 @@ int RequestHeader::ParseHttpHeader(const char *buffer) {
 			type = FULL;
 		else
 			type = SIMPLE;
+		// Persistent connections are the default from HTTP/1.1 on.
+		keep_alive = strstr(buffer, "HTTP/1.1") != nullptr;
 		return 0;
 	}
 
@@ -155,6 +157,15 @@ void RequestHeader::ParseHeaders(net::InputSink *sink) {
 
 	VERBOSE_LOG(IO, "finished parsing request.");
 	ok = line_count > 1;
+
+	std::string connection;
+	if (GetOther("connection", &connection)) {
+		std::transform(connection.begin(), connection.end(), connection.begin(), tolower);
+		if (connection.find("close") != connection.npos)
+			keep_alive = false;
+		else if (connection.find("keep-alive") != connection.npos)
+			keep_alive = true;
+	}
 }
 
 }  // namespace http
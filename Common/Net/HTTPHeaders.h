@@ -36,6 +36,8 @@ class RequestHeader {
 		UNSUPPORTED,
 	};
 	Method method = UNSUPPORTED;
+	// Whether the client wants to send more requests over the same connection.
+	bool keep_alive = false;
 	bool ok = false;
 	void ParseHeaders(net::InputSink *sink);
 	bool GetParamValue(const char *param_name, std::string *value) const;
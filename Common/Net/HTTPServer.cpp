@@ -59,15 +59,18 @@ namespace http {
 
 // Note: charset here helps prevent XSS.
 const char *const DEFAULT_MIME_TYPE = "text/html; charset=utf-8";
+// How long an idle kept-alive connection waits for the next request.
+static const double KEEP_ALIVE_TIMEOUT = 15.0;
 
 Request::Request(int fd)
 	: fd_(fd) {
 	in_ = new net::InputSink(fd);
 	out_ = new net::OutputSink(fd);
-	header_.ParseHeaders(in_);
+	header_ = new RequestHeader();
+	header_->ParseHeaders(in_);
 
-	if (header_.ok) {
-		VERBOSE_LOG(IO, "The request carried with it %i bytes", (int)header_.content_length);
+	if (header_->ok) {
+		VERBOSE_LOG(IO, "The request carried with it %i bytes", (int)header_->content_length);
 	} else {
 	    Close();
 	}
@@ -75,6 +78,7 @@ Request::Request(int fd)
 
 Request::~Request() {
 	Close();
+	delete header_;
 
 	if (!in_->Empty()) {
 		ERROR_LOG(IO, "Input not empty - invalid request?");
@@ -112,7 +116,9 @@ void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size,
 	buffer->Push("Server: PPSSPPServer v0.1\r\n");
 	if (!mimeType || strcmp(mimeType, "websocket") != 0) {
 		buffer->Printf("Content-Type: %s\r\n", mimeType ? mimeType : DEFAULT_MIME_TYPE);
-		buffer->Push("Connection: close\r\n");
+		// Without a length or with an unread body, the client can't tell where the next response starts.
+		keepAlive_ = header_->keep_alive && !strcmp(ver, "1.1") && size >= 0 && header_->content_length <= 0;
+		buffer->Push(keepAlive_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
 	}
 	if (size >= 0) {
 		buffer->Printf("Content-Length: %llu\r\n", size);
@@ -134,6 +140,14 @@ void Request::Write() {
 	Close();
 }
 
+bool Request::ReadNext() {
+	delete header_;
+	header_ = new RequestHeader();
+	keepAlive_ = false;
+	header_->ParseHeaders(in_);
+	return header_->ok;
+}
+
 void Request::Close() {
 	if (fd_) {
 		closesocket(fd_);
@@ -313,6 +327,7 @@ bool Server::Run(int port) {
 }
 
 void Server::Stop() {
+	stopping_ = true;
 	closesocket(listener_);
 }
 
@@ -327,7 +342,21 @@ void Server::HandleConnection(int conn_fd) {
 	// TODO: Way to mark the content body as read, read it here if never read.
 	// This allows the handler to stream if need be.
 
-	// TODO: Could handle keep alive here.
+	// Keep serving the same client as long as responses allow it.
+	while (request.KeepAlive() && !stopping_) {
+		request.WritePartial();
+
+		// Wait for the next request, but don't hold up Stop() for long.
+		double deadline = time_now_d() + KEEP_ALIVE_TIMEOUT;
+		bool ready = !request.In()->Empty();
+		while (!ready && !stopping_ && time_now_d() < deadline) {
+			ready = fd_util::WaitUntilReady(conn_fd, 0.25, false);
+		}
+		if (!ready || stopping_ || !request.ReadNext())
+			break;
+		HandleRequest(request);
+	}
+
 	request.Write();
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <thread>
@@ -31,19 +32,19 @@ class Request {
 	~Request();
 
 	const char *resource() const {
-		return header_.resource;
+		return header_->resource;
 	}
 
 	RequestHeader::Method Method() const {
-		return header_.method;
+		return header_->method;
 	}
 
 	bool GetParamValue(const char *param_name, std::string *value) const {
-		return header_.GetParamValue(param_name, value);
+		return header_->GetParamValue(param_name, value);
 	}
 	// Use lowercase.
 	bool GetHeader(const char *name, std::string *value) const {
-		return header_.GetOther(name, value);
+		return header_->GetOther(name, value);
 	}
 
 	net::InputSink *In() const { return in_; }
@@ -59,13 +60,22 @@ class Request {
 	bool IsOK() const { return fd_ > 0; }
 
 	// If size is negative, no Content-Length: line is written.
+	// An HTTP/1.1 response with a size keeps the connection open if the client asked for that.
 	void WriteHttpResponseHeader(const char *ver, int status, int64_t size = -1, const char *mimeType = nullptr, const char *otherHeaders = nullptr) const;
 
+	// True if the response written lets the connection carry another request.
+	bool KeepAlive() const { return keepAlive_; }
+	// For responses that were cut short, so the client isn't left waiting for the rest.
+	void CloseAfterResponse() const { keepAlive_ = false; }
+	// Parses the next request on a kept-alive connection, replacing this one.
+	bool ReadNext();
+
 private:
 	net::InputSink *in_;
 	net::OutputSink *out_;
-	RequestHeader header_;
+	RequestHeader *header_;
 	int fd_;
+	mutable bool keepAlive_ = false;
 };
 
 // Register handlers on this class to serve stuff.
@@ -115,6 +125,7 @@ class Server {
 
 	int listener_;
 	int port_ = 0;
+	std::atomic<bool> stopping_{ false };
 
 	UrlHandlerMap handlers_;
 	UrlHandlerFunc fallback_;
@@ -302,7 +302,7 @@ bool OutputSink::Printf(const char *fmt, ...) {
 		// There wasn't enough space.  Let's use a buffer instead.
 		// This could be caused by wraparound.
 		char temp[BUFFER_SIZE];
-		result = vsnprintf(temp, BUFFER_SIZE, fmt, args);
+		result = vsnprintf(temp, BUFFER_SIZE, fmt, backup);
 
 		if ((size_t)result < BUFFER_SIZE && result > 0) {
 			// In case it did return the null terminator.
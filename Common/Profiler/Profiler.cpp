@@ -1,6 +1,8 @@
 // Ultra-lightweight category profiler with history.
+// Also records scoped trace events for export to Chrome's trace viewer.
 
 #include <algorithm>
+#include <chrono>
 #include <mutex>
 #include <map>
 #include <string>
@@ -9,11 +11,28 @@
 
 #include "ppsspp_config.h"
 
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#if !PPSSPP_PLATFORM(WINDOWS)
+#include <pthread.h>
+#endif
+
 #include "Common/Render/DrawBuffer.h"
 
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/TimeUtil.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
 
 #define MAX_CATEGORIES 64 // Can be any number, represents max profiled names.
 #define MAX_DEPTH 16      // Can be any number, represents max nesting depth of profiled names.
@@ -264,3 +283,243 @@ void Profiler_GetHistory(int category, int thread, float *data, int count) {
 		data[i] = history[MAX_THREADS * x + thread].time_taken[category];
 	}
 }
+
+// Trace events are appended by each thread to its own buffer, so recording takes no locks.
+// Buffers grow in fixed-size chunks that are never moved, and the event count is published
+// with release semantics, which lets the exporter read them without stopping the threads.
+#define TRACE_CHUNK_EVENTS 4096
+#define TRACE_MAX_CHUNKS 256  // 1M events per thread per trace.
+
+struct TraceEvent {
+	const char *name;
+	uint64_t start;
+	uint64_t end;
+};
+
+struct TraceThread {
+	~TraceThread() {
+		for (int i = 0; i < TRACE_MAX_CHUNKS; ++i)
+			delete [] chunks[i].load(std::memory_order_relaxed);
+	}
+
+	std::string name;
+	int tid = 0;
+	// Events from an older trace are discarded when the thread next records.
+	std::atomic<uint32_t> generation{};
+	std::atomic<uint32_t> count{};
+	std::atomic<uint32_t> dropped{};
+	std::atomic<bool> orphaned{};
+	std::atomic<TraceEvent *> chunks[TRACE_MAX_CHUNKS]{};
+};
+
+std::atomic<bool> g_profilerTracing;
+
+static std::mutex traceLock;
+static std::vector<TraceThread *> traceThreads;
+static std::atomic<uint32_t> traceGeneration;
+static std::atomic<uint64_t> traceStartTicks;
+static double traceStartTime;
+
+static inline uint64_t TraceTicks() {
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#if MAX_THREADS > 1
+// Marks the buffer for cleanup when its thread exits, it's freed on the next start.
+struct TraceThreadOwner {
+	~TraceThreadOwner() {
+		if (buffer)
+			buffer->orphaned = true;
+	}
+	TraceThread *buffer = nullptr;
+};
+
+static thread_local TraceThreadOwner traceThreadOwner;
+
+static std::string GetTraceThreadName(int tid) {
+#if (PPSSPP_PLATFORM(LINUX) && !PPSSPP_PLATFORM(ANDROID)) || PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS)
+	char name[64]{};
+	if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0 && name[0] != '\0')
+		return name;
+#endif
+	return StringFromFormat("Thread %d", tid);
+}
+
+static TraceThread *GetTraceThread() {
+	TraceThread *buffer = traceThreadOwner.buffer;
+	if (!buffer) {
+		buffer = new TraceThread();
+		buffer->tid = GetCurrentThreadIdForDebug();
+		buffer->name = GetTraceThreadName(buffer->tid);
+
+		std::lock_guard<std::mutex> guard(traceLock);
+		traceThreads.push_back(buffer);
+		traceThreadOwner.buffer = buffer;
+	}
+	return buffer;
+}
+#endif
+
+uint64_t internal_profiler_trace_begin() {
+	uint64_t ticks = TraceTicks();
+	return ticks != 0 ? ticks : 1;
+}
+
+void internal_profiler_trace_end(const char *name, uint64_t start) {
+#if MAX_THREADS > 1
+	uint64_t end = TraceTicks();
+	// Tracing may have stopped, or restarted, while this scope was open.
+	if (!g_profilerTracing.load(std::memory_order_relaxed) || start < traceStartTicks.load(std::memory_order_relaxed))
+		return;
+
+	TraceThread *buffer = GetTraceThread();
+	uint32_t generation = traceGeneration.load(std::memory_order_acquire);
+	if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+		buffer->count.store(0, std::memory_order_relaxed);
+		buffer->dropped.store(0, std::memory_order_relaxed);
+		buffer->generation.store(generation, std::memory_order_release);
+	}
+
+	uint32_t index = buffer->count.load(std::memory_order_relaxed);
+	uint32_t chunk = index / TRACE_CHUNK_EVENTS;
+	if (chunk >= TRACE_MAX_CHUNKS) {
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	TraceEvent *events = buffer->chunks[chunk].load(std::memory_order_relaxed);
+	if (!events) {
+		events = new TraceEvent[TRACE_CHUNK_EVENTS];
+		buffer->chunks[chunk].store(events, std::memory_order_release);
+	}
+
+	TraceEvent &event = events[index % TRACE_CHUNK_EVENTS];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	buffer->count.store(index + 1, std::memory_order_release);
+#endif
+}
+
+void Profiler_StartTrace() {
+#if MAX_THREADS > 1
+	std::lock_guard<std::mutex> guard(traceLock);
+	g_profilerTracing = false;
+
+	// Threads that have exited can't be recording anymore.
+	auto orphaned = [](TraceThread *buffer) {
+		if (!buffer->orphaned)
+			return false;
+		delete buffer;
+		return true;
+	};
+	traceThreads.erase(std::remove_if(traceThreads.begin(), traceThreads.end(), orphaned), traceThreads.end());
+
+	traceStartTime = time_now_d();
+	traceStartTicks = TraceTicks();
+	traceGeneration++;
+	g_profilerTracing = true;
+	INFO_LOG(SYSTEM, "Started recording trace events");
+#else
+	WARN_LOG(SYSTEM, "Trace events are not supported on this platform");
+#endif
+}
+
+void Profiler_StopTrace() {
+	if (g_profilerTracing.exchange(false))
+		INFO_LOG(SYSTEM, "Stopped recording trace events");
+}
+
+bool Profiler_IsTracing() {
+	return g_profilerTracing;
+}
+
+bool Profiler_ExportChromeTrace(const Path &filename) {
+	std::lock_guard<std::mutex> guard(traceLock);
+	if (traceGeneration == 0) {
+		WARN_LOG(SYSTEM, "No trace has been recorded to export");
+		return false;
+	}
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		ERROR_LOG(SYSTEM, "Unable to open trace file for writing: %s", filename.c_str());
+		return false;
+	}
+
+	// Calibrate the tick rate over the whole trace, so rdtsc doesn't need a known frequency.
+	uint64_t startTicks = traceStartTicks;
+	double ticksPerUs = 1000.0;
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	double elapsed = time_now_d() - traceStartTime;
+	uint64_t elapsedTicks = TraceTicks() - startTicks;
+	if (elapsed > 0.0 && elapsedTicks != 0)
+		ticksPerUs = (double)elapsedTicks / (elapsed * 1000000.0);
+#endif
+
+	json::JsonWriter writer;
+	writer.begin();
+	writer.writeString("displayTimeUnit", "ms");
+	writer.pushArray("traceEvents");
+
+	uint32_t generation = traceGeneration;
+	size_t total = 0;
+	uint32_t dropped = 0;
+	for (TraceThread *buffer : traceThreads) {
+		if (buffer->generation.load(std::memory_order_acquire) != generation)
+			continue;
+		uint32_t count = buffer->count.load(std::memory_order_acquire);
+		if (count == 0)
+			continue;
+
+		writer.pushDict();
+		writer.writeString("name", "thread_name");
+		writer.writeString("ph", "M");
+		writer.writeInt("pid", 1);
+		writer.writeInt("tid", buffer->tid);
+		writer.pushDict("args");
+		writer.writeString("name", buffer->name);
+		writer.pop();
+		writer.pop();
+
+		for (uint32_t i = 0; i < count; ++i) {
+			const TraceEvent *events = buffer->chunks[i / TRACE_CHUNK_EVENTS].load(std::memory_order_acquire);
+			const TraceEvent &event = events[i % TRACE_CHUNK_EVENTS];
+			writer.pushDict();
+			writer.writeString("name", event.name);
+			writer.writeString("ph", "X");
+			writer.writeRaw("ts", StringFromFormat("%.3f", (double)(event.start - startTicks) / ticksPerUs));
+			writer.writeRaw("dur", StringFromFormat("%.3f", (double)(event.end - event.start) / ticksPerUs));
+			writer.writeInt("pid", 1);
+			writer.writeInt("tid", buffer->tid);
+			writer.pop();
+
+			// Keep the buffered JSON small, traces can have millions of events.
+			if ((i & 0xFFF) == 0xFFF) {
+				std::string data = writer.flush();
+				fwrite(data.data(), 1, data.size(), f);
+			}
+		}
+		total += count;
+		dropped += buffer->dropped.load(std::memory_order_relaxed);
+	}
+
+	writer.pop();
+	writer.end();
+	std::string data = writer.flush();
+	bool success = fwrite(data.data(), 1, data.size(), f) == data.size();
+	success = fclose(f) == 0 && success;
+
+	if (dropped != 0)
+		WARN_LOG(SYSTEM, "Trace buffers were full, %d events dropped", dropped);
+	if (!success) {
+		ERROR_LOG(SYSTEM, "Failed to write trace file: %s", filename.c_str());
+		return false;
+	}
+	INFO_LOG(SYSTEM, "Exported %d trace events to %s", (int)total, filename.c_str());
+	return true;
+}
@@ -1,9 +1,42 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 // #define USE_PROFILER
 
+class Path;
+
+// Scoped trace events. Unlike the category profiler below, this is compiled into all builds
+// and costs a single relaxed load per scope until recording is switched on at runtime.
+extern std::atomic<bool> g_profilerTracing;
+
+uint64_t internal_profiler_trace_begin();  // Never returns 0.
+void internal_profiler_trace_end(const char *name, uint64_t start);
+
+// Starting a trace discards events from the previous one.
+void Profiler_StartTrace();
+void Profiler_StopTrace();
+bool Profiler_IsTracing();
+// Writes the events recorded since the last start in Chrome's trace event format
+// (load in chrome://tracing or ui.perfetto.dev.)
+bool Profiler_ExportChromeTrace(const Path &filename);
+
+// The name must be a string that lives until the trace is exported, usually a literal.
+class ProfileTraceScope {
+public:
+	ProfileTraceScope(const char *name) : name_(name) {
+		start_ = g_profilerTracing.load(std::memory_order_relaxed) ? internal_profiler_trace_begin() : 0;
+	}
+	~ProfileTraceScope() {
+		if (start_ != 0)
+			internal_profiler_trace_end(name_, start_);
+	}
+private:
+	const char *name_;
+	uint64_t start_;
+};
+
 #ifdef USE_PROFILER
 
 class DrawBuffer;
@@ -24,13 +57,14 @@ void Profiler_GetHistory(int category, int thread, float *data, int count);
 
 class ProfileThis {
 public:
-	ProfileThis(const char *category) {
+	ProfileThis(const char *category) : trace_(category) {
 		cat_ = internal_profiler_enter(category, &thread_);
 	}
 	~ProfileThis() {
 		internal_profiler_leave(thread_, cat_);
 	}
 private:
+	ProfileTraceScope trace_;
 	int cat_;
 	int thread_;
 };
@@ -42,7 +76,7 @@ class ProfileThis {
 #else
 
 #define PROFILE_INIT()
-#define PROFILE_THIS_SCOPE(cat)
+#define PROFILE_THIS_SCOPE(cat) ProfileTraceScope _profile_scoped(cat);
 #define PROFILE_END_FRAME()
 
 #endif
@@ -118,10 +118,13 @@ struct Config {
 	uint32_t uJitDisableFlags;
 
 	bool bSeparateSASThread;
+	bool bVideoDecodeAhead;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
 	bool bCacheFullIsoInRam;
+	// Read disc images on fixed local disks through a memory mapping instead of read calls.
+	bool bMapLocalDiscImages;
 	int iRemoteISOPort;
 	std::string sLastRemoteISOServer;
 	int iLastRemoteISOPort;
@@ -202,6 +205,8 @@ struct Config {
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexScalingAsync;  // Upload unscaled first and scale on a background thread.
+	bool bTexScalingDiskCache;  // Keep scaled textures in the app cache directory.
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iMaxRecent;
@@ -488,6 +493,13 @@ struct Config {
 	// Double edged sword: much easier debugging, but not accurate.
 	bool bSkipDeadbeefFilling;
 	bool bFuncHashMap;
+	// Samples emulated cycles per function, to find replacement candidates. Written to funccycles.csv.
+	bool bFuncCycleStats;
+	// Catch memchecks by protecting their pages, so the jit can skip checking every access.
+	// Only used with the native jit and fast memory, others keep checking in the jit.
+	bool bMemCheckPageProtect;
+	// Track memory allocs and writes for the debugger, off skips everything but memchecks.
+	bool bDebugMemInfo;
 	bool bDebugMemInfoDetailed;
 	bool bDrawFrameGraph;
 
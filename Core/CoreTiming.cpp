@@ -28,8 +28,10 @@
 #include "Core/CoreTiming.h"
 #include "Core/Core.h"
 #include "Core/Config.h"
+#include "Core/HLE/ReplaceTables.h"
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/HLE/sceDisplay.h"
+#include "Core/MemFault.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 
@@ -39,6 +41,8 @@ int CPU_HZ = 222000000;
 // is this really necessary?
 #define INITIAL_SLICE_LENGTH 20000
 #define MAX_SLICE_LENGTH 100000000
+// Slice length cap while sampling function cycle stats, so samples aren't too coarse.
+#define FUNC_STATS_SLICE_LENGTH 20000
 
 namespace CoreTiming
 {
@@ -598,6 +602,10 @@ void Advance() {
 	int cyclesExecuted = slicelength - currentMIPS->downcount;
 	globalTimer += cyclesExecuted;
 	currentMIPS->downcount = slicelength;
+	if (g_Config.bFuncCycleStats) {
+		Replacement_SampleCycles(currentMIPS->pc, cyclesExecuted);
+	}
+	Memory::MemFault_ProcessWatchpoints();
 
 	if (hasTsEvents.load(std::memory_order_acquire))
 		MoveEvents();
@@ -615,6 +623,8 @@ void Advance() {
 		int target = (int)(first->time - globalTimer);
 		if (target > MAX_SLICE_LENGTH)
 			target = MAX_SLICE_LENGTH;
+		if (g_Config.bFuncCycleStats && target > FUNC_STATS_SLICE_LENGTH)
+			target = FUNC_STATS_SLICE_LENGTH;
 
 		const int diff = target - slicelength;
 		slicelength += diff;
@@ -393,6 +393,7 @@ void CWCheatEngine::ParseCheats() {
 	// TODO: Report errors.
 
 	cheats_ = parser.GetCheats();
+	Compile();
 }
 
 u32 CWCheatEngine::GetAddress(u32 value) {
@@ -799,6 +800,114 @@ CheatOperation CWCheatEngine::InterpretNextOp(const CheatCode &cheat, size_t &i)
 	}
 }
 
+struct CheatInstruction {
+	CheatOperation op;
+	// Instruction to run next when the op passes, and when a condition fails (or the cheat stops.)
+	uint32_t next;
+	uint32_t branch;
+	// Index into CheatProgram::lines of the extra lines read by pointer commands.
+	uint32_t extraLines;
+};
+
+struct CheatProgram {
+	std::vector<CheatInstruction> code;
+	std::vector<CheatLine> lines;
+};
+
+CWCheatEngine::~CWCheatEngine() {
+}
+
+static bool IsConditionalOp(CheatOp op) {
+	switch (op) {
+	case CheatOp::IfEqual:
+	case CheatOp::IfNotEqual:
+	case CheatOp::IfLess:
+	case CheatOp::IfGreater:
+	case CheatOp::IfPressed:
+	case CheatOp::IfNotPressed:
+	case CheatOp::IfAddrEqual:
+	case CheatOp::IfAddrNotEqual:
+	case CheatOp::IfAddrLess:
+	case CheatOp::IfAddrGreater:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void CWCheatEngine::Compile() {
+	program_.reset(new CheatProgram());
+	std::vector<CheatInstruction> &code = program_->code;
+
+	struct DecodedOp {
+		size_t line;
+		size_t next;
+		size_t branch;
+		CheatOperation op;
+	};
+
+	for (const CheatCode &cheat : cheats_) {
+		const size_t numLines = cheat.lines.size();
+		const size_t lineBase = program_->lines.size();
+		program_->lines.insert(program_->lines.end(), cheat.lines.begin(), cheat.lines.end());
+
+		// Skips count lines, and may land in the middle of a multi-line op, so decode an op at
+		// every line execution can reach: the fall through and the target of each skip.
+		std::vector<DecodedOp> decoded;
+		std::vector<bool> seen(numLines, false);
+		std::vector<size_t> pending;
+		pending.push_back(0);
+		while (!pending.empty()) {
+			size_t line = pending.back();
+			pending.pop_back();
+			if (line >= numLines || seen[line])
+				continue;
+			seen[line] = true;
+
+			DecodedOp d;
+			d.line = line;
+			d.next = line;
+			d.op = InterpretNextOp(cheat, d.next);
+			d.branch = numLines;
+			if (d.op.op == CheatOp::CwCheatPointerCommands) {
+				// These read their extra lines while executing.
+				if (d.op.pointerCommands.count > 0)
+					d.next += d.op.pointerCommands.count;
+			} else if (IsConditionalOp(d.op.op)) {
+				bool addrType = d.op.op >= CheatOp::IfAddrEqual && d.op.op <= CheatOp::IfAddrGreater;
+				d.branch = d.next + (size_t)(addrType ? d.op.ifAddrTypes.skip : d.op.ifTypes.skip);
+				pending.push_back(d.branch);
+			}
+			if (d.op.op != CheatOp::Invalid)
+				pending.push_back(d.next);
+			decoded.push_back(d);
+		}
+
+		std::sort(decoded.begin(), decoded.end(), [](const DecodedOp &a, const DecodedOp &b) {
+			return a.line < b.line;
+		});
+
+		// Resolve line numbers to instruction indices.  Anything past the last line ends the cheat.
+		const uint32_t base = (uint32_t)code.size();
+		const uint32_t end = base + (uint32_t)decoded.size();
+		std::vector<uint32_t> lineToInstr(numLines, end);
+		for (size_t n = 0; n < decoded.size(); ++n)
+			lineToInstr[decoded[n].line] = base + (uint32_t)n;
+		auto resolve = [&](size_t line) {
+			return line < numLines ? lineToInstr[line] : end;
+		};
+
+		for (const DecodedOp &d : decoded) {
+			CheatInstruction inst;
+			inst.op = d.op;
+			inst.next = resolve(d.next);
+			inst.branch = resolve(d.branch);
+			inst.extraLines = d.op.op == CheatOp::CwCheatPointerCommands ? (uint32_t)(lineBase + d.line + 2) : 0;
+			code.push_back(inst);
+		}
+	}
+}
+
 void CWCheatEngine::ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t)) {
 	if (Memory::IsValidAddress(op.addr)) {
 		InvalidateICache(op.addr, 4);
@@ -850,11 +959,10 @@ bool CWCheatEngine::TestIfAddr(const CheatOperation &op, bool(*oper)(int, int))
 	return false;
 }
 
-void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat, size_t &i) {
+bool CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatLine *extraLines) {
 	switch (op.op) {
 	case CheatOp::Invalid:
-		i = cheat.lines.size();
-		break;
+		return false;
 
 	case CheatOp::Noop:
 		break;
@@ -1003,58 +1111,34 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 		if (Memory::IsValidAddress(op.addr)) {
 			InvalidateICache(op.addr, 4);
 			if (Memory::Read_U32(op.addr) != op.val) {
-				i = cheat.lines.size();
+				return false;
 			}
 		}
 		break;
 
 	case CheatOp::IfEqual:
-		if (!TestIf(op, [](int a, int b) { return a == b; })) {
-			i += (size_t)op.ifTypes.skip;
-		}
-		break;
+		return TestIf(op, [](int a, int b) { return a == b; });
 
 	case CheatOp::IfNotEqual:
-		if (!TestIf(op, [](int a, int b) { return a != b; })) {
-			i += (size_t)op.ifTypes.skip;
-		}
-		break;
+		return TestIf(op, [](int a, int b) { return a != b; });
 
 	case CheatOp::IfLess:
-		if (!TestIf(op, [](int a, int b) { return a < b; })) {
-			i += (size_t)op.ifTypes.skip;
-		}
-		break;
+		return TestIf(op, [](int a, int b) { return a < b; });
 
 	case CheatOp::IfGreater:
-		if (!TestIf(op, [](int a, int b) { return a > b; })) {
-			i += (size_t)op.ifTypes.skip;
-		}
-		break;
+		return TestIf(op, [](int a, int b) { return a > b; });
 
 	case CheatOp::IfAddrEqual:
-		if (!TestIfAddr(op, [](int a, int b) { return a == b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
-		}
-		break;
+		return TestIfAddr(op, [](int a, int b) { return a == b; });
 
 	case CheatOp::IfAddrNotEqual:
-		if (!TestIfAddr(op, [](int a, int b) { return a != b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
-		}
-		break;
+		return TestIfAddr(op, [](int a, int b) { return a != b; });
 
 	case CheatOp::IfAddrLess:
-		if (!TestIfAddr(op, [](int a, int b) { return a < b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
-		}
-		break;
+		return TestIfAddr(op, [](int a, int b) { return a < b; });
 
 	case CheatOp::IfAddrGreater:
-		if (!TestIfAddr(op, [](int a, int b) { return a > b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
-		}
-		break;
+		return TestIfAddr(op, [](int a, int b) { return a > b; });
 
 	case CheatOp::IfPressed:
 		// Button	Code
@@ -1078,16 +1162,10 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 		// VOLUME DOWN	0x00200000
 		// SCREEN	0x00400000
 		// NOTE		0x00800000
-		if ((__CtrlPeekButtons() & op.val) != op.val) {
-			i += (size_t)op.ifTypes.skip;
-		}
-		break;
+		return (__CtrlPeekButtons() & op.val) == op.val;
 
 	case CheatOp::IfNotPressed:
-		if ((__CtrlPeekButtons() & op.val) == op.val) {
-			i += (size_t)op.ifTypes.skip;
-		}
-		break;
+		return (__CtrlPeekButtons() & op.val) != op.val;
 
 	case CheatOp::CwCheatPointerCommands:
 		{
@@ -1096,7 +1174,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 			u32 val = op.val;
 			int type = op.pointerCommands.type;
 			for (int a = 0; a < op.pointerCommands.count; ++a) {
-				const CheatLine &line = cheat.lines[i++];
+				const CheatLine &line = extraLines[a];
 				switch (line.part1 >> 28) {
 				case 0x1: // type copy byte
 					{
@@ -1185,15 +1263,19 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 	default:
 		_assert_(false);
 	}
+	return true;
 }
 
 void CWCheatEngine::Run() {
-	for (CheatCode cheat : cheats_) {
-		// InterpretNextOp and ExecuteOp move i.
-		for (size_t i = 0; i < cheat.lines.size(); ) {
-			CheatOperation op = InterpretNextOp(cheat, i);
-			ExecuteOp(op, cheat, i);
-		}
+	if (!program_)
+		return;
+
+	// Cheats are laid out back to back, and jumps only go forward.
+	const std::vector<CheatInstruction> &code = program_->code;
+	const CheatLine *lines = program_->lines.data();
+	for (uint32_t pc = 0; pc < code.size(); ) {
+		const CheatInstruction &inst = code[pc];
+		pc = ExecuteOp(inst.op, lines + inst.extraLines) ? inst.next : inst.branch;
 	}
 }
 
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -43,10 +44,12 @@ struct CheatFileInfo {
 };
 
 struct CheatOperation;
+struct CheatProgram;
 
 class CWCheatEngine {
 public:
 	CWCheatEngine(const std::string &gameID);
+	~CWCheatEngine();
 	std::vector<CheatFileInfo> FileInfo();
 	void ParseCheats();
 	void CreateCheatFile();
@@ -60,13 +63,16 @@ class CWCheatEngine {
 	CheatOperation InterpretNextOp(const CheatCode &cheat, size_t &i);
 	CheatOperation InterpretNextCwCheat(const CheatCode &cheat, size_t &i);
 	CheatOperation InterpretNextTempAR(const CheatCode &cheat, size_t &i);
+	void Compile();
 
-	void ExecuteOp(const CheatOperation &op, const CheatCode &cheat, size_t &i);
+	bool ExecuteOp(const CheatOperation &op, const CheatLine *extraLines);
 	void ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t));
 	bool TestIf(const CheatOperation &op, bool(*oper)(int a, int b));
 	bool TestIfAddr(const CheatOperation &op, bool(*oper)(int a, int b));
 
 	std::vector<CheatCode> cheats_;
+	// Decoded form of cheats_, rebuilt by ParseCheats() and executed by Run().
+	std::unique_ptr<CheatProgram> program_;
 	std::string gameID_;
 	Path filename_;
 };
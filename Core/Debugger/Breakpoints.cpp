@@ -20,17 +20,22 @@
 #include <mutex>
 
 #include "Common/Log.h"
+#include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Host.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/CoreTiming.h"
+#include "Core/System.h"
 
 std::atomic<bool> anyMemChecks_(false);
+// Memchecks are caught by page protection (MemFault.cpp) rather than by the jit.
+static std::atomic<bool> memChecksProtected_(false);
 
 static std::mutex breakPointsMutex_;
 std::vector<BreakPoint> CBreakPoints::breakPoints_;
@@ -395,6 +400,7 @@ void CBreakPoints::AddMemCheck(u32 start, u32 end, MemCheckCondition cond, Break
 		memChecks_.push_back(check);
 		anyMemChecks_ = true;
 		guard.unlock();
+		UpdateMemCheckProtection();
 		Update();
 	}
 	else
@@ -403,6 +409,7 @@ void CBreakPoints::AddMemCheck(u32 start, u32 end, MemCheckCondition cond, Break
 		memChecks_[mc].result = (BreakAction)(memChecks_[mc].result | result);
 		anyMemChecks_ = true;
 		guard.unlock();
+		UpdateMemCheckProtection();
 		Update();
 	}
 }
@@ -419,6 +426,7 @@ void CBreakPoints::RemoveMemCheck(u32 start, u32 end)
 		memChecks_.erase(memChecks_.begin() + mc);
 		anyMemChecks_ = !memChecks_.empty();
 		guard.unlock();
+		UpdateMemCheckProtection();
 		Update();
 	}
 }
@@ -432,6 +440,7 @@ void CBreakPoints::ChangeMemCheck(u32 start, u32 end, MemCheckCondition cond, Br
 		memChecks_[mc].cond = cond;
 		memChecks_[mc].result = result;
 		guard.unlock();
+		UpdateMemCheckProtection();
 		Update();
 	}
 }
@@ -446,6 +455,7 @@ void CBreakPoints::ClearAllMemChecks()
 	{
 		memChecks_.clear();
 		guard.unlock();
+		UpdateMemCheckProtection();
 		Update();
 	}
 }
@@ -597,6 +607,8 @@ u32 CBreakPoints::CheckSkipFirst()
 
 const std::vector<MemCheck> CBreakPoints::GetMemCheckRanges(bool write) {
 	std::lock_guard<std::mutex> guard(memCheckMutex_);
+	if (memChecksProtected_)
+		return std::vector<MemCheck>();
 	std::vector<MemCheck> ranges = memChecks_;
 	for (const auto &check : memChecks_) {
 		if (!(check.cond & MEMCHECK_READ) && !write)
@@ -630,7 +642,23 @@ const std::vector<BreakPoint> CBreakPoints::GetBreakpoints()
 bool CBreakPoints::HasMemChecks()
 {
 	std::lock_guard<std::mutex> guard(memCheckMutex_);
-	return !memChecks_.empty();
+	return !memChecks_.empty() && !memChecksProtected_;
+}
+
+static bool CanUseMemCheckPageProtection()
+{
+	// Only native jits with fast memory access RAM directly from jitted code.  The interpreter, IR,
+	// and slow memory paths access it from host code, where a fault can't be told apart from HLE.
+	return g_Config.bMemCheckPageProtect && g_Config.bFastMemory && PSP_CoreParameter().cpuCore == CPUCore::JIT;
+}
+
+void CBreakPoints::UpdateMemCheckProtection()
+{
+	std::vector<MemCheck> checks = GetMemChecks();
+	bool protect = CanUseMemCheckPageProtection() && !checks.empty() && Memory::MemFault_ProtectWatchpoints(checks);
+	if (!protect)
+		Memory::MemFault_UnprotectWatchpoints();
+	memChecksProtected_ = protect;
 }
 
 void CBreakPoints::Update(u32 addr)
@@ -167,7 +167,11 @@ class CBreakPoints
 	static const std::vector<MemCheck> GetMemChecks();
 	static const std::vector<BreakPoint> GetBreakpoints();
 
+	// Whether jitted code has to check memchecks itself, false when page protection catches them.
 	static bool HasMemChecks();
+	// Moves memchecks to page protection if enabled and possible, see MemFault.h.
+	// Call again when the cpu core or fast memory setting changes.
+	static void UpdateMemCheckProtection();
 
 	static void Update(u32 addr = 0);
 
@@ -15,11 +15,20 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include <cstring>
 
 #include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/Config.h"
@@ -75,18 +84,78 @@ struct PendingNotifyMem {
 	MemBlockFlags flags;
 	uint32_t start;
 	uint32_t size;
+	uint32_t tagId;
 	uint64_t ticks;
 	uint32_t pc;
-	char tag[128];
 };
 
-static constexpr size_t MAX_PENDING_NOTIFIES = 512;
+// Per thread cache of interned tags, so the common case doesn't need tagMutex.
+struct TagCacheEntry {
+	uint32_t generation;
+	uint32_t hash;
+	uint32_t id;
+	uint32_t length;
+	char text[128];
+};
+
+// Only the owning thread pushes, and only the holder of drainMutex pops.
+struct NotifyBuffer {
+	static constexpr uint32_t CAPACITY = 1024;
+	static constexpr uint32_t TAG_CACHE_SIZE = 32;
+
+	PendingNotifyMem items[CAPACITY];
+	std::atomic<uint32_t> head{ 0 };
+	std::atomic<uint32_t> tail{ 0 };
+	// Set when the owning thread exits, so the buffer can be freed once drained.
+	std::atomic<bool> orphaned{ false };
+	TagCacheEntry tagCache[TAG_CACHE_SIZE]{};
+};
+
+#if PPSSPP_PLATFORM(IOS) && defined(__IPHONE_OS_VERSION_MIN_REQUIRED) && __IPHONE_OS_VERSION_MIN_REQUIRED < __IPHONE_9_0
+// iOS did not support C++ thread_local before iOS 9, so all threads share one buffer there.
+#define MEMINFO_SHARED_BUFFER
+#endif
+
+static constexpr size_t MAX_TAGS = 65536;
 static MemSlabMap allocMap;
 static MemSlabMap suballocMap;
 static MemSlabMap writeMap;
 static MemSlabMap textureMap;
-static std::vector<PendingNotifyMem> pendingNotifies;
-static std::mutex pendingMutex;
+// Held while touching the slab maps or consuming from the notify buffers.
+static std::mutex drainMutex;
+static std::vector<PendingNotifyMem> drainBatch;
+static std::vector<const char *> drainTags;
+
+static std::mutex buffersMutex;
+static std::vector<NotifyBuffer *> notifyBuffers;
+#ifdef MEMINFO_SHARED_BUFFER
+static std::mutex sharedBufferMutex;
+static NotifyBuffer *sharedBuffer;
+#else
+struct NotifyBufferOwner {
+	~NotifyBufferOwner() {
+		if (buffer)
+			buffer->orphaned.store(true, std::memory_order_release);
+	}
+
+	NotifyBuffer *buffer = nullptr;
+};
+static thread_local NotifyBufferOwner threadBuffer;
+#endif
+
+static std::mutex tagMutex;
+static std::unordered_map<std::string, uint32_t> tagIds;
+static std::vector<std::unique_ptr<char[]>> tagNames;
+static std::atomic<uint32_t> tagGeneration(1);
+static bool tagOverflowLogged;
+
+static std::thread drainThread;
+static std::mutex drainThreadMutex;
+static std::condition_variable drainThreadCond;
+static bool drainThreadRunning;
+static bool drainThreadWake;
+
+static std::atomic<bool> memInfoEnabled(true);
 static int detailedOverride;
 
 MemSlabMap::MemSlabMap() {
@@ -339,30 +408,176 @@ void MemSlabMap::FillHeads(Slab *slab) {
 	}
 }
 
-void FlushPendingMemInfo() {
-	std::lock_guard<std::mutex> guard(pendingMutex);
-	for (auto info : pendingNotifies) {
-		if (info.flags & MemBlockFlags::ALLOC) {
-			allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		} else if (info.flags & MemBlockFlags::FREE) {
-			// Maintain the previous allocation tag for debugging.
-			allocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
-			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
-		}
-		if (info.flags & MemBlockFlags::SUB_ALLOC) {
-			suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		} else if (info.flags & MemBlockFlags::SUB_FREE) {
-			// Maintain the previous allocation tag for debugging.
-			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+static void ApplyNotify(const PendingNotifyMem &info, const char *tag) {
+	if (info.flags & MemBlockFlags::ALLOC) {
+		allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, tag);
+	} else if (info.flags & MemBlockFlags::FREE) {
+		// Maintain the previous allocation tag for debugging.
+		allocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+		suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+	}
+	if (info.flags & MemBlockFlags::SUB_ALLOC) {
+		suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, tag);
+	} else if (info.flags & MemBlockFlags::SUB_FREE) {
+		// Maintain the previous allocation tag for debugging.
+		suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+	}
+	if (info.flags & MemBlockFlags::TEXTURE) {
+		textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, tag);
+	}
+	if (info.flags & MemBlockFlags::WRITE) {
+		writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, tag);
+	}
+}
+
+// Must hold drainMutex.  When apply is false, pending notifications are discarded.
+static void DrainNotifyBuffers(bool apply) {
+	{
+		std::lock_guard<std::mutex> guard(buffersMutex);
+		for (size_t i = 0; i < notifyBuffers.size(); ) {
+			NotifyBuffer *buffer = notifyBuffers[i];
+			// Check this first, so nothing can be pushed after we've emptied it.
+			bool orphaned = buffer->orphaned.load(std::memory_order_acquire);
+			uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+			uint32_t head = buffer->head.load(std::memory_order_acquire);
+			if (apply) {
+				for (; tail != head; ++tail)
+					drainBatch.push_back(buffer->items[tail & (NotifyBuffer::CAPACITY - 1)]);
+			}
+			buffer->tail.store(head, std::memory_order_release);
+
+			if (orphaned) {
+				delete buffer;
+				notifyBuffers.erase(notifyBuffers.begin() + i);
+			} else {
+				++i;
+			}
 		}
-		if (info.flags & MemBlockFlags::TEXTURE) {
-			textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
+	}
+
+	if (drainBatch.empty())
+		return;
+
+	// Names are only freed under drainMutex, so these stay valid after unlocking.
+	drainTags.resize(drainBatch.size());
+	{
+		std::lock_guard<std::mutex> guard(tagMutex);
+		for (size_t i = 0; i < drainBatch.size(); ++i) {
+			uint32_t id = drainBatch[i].tagId;
+			drainTags[i] = id < tagNames.size() ? tagNames[id].get() : "";
 		}
-		if (info.flags & MemBlockFlags::WRITE) {
-			writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
+	}
+
+	for (size_t i = 0; i < drainBatch.size(); ++i)
+		ApplyNotify(drainBatch[i], drainTags[i]);
+	drainBatch.clear();
+}
+
+void FlushPendingMemInfo() {
+	std::lock_guard<std::mutex> guard(drainMutex);
+	DrainNotifyBuffers(true);
+}
+
+static void DrainThread() {
+	SetCurrentThreadName("MemBlockInfo");
+
+	std::unique_lock<std::mutex> guard(drainThreadMutex);
+	while (drainThreadRunning) {
+		drainThreadCond.wait_for(guard, std::chrono::milliseconds(100), [] {
+			return drainThreadWake || !drainThreadRunning;
+		});
+		drainThreadWake = false;
+
+		guard.unlock();
+		FlushPendingMemInfo();
+		guard.lock();
+	}
+}
+
+static void WakeDrainThread() {
+	{
+		std::lock_guard<std::mutex> guard(drainThreadMutex);
+		drainThreadWake = true;
+	}
+	drainThreadCond.notify_one();
+}
+
+static uint32_t InternTag(NotifyBuffer *buffer, const char *tagStr, size_t length) {
+	if (length >= sizeof(TagCacheEntry::text)) {
+		length = sizeof(TagCacheEntry::text) - 1;
+	}
+
+	// FNV-1a, tags are short.
+	uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < length; ++i)
+		hash = (hash ^ (uint8_t)tagStr[i]) * 16777619U;
+
+	uint32_t generation = tagGeneration.load(std::memory_order_acquire);
+	TagCacheEntry &entry = buffer->tagCache[hash & (NotifyBuffer::TAG_CACHE_SIZE - 1)];
+	if (entry.generation == generation && entry.hash == hash && entry.length == length && memcmp(entry.text, tagStr, length) == 0)
+		return entry.id;
+
+	uint32_t id;
+	{
+		std::lock_guard<std::mutex> guard(tagMutex);
+		std::string tag(tagStr, length);
+		auto it = tagIds.find(tag);
+		if (it != tagIds.end()) {
+			id = it->second;
+		} else if (tagNames.size() < MAX_TAGS) {
+			id = (uint32_t)tagNames.size();
+			char *text = new char[length + 1];
+			memcpy(text, tagStr, length);
+			text[length] = 0;
+			tagNames.push_back(std::unique_ptr<char[]>(text));
+			tagIds[tag] = id;
+		} else {
+			if (!tagOverflowLogged) {
+				WARN_LOG(SYSTEM, "Too many unique memory tags, dropping new ones");
+				tagOverflowLogged = true;
+			}
+			// Out of range ids resolve to no tag.
+			return (uint32_t)MAX_TAGS;
 		}
 	}
-	pendingNotifies.clear();
+
+	entry.generation = generation;
+	entry.hash = hash;
+	entry.id = id;
+	entry.length = (uint32_t)length;
+	memcpy(entry.text, tagStr, length);
+	return id;
+}
+
+static void QueueNotify(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tagStr, size_t strLength) {
+#ifdef MEMINFO_SHARED_BUFFER
+	std::lock_guard<std::mutex> guard(sharedBufferMutex);
+	NotifyBuffer *&buffer = sharedBuffer;
+#else
+	NotifyBuffer *&buffer = threadBuffer.buffer;
+#endif
+	if (!buffer) {
+		buffer = new NotifyBuffer();
+		std::lock_guard<std::mutex> buffersGuard(buffersMutex);
+		notifyBuffers.push_back(buffer);
+	}
+
+	PendingNotifyMem info{ flags, start, size, InternTag(buffer, tagStr, strLength) };
+	info.ticks = CoreTiming::GetTicks();
+	info.pc = pc;
+
+	uint32_t head = buffer->head.load(std::memory_order_relaxed);
+	uint32_t used = head - buffer->tail.load(std::memory_order_acquire);
+	if (used >= NotifyBuffer::CAPACITY) {
+		// The drain thread is behind (or not running), so do its work rather than grow.
+		FlushPendingMemInfo();
+		used = 0;
+	}
+	buffer->items[head & (NotifyBuffer::CAPACITY - 1)] = info;
+	buffer->head.store(head + 1, std::memory_order_release);
+
+	if (used + 1 == NotifyBuffer::CAPACITY / 2)
+		WakeDrainThread();
 }
 
 void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tagStr, size_t strLength) {
@@ -372,27 +587,9 @@ void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_
 	// Clear the uncached and kernel bits.
 	start &= ~0xC0000000;
 
-	bool needFlush = false;
 	// When the setting is off, we skip smaller info to keep things fast.
-	if (size >= 0x100 || MemBlockInfoDetailed()) {
-		PendingNotifyMem info{ flags, start, size };
-		info.ticks = CoreTiming::GetTicks();
-		info.pc = pc;
-
-		size_t copyLength = strLength;
-		if (copyLength >= sizeof(info.tag)) {
-			copyLength = sizeof(info.tag) - 1;
-		}
-		memcpy(info.tag, tagStr, copyLength);
-		info.tag[copyLength] = 0;
-
-		std::lock_guard<std::mutex> guard(pendingMutex);
-		pendingNotifies.push_back(info);
-		needFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES;
-	}
-
-	if (needFlush) {
-		FlushPendingMemInfo();
+	if (memInfoEnabled.load(std::memory_order_relaxed) && (size >= 0x100 || MemBlockInfoDetailed())) {
+		QueueNotify(flags, start, size, pc, tagStr, strLength);
 	}
 
 	if (!(flags & MemBlockFlags::SKIP_MEMCHECK)) {
@@ -409,9 +606,11 @@ void NotifyMemInfo(MemBlockFlags flags, uint32_t start, uint32_t size, const cha
 }
 
 std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
-	FlushPendingMemInfo();
 	start &= ~0xC0000000;
 
+	std::lock_guard<std::mutex> guard(drainMutex);
+	DrainNotifyBuffers(true);
+
 	std::vector<MemBlockInfo> results;
 	allocMap.Find(MemBlockFlags::ALLOC, start, size, results);
 	suballocMap.Find(MemBlockFlags::SUB_ALLOC, start, size, results);
@@ -421,9 +620,11 @@ std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 }
 
 std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start, uint32_t size) {
-	FlushPendingMemInfo();
 	start &= ~0xC0000000;
 
+	std::lock_guard<std::mutex> guard(drainMutex);
+	DrainNotifyBuffers(true);
+
 	std::vector<MemBlockInfo> results;
 	if (flags & MemBlockFlags::ALLOC)
 		allocMap.Find(MemBlockFlags::ALLOC, start, size, results);
@@ -437,6 +638,10 @@ std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start,
 }
 
 std::string GetMemWriteTagAt(uint32_t start, uint32_t size) {
+	if (!memInfoEnabled.load(std::memory_order_relaxed)) {
+		return "none";
+	}
+
 	std::vector<MemBlockInfo> memRangeInfo = FindMemInfoByFlag(MemBlockFlags::WRITE, start, size);
 	for (auto range : memRangeInfo) {
 		return range.tag;
@@ -450,18 +655,50 @@ std::string GetMemWriteTagAt(uint32_t start, uint32_t size) {
 	return "none";
 }
 
+static void UpdateMemInfoEnabled() {
+	memInfoEnabled = g_Config.bDebugMemInfo || detailedOverride != 0;
+}
+
 void MemBlockInfoInit() {
-	std::lock_guard<std::mutex> guard(pendingMutex);
-	pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
+	UpdateMemInfoEnabled();
+
+	{
+		std::lock_guard<std::mutex> guard(drainMutex);
+		drainBatch.reserve(NotifyBuffer::CAPACITY);
+		drainTags.reserve(NotifyBuffer::CAPACITY);
+	}
+
+	// Without the thread, producers drain on their own when their buffer fills.
+	if (memInfoEnabled && !drainThread.joinable()) {
+		drainThreadRunning = true;
+		drainThreadWake = false;
+		drainThread = std::thread(&DrainThread);
+	}
 }
 
 void MemBlockInfoShutdown() {
-	std::lock_guard<std::mutex> guard(pendingMutex);
+	if (drainThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> guard(drainThreadMutex);
+			drainThreadRunning = false;
+		}
+		drainThreadCond.notify_one();
+		drainThread.join();
+	}
+
+	std::lock_guard<std::mutex> guard(drainMutex);
+	DrainNotifyBuffers(false);
 	allocMap.Reset();
 	suballocMap.Reset();
 	writeMap.Reset();
 	textureMap.Reset();
-	pendingNotifies.clear();
+
+	std::lock_guard<std::mutex> tagGuard(tagMutex);
+	tagIds.clear();
+	tagNames.clear();
+	tagOverflowLogged = false;
+	// Invalidates the per thread tag caches.
+	tagGeneration++;
 }
 
 void MemBlockInfoDoState(PointerWrap &p) {
@@ -469,7 +706,8 @@ void MemBlockInfoDoState(PointerWrap &p) {
 	if (!s)
 		return;
 
-	FlushPendingMemInfo();
+	std::lock_guard<std::mutex> guard(drainMutex);
+	DrainNotifyBuffers(true);
 	allocMap.DoState(p);
 	suballocMap.DoState(p);
 	writeMap.DoState(p);
@@ -479,10 +717,12 @@ void MemBlockInfoDoState(PointerWrap &p) {
 // Used by the debugger.
 void MemBlockOverrideDetailed() {
 	detailedOverride++;
+	UpdateMemInfoEnabled();
 }
 
 void MemBlockReleaseDetailed() {
 	detailedOverride--;
+	UpdateMemInfoEnabled();
 }
 
 bool MemBlockInfoDetailed() {
@@ -16,6 +16,8 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 
 #include "Common/Common.h"
 #include "Common/Log.h"
@@ -30,6 +32,7 @@ HTTPFileLoader::HTTPFileLoader(const ::Path &filename)
 void HTTPFileLoader::Prepare() {
 	std::call_once(preparedFlag_, [this](){
 		client_.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		client_.SetKeepAlive(true);
 
 		std::vector<std::string> responseHeaders;
 		Url resourceURL = url_;
@@ -102,8 +105,18 @@ void HTTPFileLoader::Prepare() {
 			}
 		}
 
-		// TODO: Keepalive instead.
-		Disconnect();
+		// Reuse the connection for the range requests, unless the server wants to close it.
+		std::string connection;
+		keepAlive_ = acceptsRange;
+		if (http::GetHeaderValue(responseHeaders, "Connection", &connection)) {
+			std::transform(connection.begin(), connection.end(), connection.begin(), tolower);
+			if (connection.find("close") != connection.npos)
+				keepAlive_ = false;
+		}
+		if (!keepAlive_) {
+			client_.SetKeepAlive(false);
+			Disconnect();
+		}
 
 		if (!acceptsRange) {
 			WARN_LOG(LOADER, "HTTP server did not advertise support for range requests.");
@@ -146,8 +159,8 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 		return -400;
 	}
 
-	net::Buffer readbuf;
-	return client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	readbuf_.clear();
+	return client_.ReadResponseHeaders(&readbuf_, responseHeaders, &progress_);
 }
 
 HTTPFileLoader::~HTTPFileLoader() {
@@ -187,76 +200,229 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
+	s64 firstBlock = absolutePos >> BLOCK_SHIFT;
+	s64 lastBlock = (absoluteEnd - 1) >> BLOCK_SHIFT;
+	TrackAccess(absolutePos, absoluteEnd);
+
+	for (int attempt = 0; attempt < 3; ++attempt) {
+		if (FetchBlocks(firstBlock, lastBlock) || cancel_)
+			break;
+		Disconnect();
+		// Servers drop idle connections, so first just reconnect.  If that fails too, stop pipelining.
+		if (attempt == 1 && keepAlive_) {
+			WARN_LOG(LOADER, "HTTP keep-alive requests failed, falling back to a connection per request");
+			keepAlive_ = false;
+			client_.SetKeepAlive(false);
+		}
+	}
+
+	// Let's take anything we got anyway.  Not worse than returning nothing?
+	size_t readBytes = CopyFromBlocks(absolutePos, absoluteEnd, (u8 *)data);
+	TrimBlocks(absolutePos, absoluteEnd);
+	filepos_ = absolutePos + readBytes;
+	return readBytes;
+}
+
+bool HTTPFileLoader::HasBlock(s64 block) const {
+	return blocks_.find(block) != blocks_.end();
+}
+
+void HTTPFileLoader::TrackAccess(s64 pos, s64 end) {
+	if (lastReadEnd_ >= 0 && pos >= lastReadEnd_ && pos <= lastReadEnd_ + BLOCK_SIZE) {
+		// Continues where the last read stopped (give or take a skipped sector.)
+		sequentialReads_ = std::min(sequentialReads_ + 1, 8);
+		lastReadEnd_ = end;
+	} else if (lastReadEnd_ >= 0 && pos < lastReadEnd_ && pos >= lastReadEnd_ - BLOCK_SIZE) {
+		// Re-reading the tail, as sector reads often do.  Don't lose the streak.
+		lastReadEnd_ = std::max(lastReadEnd_, end);
+	} else {
+		sequentialReads_ = 0;
+		prefetchEnd_ = 0;
+		lastReadEnd_ = end;
+	}
+}
+
+bool HTTPFileLoader::RequestRange(s64 pos, s64 end) {
 	Connect();
 	if (!connected_) {
-		return 0;
+		return false;
 	}
 
 	char requestHeaders[4096];
 	// Note that the Range header is *inclusive*.
 	snprintf(requestHeaders, sizeof(requestHeaders),
-		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
+		"Range: bytes=%lld-%lld\r\n", pos, end - 1);
 
 	http::RequestParams req(url_.Resource(), "*/*");
 	int err = client_.SendRequest("GET", req, requestHeaders, &progress_);
 	if (err < 0) {
 		latestError_ = "Invalid response reading data";
 		Disconnect();
-		return 0;
+		return false;
 	}
 
-	net::Buffer readbuf;
+	pending_.push_back({ pos, end });
+	return true;
+}
+
+bool HTTPFileLoader::ReadNextResponse() {
+	PendingRange range = pending_.front();
+	pending_.pop_front();
+
 	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	int code = client_.ReadResponseHeaders(&readbuf_, responseHeaders, &progress_);
 	if (code != 206) {
 		ERROR_LOG(LOADER, "HTTP server did not respond with range, received code=%03d", code);
 		latestError_ = "Invalid response reading data";
 		Disconnect();
-		return 0;
+		return false;
 	}
 
 	// TODO: Expire cache via ETag, etc.
 	// We don't support multipart/byteranges responses.
 	bool supportedResponse = false;
+	bool closing = false;
+	s64 contentLength = -1;
 	for (std::string header : responseHeaders) {
-		if (startsWithNoCase(header, "Content-Range:")) {
+		std::string lowerHeader = header;
+		std::transform(lowerHeader.begin(), lowerHeader.end(), lowerHeader.begin(), tolower);
+		if (startsWith(lowerHeader, "content-range:")) {
 			// TODO: More correctness.  Whitespace can be missing or different.
 			s64 first = -1, last = -1, total = -1;
-			std::string lowerHeader = header;
-			std::transform(lowerHeader.begin(), lowerHeader.end(), lowerHeader.begin(), tolower);
 			if (sscanf(lowerHeader.c_str(), "content-range: bytes %lld-%lld/%lld", &first, &last, &total) >= 2) {
-				if (first == absolutePos && last == absoluteEnd - 1) {
+				if (first == range.pos && last == range.end - 1) {
 					supportedResponse = true;
 				} else {
-					ERROR_LOG(LOADER, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, absolutePos, absoluteEnd - 1);
+					ERROR_LOG(LOADER, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, range.pos, range.end - 1);
 				}
 			} else {
 				ERROR_LOG(LOADER, "Unexpected HTTP range response: %s", header.c_str());
 			}
+		} else if (startsWith(lowerHeader, "content-length:")) {
+			contentLength = atoll(lowerHeader.c_str() + strlen("content-length:"));
+		} else if (startsWith(lowerHeader, "connection:")) {
+			closing = lowerHeader.find("close") != lowerHeader.npos;
 		}
 	}
 
-	// TODO: Would be nice to read directly.
-	net::Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress_);
-	if (res != 0) {
-		ERROR_LOG(LOADER, "Unable to read HTTP response entity: %d", res);
-		// Let's take anything we got anyway.  Not worse than returning nothing?
+	if (!supportedResponse || contentLength != range.end - range.pos) {
+		ERROR_LOG(LOADER, "HTTP server did not respond with the range we wanted.");
+		latestError_ = "Invalid response reading data";
+		Disconnect();
+		return false;
 	}
 
-	// TODO: Keepalive instead.
-	Disconnect();
+	// Split straight into blocks, so a prefetched block can be handed out on its own.
+	for (s64 pos = range.pos; pos < range.end; pos += BLOCK_SIZE) {
+		std::vector<u8> block((size_t)std::min((s64)BLOCK_SIZE, range.end - pos));
+		if (client_.ReadResponseBody(&readbuf_, (char *)&block[0], block.size(), &progress_) != 0) {
+			ERROR_LOG(LOADER, "Unable to read HTTP response entity");
+			latestError_ = "Invalid response reading data";
+			Disconnect();
+			return false;
+		}
+		blocks_[pos >> BLOCK_SHIFT] = std::move(block);
+	}
 
-	if (!supportedResponse) {
-		ERROR_LOG(LOADER, "HTTP server did not respond with the range we wanted.");
-		latestError_ = "Invalid response reading data";
-		return 0;
+	if (closing || !keepAlive_) {
+		// Anything still pipelined behind this is lost, FetchBlocks() will ask again.
+		Disconnect();
 	}
+	return true;
+}
 
-	size_t readBytes = output.size();
-	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
-	return readBytes;
+bool HTTPFileLoader::FetchBlocks(s64 firstBlock, s64 lastBlock) {
+	auto isPending = [&](s64 block) {
+		s64 pos = block << BLOCK_SHIFT;
+		for (const PendingRange &range : pending_) {
+			if (pos >= range.pos && pos < range.end)
+				return true;
+		}
+		return false;
+	};
+
+	s64 missing = firstBlock;
+	while (missing <= lastBlock && (HasBlock(missing) || isPending(missing)))
+		missing++;
+
+	s64 readEnd = std::min((lastBlock + 1) << BLOCK_SHIFT, filesize_);
+	// The window doubles with each sequential read, so streaming gets up to speed quickly.
+	s64 window = sequentialReads_ == 0 ? 0 : std::min((s64)PREFETCH_BLOCKS_PER_REQUEST << (sequentialReads_ - 1), (s64)MAX_PREFETCH_BLOCKS) << BLOCK_SHIFT;
+	if (missing <= lastBlock) {
+		// One request for the rest of the read, even if parts are cached.  A round trip costs more than the bytes.
+		s64 end = readEnd;
+		if (!keepAlive_) {
+			// Can't pipeline, so just ask for more at once.
+			end = std::min(end + window, filesize_);
+		}
+		if (!RequestRange(missing << BLOCK_SHIFT, end)) {
+			return false;
+		}
+		prefetchEnd_ = std::max(prefetchEnd_, end);
+	}
+
+	// Queue up the blocks after this read while it's in flight, a request's worth at a time.
+	const s64 requestSize = (s64)PREFETCH_BLOCKS_PER_REQUEST << BLOCK_SHIFT;
+	if (keepAlive_ && window != 0 && prefetchEnd_ - readEnd <= window - requestSize) {
+		s64 pos = std::max(prefetchEnd_, readEnd);
+		s64 limit = std::min(readEnd + window, filesize_);
+		while (pos < limit) {
+			s64 end = std::min(pos + requestSize, limit);
+			if (!RequestRange(pos, end)) {
+				return false;
+			}
+			pos = end;
+		}
+		prefetchEnd_ = std::max(prefetchEnd_, pos);
+	}
+
+	for (s64 block = firstBlock; block <= lastBlock; ++block) {
+		while (!HasBlock(block)) {
+			if (pending_.empty() || !ReadNextResponse()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+size_t HTTPFileLoader::CopyFromBlocks(s64 pos, s64 end, u8 *dest) {
+	size_t copied = 0;
+	while (pos < end) {
+		auto it = blocks_.find(pos >> BLOCK_SHIFT);
+		size_t offset = (size_t)(pos & (BLOCK_SIZE - 1));
+		if (it == blocks_.end() || offset >= it->second.size()) {
+			break;
+		}
+
+		size_t len = (size_t)std::min((s64)(it->second.size() - offset), end - pos);
+		memcpy(dest + copied, &it->second[offset], len);
+		copied += len;
+		pos += len;
+	}
+	return copied;
+}
+
+void HTTPFileLoader::TrimBlocks(s64 pos, s64 end) {
+	// Whatever was read in full now lives in the caching loaders above us, no need to keep a second copy.
+	s64 firstBlock = (pos + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	for (auto it = blocks_.lower_bound(firstBlock); it != blocks_.end(); ) {
+		if ((it->first << BLOCK_SHIFT) + (s64)it->second.size() > end)
+			break;
+		it = blocks_.erase(it);
+	}
+
+	// Past that, drop whatever is furthest from where we're reading.
+	s64 current = pos >> BLOCK_SHIFT;
+	while (blocks_.size() > MAX_CACHED_BLOCKS) {
+		auto first = blocks_.begin();
+		auto last = std::prev(blocks_.end());
+		if (current - first->first > last->first - current) {
+			blocks_.erase(first);
+		} else {
+			blocks_.erase(last);
+		}
+	}
 }
 
 void HTTPFileLoader::Connect() {
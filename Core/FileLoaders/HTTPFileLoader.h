@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
 #include <mutex>
 #include <vector>
 
@@ -65,8 +67,33 @@ class HTTPFileLoader : public FileLoader {
 			client_.Disconnect();
 		}
 		connected_ = false;
+		pending_.clear();
+		readbuf_.clear();
 	}
 
+	struct PendingRange {
+		s64 pos;
+		s64 end;
+	};
+
+	bool HasBlock(s64 block) const;
+	void TrackAccess(s64 pos, s64 end);
+	bool RequestRange(s64 pos, s64 end);
+	bool ReadNextResponse();
+	bool FetchBlocks(s64 firstBlock, s64 lastBlock);
+	size_t CopyFromBlocks(s64 pos, s64 end, u8 *dest);
+	void TrimBlocks(s64 pos, s64 end);
+
+	// Same block size as CachingFileLoader and RamCachingFileLoader, so their reads line up with ours.
+	enum {
+		BLOCK_SHIFT = 16,
+		BLOCK_SIZE = 1 << BLOCK_SHIFT,
+		// Each prefetch is a separate request, so the first one arrives without waiting for the rest.
+		PREFETCH_BLOCKS_PER_REQUEST = 4,
+		MAX_PREFETCH_BLOCKS = 64,
+		MAX_CACHED_BLOCKS = 128,
+	};
+
 	s64 filesize_ = 0;
 	s64 filepos_ = 0;
 	Url url_;
@@ -75,8 +102,19 @@ class HTTPFileLoader : public FileLoader {
 	::Path filename_;
 	bool connected_ = false;
 	bool cancel_ = false;
+	// Whether the server lets us send the next request before the previous one is answered.
+	bool keepAlive_ = false;
 	const char *latestError_ = "";
 
+	// Requests that were sent but whose responses haven't been read yet, oldest first.
+	std::deque<PendingRange> pending_;
+	net::Buffer readbuf_;
+	// Blocks that were fetched ahead of (or alongside) a read, by block index.
+	std::map<s64, std::vector<u8>> blocks_;
+	s64 lastReadEnd_ = -1;
+	s64 prefetchEnd_ = 0;
+	int sequentialReads_ = 0;
+
 	std::once_flag preparedFlag_;
 	std::mutex readAtMutex_;
 };
@@ -15,7 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #include "ppsspp_config.h"
 
@@ -23,6 +25,7 @@
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/DirListing.h"
+#include "Core/Config.h"
 #include "Core/FileLoaders/LocalFileLoader.h"
 
 #if PPSSPP_PLATFORM(ANDROID)
@@ -33,6 +36,16 @@
 #include "Common/CommonWindows.h"
 #else
 #include <fcntl.h>
+#include <sys/stat.h>
+#if !PPSSPP_PLATFORM(SWITCH)
+#include <sys/mman.h>
+#endif
+#if PPSSPP_PLATFORM(LINUX) || PPSSPP_PLATFORM(ANDROID)
+#include <sys/vfs.h>
+#elif PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS) || defined(__FreeBSD__) || defined(__OpenBSD__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
 #endif
 
 #ifndef _WIN32
@@ -48,7 +61,106 @@ void LocalFileLoader::DetectSizeFd() {
 	lseek(fd_, 0, SEEK_SET);
 #endif
 }
+
+// Once reads look sequential, ask the OS to fault in this much past them.
+static const s64 MAP_READAHEAD_BYTES = 2 * 1024 * 1024;
+
+void LocalFileLoader::AdviseReadAhead(s64 pos, size_t bytes) {
+#if !PPSSPP_PLATFORM(SWITCH)
+	s64 end = pos + (s64)bytes;
+	s64 lastEnd = lastReadEnd_.exchange(end, std::memory_order_relaxed);
+	if (pos != lastEnd) {
+		// Random access, the default fault-around is enough.
+		return;
+	}
+
+	// Only advise again once the reader has used up half of the last window.
+	s64 advised = advisedEnd_.load(std::memory_order_relaxed);
+	if (end + MAP_READAHEAD_BYTES / 2 < advised) {
+		return;
+	}
+	s64 start = std::max(end, advised) & ~(s64)4095;
+	s64 stop = std::min(end + MAP_READAHEAD_BYTES, (s64)filesize_);
+	if (stop > start) {
+		madvise(map_ + start, (size_t)(stop - start), MADV_WILLNEED);
+		advisedEnd_.store(stop, std::memory_order_relaxed);
+	}
+#endif
+}
+#endif
+
+// A mapped read faults (SIGBUS, or an in-page error on Windows) on a host I/O error or if the
+// file is truncated, where read() would just come up short.  So only map regular files on fixed
+// local disks, and leave removable, network and FUSE storage to plain reads.
+bool LocalFileLoader::IsSafeToMap() {
+#if PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
+	if (GetFileType(handle_) != FILE_TYPE_DISK)
+		return false;
+	wchar_t volume[MAX_PATH];
+	if (!GetVolumePathNameW(filename_.ToWString().c_str(), volume, MAX_PATH))
+		return false;
+	return GetDriveTypeW(volume) == DRIVE_FIXED;
+#elif !PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(SWITCH)
+	struct stat st;
+	if (fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+#if PPSSPP_PLATFORM(LINUX) || PPSSPP_PLATFORM(ANDROID)
+	struct statfs fs;
+	if (fstatfs(fd_, &fs) != 0)
+		return false;
+	switch ((u32)fs.f_type) {
+	case 0xEF53:      // ext2/3/4
+	case 0x9123683E:  // btrfs
+	case 0x58465342:  // xfs
+	case 0xF2F52010:  // f2fs
+	case 0x2FC12FC1:  // zfs
+	case 0x01021994:  // tmpfs
+		return true;
+	default:
+		return false;
+	}
+#elif PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS) || defined(__FreeBSD__) || defined(__OpenBSD__)
+	struct statfs fs;
+	if (fstatfs(fd_, &fs) != 0 || (fs.f_flags & MNT_LOCAL) == 0)
+		return false;
+#ifdef MNT_REMOVABLE
+	if (fs.f_flags & MNT_REMOVABLE)
+		return false;
+#endif
+	return true;
+#else
+	return false;
+#endif
+#else
+	return false;
+#endif
+}
+
+void LocalFileLoader::MapFile() {
+	// Needs the address space to map a whole disc image, and some file systems can't map.
+	if (!g_Config.bMapLocalDiscImages || sizeof(void *) < 8 || filesize_ == 0 || filesize_ > (u64)(size_t)-1) {
+		return;
+	}
+	if (!IsSafeToMap()) {
+		VERBOSE_LOG(FILESYS, "Not mapping '%s', it's not a regular file on a fixed local disk", filename_.c_str());
+		return;
+	}
+
+#if PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
+	HANDLE mapping = CreateFileMapping(handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping) {
+		map_ = (u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (map_)
+			mapping_ = mapping;
+		else
+			CloseHandle(mapping);
+	}
+#elif !PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(SWITCH)
+	void *mapped = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+	if (mapped != MAP_FAILED)
+		map_ = (u8 *)mapped;
 #endif
+}
 
 LocalFileLoader::LocalFileLoader(const Path &filename)
 	: filesize_(0), filename_(filename) {
@@ -68,6 +180,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 		fd_ = fd;
 		isOpenedByFd_ = true;
 		DetectSizeFd();
+		// Never mapped, the provider behind the fd may be anything from a pipe to cloud storage.
 		return;
 	}
 #endif
@@ -80,6 +193,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 
 	DetectSizeFd();
+	MapFile();
 
 #else // _WIN32
 
@@ -102,15 +216,25 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 	filesize_ = end_offset.QuadPart;
 	SetFilePointerEx(handle_, zero, nullptr, FILE_BEGIN);
+	MapFile();
 #endif // _WIN32
 }
 
 LocalFileLoader::~LocalFileLoader() {
 #ifndef _WIN32
+#if !PPSSPP_PLATFORM(SWITCH)
+	if (map_) {
+		munmap(map_, (size_t)filesize_);
+	}
+#endif
 	if (fd_ != -1) {
 		close(fd_);
 	}
 #else
+	if (map_) {
+		UnmapViewOfFile(map_);
+		CloseHandle(mapping_);
+	}
 	if (handle_ != INVALID_HANDLE_VALUE) {
 		CloseHandle(handle_);
 	}
@@ -158,6 +282,19 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 		return 0;
 	}
 
+	if (map_) {
+		// Serve straight from the mapping, no syscall.  Like read(), stop at the end of the file.
+		if (absolutePos < 0 || (u64)absolutePos >= filesize_)
+			return 0;
+		size_t avail = (size_t)(filesize_ - absolutePos);
+		size_t readBytes = std::min(bytes * count, avail - avail % bytes);
+#ifndef _WIN32
+		AdviseReadAhead(absolutePos, readBytes);
+#endif
+		memcpy(data, map_ + absolutePos, readBytes);
+		return readBytes / bytes;
+	}
+
 #if PPSSPP_PLATFORM(SWITCH)
 	// Toolchain has no fancy IO API.  We must lock.
 	std::lock_guard<std::mutex> guard(readLock_);
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
 #include "Common/CommonTypes.h"
@@ -39,16 +40,37 @@ class LocalFileLoader : public FileLoader {
 		return filename_;
 	}
 	virtual size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override;
+	const u8 *MappedData() override {
+		return map_;
+	}
+
+#ifndef _WIN32
+	// For handing the file to APIs like sendfile. Don't seek it.
+	int GetFD() const {
+		return fd_;
+	}
+#endif
 
 private:
+	bool IsSafeToMap();
+	void MapFile();
 #ifndef _WIN32
 	void DetectSizeFd();
+	void AdviseReadAhead(s64 pos, size_t bytes);
 	int fd_ = -1;
 #else
 	HANDLE handle_ = 0;
+	HANDLE mapping_ = 0;
 #endif
 	u64 filesize_ = 0;
 	Path filename_;
 	std::mutex readLock_;
 	bool isOpenedByFd_ = false;
+
+	// Only used when the whole file could be mapped, see MapFile().
+	u8 *map_ = nullptr;
+#ifndef _WIN32
+	std::atomic<s64> lastReadEnd_{ -1 };
+	std::atomic<s64> advisedEnd_{ 0 };
+#endif
 };
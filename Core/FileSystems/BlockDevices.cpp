@@ -104,6 +104,10 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+const u8 *FileBlockDevice::MappedBlocks() {
+	return fileLoader_->MappedData();
+}
+
 // .CSO format
 
 // compressed ISO(9660) header format
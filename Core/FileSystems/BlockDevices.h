@@ -46,6 +46,8 @@ class BlockDevice {
 	int GetBlockSize() const { return 2048;}  // forced, it cannot be changed by subclasses
 	virtual u32 GetNumBlocks() = 0;
 	virtual bool IsDisc() = 0;
+	// Non-null when every block is already in memory, so reads can copy at any byte offset directly.
+	virtual const u8 *MappedBlocks() { return nullptr; }
 
 	u32 CalculateCRC(volatile bool *cancel = nullptr);
 	void NotifyReadError();
@@ -86,6 +88,7 @@ class FileBlockDevice : public BlockDevice {
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
 	u32 GetNumBlocks() override {return (u32)(filesize_ / GetBlockSize());}
 	bool IsDisc() override { return true; }
+	const u8 *MappedBlocks() override;
 
 private:
 	FileLoader *fileLoader_;
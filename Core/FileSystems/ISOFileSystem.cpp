@@ -24,12 +24,15 @@
 #include "Common/CommonTypes.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/TimeUtil.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/MemMap.h"
 #include "Core/Reporting.h"
 
 const int sectorSize = 2048;
+// Directories with at least this many entries get a hashed name index.
+const size_t childIndexThreshold = 16;
 
 bool parseLBN(std::string filename, u32 *sectorStart, u32 *readSize) {
 	// The format of this is: "/sce_lbn" "0x"? HEX* ANY* "_size" "0x"? HEX* ANY*
@@ -173,11 +176,17 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 }
 
 ISOFileSystem::~ISOFileSystem() {
+	if (stats_.directoriesRead != 0) {
+		INFO_LOG(FILESYS, "ISO: read %d directories (%d entries) in %0.2f ms, %d path lookups (%d hashed)", stats_.directoriesRead, stats_.entriesRead, stats_.readDirectoryTime * 1000.0, stats_.lookups, stats_.indexedLookups);
+	}
 	delete blockDevice;
 	delete treeroot;
 }
 
 void ISOFileSystem::ReadDirectory(TreeEntry *root) {
+	const double startTime = time_now_d();
+	stats_.directoriesRead++;
+
 	for (u32 secnum = root->startsector, endsector = root->startsector + (root->dirsize + 2047) / 2048; secnum < endsector; ++secnum) {
 		u8 theSector[2048];
 		if (!blockDevice->ReadBlock(secnum, theSector)) {
@@ -240,6 +249,31 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 		}
 	}
 	root->valid = true;
+
+	stats_.entriesRead += (int)root->children.size();
+	if (root->children.size() >= childIndexThreshold) {
+		root->childIndex.reserve(root->children.size());
+		for (TreeEntry *child : root->children) {
+			// Keep the first of any duplicate names, like the linear scan would.
+			root->childIndex.emplace(child->name, child);
+		}
+	}
+	stats_.readDirectoryTime += time_now_d() - startTime;
+}
+
+ISOFileSystem::TreeEntry *ISOFileSystem::FindChild(TreeEntry *dir, const std::string &name) {
+	// Names are matched exactly, case included, same with or without the index.
+	if (!dir->childIndex.empty()) {
+		stats_.indexedLookups++;
+		auto it = dir->childIndex.find(name);
+		return it != dir->childIndex.end() ? it->second : nullptr;
+	}
+
+	for (TreeEntry *child : dir->children) {
+		if (child->name == name)
+			return child;
+	}
+	return nullptr;
 }
 
 ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bool catchError) {
@@ -263,35 +297,25 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	stats_.lookups++;
 	TreeEntry *entry = treeroot;
 	while (true) {
+		// Directories are only read once something inside them is looked up.
 		if (!entry->valid) {
 			ReadDirectory(entry);
 		}
 		TreeEntry *nextEntry = nullptr;
-		std::string name = "";
 		if (pathLength > pathIndex) {
 			size_t nextSlashIndex = path.find_first_of('/', pathIndex);
 			if (nextSlashIndex == std::string::npos)
 				nextSlashIndex = pathLength;
 
-			const std::string firstPathComponent = path.substr(pathIndex, nextSlashIndex - pathIndex);
-			for (size_t i = 0; i < entry->children.size(); i++) {
-				const std::string &n = entry->children[i]->name;
-				if (firstPathComponent == n) {
-					//yay we got it
-					nextEntry = entry->children[i];
-					name = n;
-					break;
-				}
-			}
+			nextEntry = FindChild(entry, path.substr(pathIndex, nextSlashIndex - pathIndex));
 		}
-		
+
 		if (nextEntry) {
 			entry = nextEntry;
-			if (!entry->valid)
-				ReadDirectory(entry);
-			pathIndex += name.length();
+			pathIndex += entry->name.length();
 			if (pathIndex < pathLength && path[pathIndex] == '/')
 				++pathIndex;
 
@@ -512,6 +536,20 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		}
 
 		// Okay, we have size and position, let's rock.
+		const u8 *mapped = blockDevice->MappedBlocks();
+		if (mapped && size > 0 && positionOnIso + size <= (u64)blockDevice->GetNumBlocks() * 2048) {
+			// No partial sectors to bounce through theSector, copy it all at once.
+			memcpy(pointer, mapped + positionOnIso, (size_t)size);
+			u32 endSecNum = (u32)((positionOnIso + size + 2047) / 2048);
+			if (abs((int)lastReadBlock_ - (int)endSecNum) > 100) {
+				// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
+				usec = 100000;
+			}
+			lastReadBlock_ = endSecNum;
+			e.seekPos += (unsigned int)size;
+			return (size_t)size;
+		}
+
 		const int firstBlockOffset = positionOnIso & 2047;
 		const int firstBlockSize = firstBlockOffset == 0 ? 0 : (int)std::min(size, 2048LL - firstBlockOffset);
 		const int lastBlockSize = (size - firstBlockSize) & 2047;
@@ -630,6 +668,8 @@ std::vector<PSPFileInfo> ISOFileSystem::GetDirListing(std::string path) {
 	TreeEntry *entry = GetFromPath(path);
 	if (!entry)
 		return myVector;
+	if (!entry->valid)
+		ReadDirectory(entry);
 
 	const std::string dot(".");
 	const std::string dotdot("..");
@@ -20,6 +20,7 @@
 #include <map>
 #include <list>
 #include <memory>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -73,6 +74,16 @@ class ISOFileSystem : public IFileSystem {
 
 		bool valid = false;
 		std::vector<TreeEntry *> children;
+		// Only built for large directories, where scanning children gets slow.
+		std::unordered_map<std::string, TreeEntry *> childIndex;
+	};
+
+	struct Stats {
+		int directoriesRead = 0;
+		int entriesRead = 0;
+		double readDirectoryTime = 0.0;
+		int lookups = 0;
+		int indexedLookups = 0;
 	};
 
 	struct OpenFileEntry {
@@ -92,8 +103,10 @@ class ISOFileSystem : public IFileSystem {
 	u32 lastReadBlock_;
 
 	TreeEntry entireISO;
+	Stats stats_;
 
 	void ReadDirectory(TreeEntry *root);
+	TreeEntry *FindChild(TreeEntry *dir, const std::string &name);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
 	std::string EntryFullPath(TreeEntry *e);
 };
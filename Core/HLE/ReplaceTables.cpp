@@ -22,6 +22,7 @@
 
 #include "Common/Common.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
+#include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/Swap.h"
 #include "Core/Config.h"
@@ -33,6 +34,7 @@
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/HLE/ReplaceTables.h"
+#include "Core/System.h"
 #include "Core/HLE/FunctionWrappers.h"
 
 #include "GPU/Math3D.h"
@@ -423,6 +425,225 @@ static int Replace_strncmp() {
 	return 10 + bytes / 4;  // approximation
 }
 
+// Length of the string at ptr, but never reading more than maxLen or past the end of valid memory.
+static u32 ReplaceStrnlen(u32 ptr, u32 maxLen = 0xFFFFFFFF) {
+	if (!Memory::IsValidAddress(ptr)) {
+		return 0;
+	}
+	const u8 *str = Memory::GetPointerUnchecked(ptr);
+	const u32 avail = Memory::ValidSize(ptr, maxLen);
+	const u8 *end = (const u8 *)memchr(str, 0, avail);
+	return end ? (u32)(end - str) : avail;
+}
+
+static int Replace_memcmp() {
+	u32 aPtr = PARAM(0);
+	u32 bPtr = PARAM(1);
+	u32 bytes = PARAM(2);
+	int result = 0;
+	// Compare as far as both ranges are valid, and if they agree that far, the shorter one sorts first.
+	const u32 aValid = Memory::IsValidAddress(aPtr) ? Memory::ValidSize(aPtr, bytes) : 0;
+	const u32 bValid = Memory::IsValidAddress(bPtr) ? Memory::ValidSize(bPtr, bytes) : 0;
+	const u32 common = std::min(aValid, bValid);
+	bool differs = false;
+	if (common != 0) {
+		const u8 *a = Memory::GetPointerUnchecked(aPtr);
+		const u8 *b = Memory::GetPointerUnchecked(bPtr);
+		// Like newlib, return the difference of the first mismatching bytes, not just the sign.
+		auto mismatch = std::mismatch(a, a + common, b);
+		if (mismatch.first != a + common) {
+			result = (int)*mismatch.first - (int)*mismatch.second;
+			differs = true;
+		}
+	}
+	if (!differs && aValid != bValid) {
+		result = aValid < bValid ? -1 : 1;
+	}
+	RETURN(result);
+	return 10 + bytes / 4;  // approximation
+}
+
+static int Replace_memchr() {
+	u32 srcPtr = PARAM(0);
+	u8 value = PARAM(1);
+	u32 bytes = PARAM(2);
+	u32 result = 0;
+	// Callers often pass 0xFFFFFFFF as the size when they know the byte is there, so search what's valid.
+	const u32 avail = Memory::IsValidAddress(srcPtr) ? Memory::ValidSize(srcPtr, bytes) : 0;
+	if (avail != 0) {
+		const u8 *src = Memory::GetPointerUnchecked(srcPtr);
+		const u8 *found = (const u8 *)memchr(src, value, avail);
+		if (found) {
+			result = srcPtr + (u32)(found - src);
+		}
+	}
+	RETURN(result);
+	return 10 + (result ? result - srcPtr : avail) / 4;  // approximation
+}
+
+static int Replace_strnlen() {
+	u32 len = ReplaceStrnlen(PARAM(0), PARAM(1));
+	RETURN(len);
+	return 7 + len * 4;  // approximation
+}
+
+static int Replace_strchr() {
+	u32 srcPtr = PARAM(0);
+	char value = (char)PARAM(1);
+	u32 len = ReplaceStrnlen(srcPtr);
+	u32 result = 0;
+	if (Memory::IsValidAddress(srcPtr)) {
+		const char *src = (const char *)Memory::GetPointerUnchecked(srcPtr);
+		// Searching for the terminator finds it, like the real thing.
+		const char *found = value == 0 ? src + len : (const char *)memchr(src, value, len);
+		if (found && (u32)(found - src) < Memory::ValidSize(srcPtr, len + 1)) {
+			result = srcPtr + (u32)(found - src);
+		}
+	}
+	RETURN(result);
+	return 10 + len * 4;  // approximation
+}
+
+static int Replace_strrchr() {
+	u32 srcPtr = PARAM(0);
+	char value = (char)PARAM(1);
+	u32 len = ReplaceStrnlen(srcPtr);
+	u32 result = 0;
+	if (Memory::IsValidAddress(srcPtr)) {
+		const char *src = (const char *)Memory::GetPointerUnchecked(srcPtr);
+		if (value == 0) {
+			if (len < Memory::ValidSize(srcPtr, len + 1)) {
+				result = srcPtr + len;
+			}
+		} else {
+			for (u32 i = len; i > 0; --i) {
+				if (src[i - 1] == value) {
+					result = srcPtr + i - 1;
+					break;
+				}
+			}
+		}
+	}
+	RETURN(result);
+	return 10 + len * 4;  // approximation
+}
+
+static int Replace_strcat() {
+	u32 destPtr = PARAM(0);
+	u32 srcPtr = PARAM(1);
+	u32 destLen = ReplaceStrnlen(destPtr);
+	u32 srcLen = ReplaceStrnlen(srcPtr);
+	if (Memory::IsValidRange(destPtr, destLen + srcLen + 1) && Memory::IsValidRange(srcPtr, srcLen + 1)) {
+		u8 *dst = Memory::GetPointerUnchecked(destPtr + destLen);
+		memmove(dst, Memory::GetPointerUnchecked(srcPtr), srcLen + 1);
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr + destLen, srcLen + 1, "ReplaceStrcat");
+	}
+	RETURN(destPtr);
+	return 10 + (destLen + srcLen) * 4;  // approximation
+}
+
+static int ReplaceStrcasecmp(u32 aPtr, u32 bPtr, u32 maxLen) {
+	// Only reads up to the shorter string's terminator, like the real thing.
+	u32 aLen = ReplaceStrnlen(aPtr, maxLen);
+	u32 bLen = ReplaceStrnlen(bPtr, maxLen);
+	if (!Memory::IsValidAddress(aPtr) || !Memory::IsValidAddress(bPtr)) {
+		return 0;
+	}
+	const u8 *a = Memory::GetPointerUnchecked(aPtr);
+	const u8 *b = Memory::GetPointerUnchecked(bPtr);
+	auto lower = [](u8 c) -> int {
+		// The PSP's newlib is always in the C locale.
+		return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+	};
+	u32 len = std::min(std::min(aLen, bLen) + 1, maxLen);
+	for (u32 i = 0; i < len; ++i) {
+		int ac = i < aLen ? lower(a[i]) : 0;
+		int bc = i < bLen ? lower(b[i]) : 0;
+		if (ac != bc || ac == 0) {
+			return ac - bc;
+		}
+	}
+	return 0;
+}
+
+static int Replace_strcasecmp() {
+	RETURN(ReplaceStrcasecmp(PARAM(0), PARAM(1), 0xFFFFFFFF));
+	return 10;  // approximation
+}
+
+static int Replace_strncasecmp() {
+	u32 bytes = PARAM(2);
+	RETURN(ReplaceStrcasecmp(PARAM(0), PARAM(1), bytes));
+	return 10 + bytes / 4;  // approximation
+}
+
+// libgcc 64-bit division helpers, which are very slow on the PSP's 32-bit CPU.
+// The real ones deliberately trap on a zero divisor, we just return something harmless.
+static int Replace_udivdi3() {
+	u64 a = PARAM64(0);
+	u64 b = PARAM64(2);
+	RETURN64(b == 0 ? 0xFFFFFFFFFFFFFFFFULL : a / b);
+	return 40;
+}
+
+static int Replace_umoddi3() {
+	u64 a = PARAM64(0);
+	u64 b = PARAM64(2);
+	RETURN64(b == 0 ? a : a % b);
+	return 40;
+}
+
+// Soft-float double helpers. The args and results are passed in integer register pairs.
+static double ReplaceParamDouble(int n) {
+	u64 bits = PARAM64(n);
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+static void ReplaceReturnDouble(double d) {
+	u64 bits;
+	memcpy(&bits, &d, sizeof(bits));
+	RETURN64(bits);
+}
+
+static int Replace_adddf3() {
+	ReplaceReturnDouble(ReplaceParamDouble(0) + ReplaceParamDouble(2));
+	return 30;
+}
+
+static int Replace_subdf3() {
+	ReplaceReturnDouble(ReplaceParamDouble(0) - ReplaceParamDouble(2));
+	return 30;
+}
+
+static int Replace_muldf3() {
+	ReplaceReturnDouble(ReplaceParamDouble(0) * ReplaceParamDouble(2));
+	return 40;
+}
+
+static int Replace_negdf2() {
+	// Just a sign flip, even for NaNs.
+	RETURN64(PARAM64(0) ^ 0x8000000000000000ULL);
+	return 4;
+}
+
+static int Replace_extendsfdf2() {
+	u32 bits = PARAM(0);
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	ReplaceReturnDouble((double)f);
+	return 20;
+}
+
+static int Replace_truncdfsf2() {
+	float f = (float)ReplaceParamDouble(0);
+	u32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	RETURN(bits);
+	return 20;
+}
+
 static int Replace_fabsf() {
 	RETURNF(fabsf(PARAMF(0)));
 	return 4;
@@ -1319,9 +1540,8 @@ static int Hook_openseason_data_decode() {
 
 // Can either replace with C functions or functions emitted in Asm/ArmAsm.
 static const ReplacementTableEntry entries[] = {
-	// TODO: I think some games can be helped quite a bit by implementing the
-	// double-precision soft-float routines: __adddf3, __subdf3 and so on. These
-	// should of course be implemented JIT style, inline.
+	// TODO: The double-precision soft-float routines (__adddf3 and friends) could
+	// be implemented JIT style, inline.
 
 	/*  These two collide (same hash) and thus can't be replaced :/
 	{ "asinf", &Replace_asinf, 0, REPFLAG_DISABLED },
@@ -1349,6 +1569,23 @@ static const ReplacementTableEntry entries[] = {
 	{ "strncpy", &Replace_strncpy, 0, REPFLAG_DISABLED },
 	{ "strcmp", &Replace_strcmp, 0, REPFLAG_DISABLED },
 	{ "strncmp", &Replace_strncmp, 0, REPFLAG_DISABLED },
+	{ "memcmp", &Replace_memcmp, 0, REPFLAG_DISABLED },
+	{ "bcmp", &Replace_memcmp, 0, REPFLAG_DISABLED },
+	{ "memchr", &Replace_memchr, 0, REPFLAG_DISABLED },
+	{ "strnlen", &Replace_strnlen, 0, REPFLAG_DISABLED },
+	{ "strchr", &Replace_strchr, 0, REPFLAG_DISABLED },
+	{ "strrchr", &Replace_strrchr, 0, REPFLAG_DISABLED },
+	{ "strcat", &Replace_strcat, 0, REPFLAG_DISABLED },
+	{ "strcasecmp", &Replace_strcasecmp, 0, REPFLAG_DISABLED },
+	{ "strncasecmp", &Replace_strncasecmp, 0, REPFLAG_DISABLED },
+	{ "__udivdi3", &Replace_udivdi3, 0, REPFLAG_DISABLED },
+	{ "__umoddi3", &Replace_umoddi3, 0, REPFLAG_DISABLED },
+	{ "__adddf3", &Replace_adddf3, 0, REPFLAG_DISABLED },
+	{ "__subdf3", &Replace_subdf3, 0, REPFLAG_DISABLED },
+	{ "__muldf3", &Replace_muldf3, 0, REPFLAG_DISABLED },
+	{ "__negdf2", &Replace_negdf2, 0, REPFLAG_DISABLED },
+	{ "__extendsfdf2", &Replace_extendsfdf2, 0, REPFLAG_DISABLED },
+	{ "__truncdfsf2", &Replace_truncdfsf2, 0, REPFLAG_DISABLED },
 	{ "fabsf", &Replace_fabsf, JITFUNC(Replace_fabsf), REPFLAG_ALLOWINLINE | REPFLAG_DISABLED },
 	{ "dl_write_matrix", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED }, // &MIPSComp::Jit::Replace_dl_write_matrix, REPFLAG_DISABLED },
 	{ "dl_write_matrix_2", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED },
@@ -1436,6 +1673,8 @@ static const ReplacementTableEntry entries[] = {
 
 static std::map<u32, u32> replacedInstructions;
 static std::unordered_map<std::string, std::vector<int> > replacementNameLookup;
+// Sampled cycles by function start address.
+static std::unordered_map<u32, u64> funcCycleStats;
 
 void Replacement_Init() {
 	for (int i = 0; i < (int)ARRAY_SIZE(entries); i++) {
@@ -1624,3 +1863,76 @@ bool CanReplaceJalTo(u32 dest, const ReplacementTableEntry **entry, u32 *funcSiz
 	}
 	return true;
 }
+
+void Replacement_SampleCycles(u32 pc, int cycles) {
+	if (cycles <= 0 || !g_symbolMap) {
+		return;
+	}
+	// Anything outside a known function goes under INVALID_ADDRESS.
+	funcCycleStats[g_symbolMap->GetFunctionStart(pc)] += cycles;
+}
+
+void Replacement_StoreCycleStats() {
+	if (funcCycleStats.empty()) {
+		return;
+	}
+
+	struct FuncCycles {
+		u64 hash;
+		u32 size;
+		u32 start;
+		u64 cycles;
+		std::string name;
+	};
+	std::vector<FuncCycles> funcs;
+	// The same function is often linked into several modules, so merge by hash.
+	std::map<std::pair<u64, u32>, size_t> hashIndex;
+	u64 totalCycles = 0;
+	for (const auto &it : funcCycleStats) {
+		totalCycles += it.second;
+
+		MIPSAnalyst::AnalyzedFunction f;
+		const bool hashed = it.first != SymbolMap::INVALID_ADDRESS && MIPSAnalyst::GetFunctionAt(it.first, &f) && f.hasHash;
+		if (hashed) {
+			auto index = hashIndex.find(std::make_pair(f.hash, f.size));
+			if (index != hashIndex.end()) {
+				funcs[index->second].cycles += it.second;
+				continue;
+			}
+			hashIndex[std::make_pair(f.hash, f.size)] = funcs.size();
+		}
+
+		FuncCycles fc{ hashed ? f.hash : 0, hashed ? f.size : 0, it.first, it.second };
+		if (it.first == SymbolMap::INVALID_ADDRESS) {
+			fc.name = "(unknown)";
+		} else {
+			fc.name = g_symbolMap->GetLabelString(it.first);
+		}
+		funcs.push_back(fc);
+	}
+	funcCycleStats.clear();
+
+	std::sort(funcs.begin(), funcs.end(), [](const FuncCycles &a, const FuncCycles &b) {
+		return a.cycles > b.cycles;
+	});
+
+	const Path filename = GetSysDirectory(DIRECTORY_SYSTEM) / "funccycles.csv";
+	FILE *file = File::OpenCFile(filename, "wt");
+	if (!file) {
+		WARN_LOG(HLE, "Could not store function cycle stats: %s", filename.c_str());
+		return;
+	}
+
+	// Same hash:size format as knownfuncs.ini, so candidates can be copied over.
+	fprintf(file, "hash:size,name,cycles,percent,address,replaced\n");
+	for (const FuncCycles &fc : funcs) {
+		bool replaced = false;
+		if (fc.size != 0) {
+			for (int index : GetReplacementFuncIndexes(fc.hash, fc.size))
+				replaced = replaced || (entries[index].flags & REPFLAG_DISABLED) == 0;
+		}
+		fprintf(file, "%016llx:%d,%s,%llu,%.3f,%08x,%s\n", (unsigned long long)fc.hash, (int)fc.size, fc.name.c_str(), (unsigned long long)fc.cycles, 100.0 * fc.cycles / totalCycles, fc.start, replaced ? "yes" : "no");
+	}
+	fclose(file);
+	INFO_LOG(HLE, "Stored cycle stats for %d functions in %s", (int)funcs.size(), filename.c_str());
+}
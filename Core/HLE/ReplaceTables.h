@@ -72,6 +72,12 @@ void RestoreReplacedInstructions(u32 startAddr, u32 endAddr);
 bool GetReplacedOpAt(u32 address, u32 *op);
 bool CanReplaceJalTo(u32 dest, const ReplacementTableEntry **entry, u32 *funcSize);
 
+// Function cycle stats (see Config::bFuncCycleStats.) The cycles run since the last sample are
+// charged to the function containing pc, which over time shows where the time goes.
+void Replacement_SampleCycles(u32 pc, int cycles);
+// Writes the stats sorted by cycles, merged by function hash, and resets them.
+void Replacement_StoreCycleStats();
+
 // For savestates.  If you call SaveAndClearReplacements(), you must call RestoreSavedReplacements().
 std::map<u32, u32> SaveAndClearReplacements();
 void RestoreSavedReplacements(const std::map<u32, u32> &saved);
@@ -473,6 +473,10 @@ void __AudioGetDebugStats(char *buf, size_t bufSize) {
 	resampler.GetAudioDebugStats(buf, bufSize);
 }
 
+int __AudioTakeUnderrunCount() {
+	return resampler.TakeUnderrunCount();
+}
+
 void __PushExternalAudio(const s32 *audio, int numSamples) {
 	if (audio) {
 		resampler.PushSamples(audio, numSamples);
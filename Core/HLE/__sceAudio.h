@@ -48,6 +48,8 @@ void __AudioWakeThreads(AudioChannel &chan, int result);
 
 int __AudioMix(short *outstereo, int numSamples, int sampleRate);
 void __AudioGetDebugStats(char *buf, size_t bufSize);
+// Output underruns since the last call.
+int __AudioTakeUnderrunCount();
 void __PushExternalAudio(const s32 *audio, int numSamples);  // Should not be used in-game, only at the menu!
 
 // Audio Dumping stuff
@@ -52,8 +52,20 @@ extern "C" struct hostent *gethostbyname(const char *name);
 
 #include <fcntl.h>
 #include <errno.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
 //#include <sqlite3.h>
 
+#if defined(_WIN32)
+// WSAPoll takes the same pollfd layout as poll()
+#define adhocserver_poll WSAPoll
+#else
+#include <poll.h>
+#define adhocserver_poll poll
+#endif
+
 #ifndef MSG_NOSIGNAL
 // Default value to 0x00 (do nothing) in systems where it's not supported.
 #define MSG_NOSIGNAL 0x00
@@ -79,8 +91,31 @@ SceNetAdhocctlUserNode * _db_user = NULL;
 // Game Database
 SceNetAdhocctlGameNode * _db_game = NULL;
 
+// Group Index Key (Game Node + zero padded Group Name)
+struct AdhocGroupKey {
+	const SceNetAdhocctlGameNode * game;
+	uint64_t name;
+
+	bool operator==(const AdhocGroupKey &other) const {
+		return game == other.game && name == other.name;
+	}
+};
+
+struct AdhocGroupKeyHash {
+	size_t operator()(const AdhocGroupKey &key) const {
+		return std::hash<uint64_t>()(key.name) ^ (std::hash<uintptr_t>()((uintptr_t)key.game) * 31);
+	}
+};
+
+// Database Indexes (the linked lists stay authoritative, these only replace the linear searches)
+static std::unordered_map<uint32_t, SceNetAdhocctlUserNode *> _db_user_by_ip;
+static std::unordered_multimap<uint64_t, SceNetAdhocctlUserNode *> _db_user_by_mac;
+static std::unordered_map<std::string, SceNetAdhocctlGameNode *> _db_game_by_product;
+static std::unordered_map<AdhocGroupKey, SceNetAdhocctlGroupNode *, AdhocGroupKeyHash> _db_group_by_name;
+
 // Server Status
 std::atomic<bool> adhocServerRunning(false);
+std::atomic<uint16_t> adhocServerPort(0);
 std::thread adhocServerThread;
 
 // Crosslink database for cross region Adhoc play
@@ -500,6 +535,44 @@ void change_blocking_mode(int fd, int nonblocking);
 int create_listen_socket(uint16_t port);
 int server_loop(int server);
 
+static uint64_t mac_index_key(const SceNetEtherAddr &mac)
+{
+	uint64_t key = 0;
+	memcpy(&key, mac.data, sizeof(mac.data));
+	return key;
+}
+
+static std::string product_index_key(const SceNetAdhocctlProductCode &product)
+{
+	// Product Codes were compared with strncmp, so stop at the first terminator
+	size_t len = 0;
+	while (len < PRODUCT_CODE_LENGTH && product.data[len] != 0) len++;
+	return std::string(product.data, len);
+}
+
+static AdhocGroupKey group_index_key(const SceNetAdhocctlGameNode * game, const SceNetAdhocctlGroupName &group)
+{
+	// Group Names were compared with strncmp, so ignore anything after the first terminator
+	AdhocGroupKey key;
+	key.game = game;
+	key.name = 0;
+	uint8_t name[ADHOCCTL_GROUPNAME_LEN] = {};
+	for (int i = 0; i < ADHOCCTL_GROUPNAME_LEN && group.data[i] != 0; i++) name[i] = group.data[i];
+	memcpy(&key.name, name, sizeof(key.name));
+	return key;
+}
+
+static void unindex_user_mac(SceNetAdhocctlUserNode * user)
+{
+	auto range = _db_user_by_mac.equal_range(mac_index_key(user->resolver.mac));
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == user) {
+			_db_user_by_mac.erase(it);
+			break;
+		}
+	}
+}
+
 void __AdhocServerInit() {
 	// Database Product name will update if new game region played on my server to list possible crosslinks
 	productids = std::vector<db_productid>(default_productids, default_productids + ARRAY_SIZE(default_productids));
@@ -517,8 +590,8 @@ void login_user_stream(int fd, uint32_t ip)
 	if(_db_user_count < SERVER_USER_MAXIMUM)
 	{
 		// Check IP Duplication
-		SceNetAdhocctlUserNode * u = _db_user;
-		while(u != NULL && u->resolver.ip != ip) u = u->next;
+		auto existing = _db_user_by_ip.find(ip);
+		SceNetAdhocctlUserNode * u = existing != _db_user_by_ip.end() ? existing->second : NULL;
 
 		if (u != NULL) { // IP Already existed
 			WARN_LOG(SCENET, "AdhocServer: Already Existing IP: %s\n", ip2str(*(in_addr*)&u->resolver.ip).c_str());
@@ -546,6 +619,7 @@ void login_user_stream(int fd, uint32_t ip)
 				user->next = _db_user;
 				if(_db_user != NULL) _db_user->prev = user;
 				_db_user = user;
+				_db_user_by_ip[ip] = user;
 
 				// Initialize Death Clock
 				user->last_recv = time(NULL);
@@ -590,8 +664,8 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 	if(valid_product_code == 1 && memcmp(&data->mac, "\xFF\xFF\xFF\xFF\xFF\xFF", sizeof(data->mac)) != 0 && memcmp(&data->mac, "\x00\x00\x00\x00\x00\x00", sizeof(data->mac)) != 0 && data->name.data[0] != 0)
 	{
 		// Check for duplicated MAC as most games identify Players by MAC
-		SceNetAdhocctlUserNode* u = _db_user;
-		while (u != NULL && !IsMatch(u->resolver.mac, data->mac)) u = u->next;
+		auto existing = _db_user_by_mac.find(mac_index_key(data->mac));
+		SceNetAdhocctlUserNode* u = existing != _db_user_by_mac.end() ? existing->second : NULL;
 
 		if (u != NULL) { // MAC Already existed
 			WARN_LOG(SCENET, "AdhocServer: Already Existing MAC: %s [%s]\n", mac2str(&data->mac).c_str(), ip2str(*(in_addr*)&u->resolver.ip).c_str());
@@ -601,8 +675,9 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 		game_product_override(&data->game);
 
 		// Find existing Game
-		SceNetAdhocctlGameNode * game = _db_game;
-		while(game != NULL && strncmp(game->game.data, data->game.data, PRODUCT_CODE_LENGTH) != 0) game = game->next;
+		std::string productKey = product_index_key(data->game);
+		auto existingGame = _db_game_by_product.find(productKey);
+		SceNetAdhocctlGameNode * game = existingGame != _db_game_by_product.end() ? existingGame->second : NULL;
 
 		// Game not found
 		if(game == NULL)
@@ -623,6 +698,7 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 				game->next = _db_game;
 				if(_db_game != NULL) _db_game->prev = game;
 				_db_game = game;
+				_db_game_by_product[productKey] = game;
 			}
 		}
 
@@ -631,6 +707,7 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 		{
 			// Save MAC
 			user->resolver.mac = data->mac;
+			_db_user_by_mac.insert(std::make_pair(mac_index_key(user->resolver.mac), user));
 
 			// Save Nickname
 			user->resolver.name = data->name;
@@ -684,6 +761,10 @@ void logout_user(SceNetAdhocctlUserNode * user)
 	// Unlink Rightside
 	if(user->next != NULL) user->next->prev = user->prev;
 
+	// Remove from Indexes (the MAC is only indexed once the user is playing)
+	_db_user_by_ip.erase(user->resolver.ip);
+	if(user->game != NULL) unindex_user_mac(user);
+
 	// Close Stream
 	closesocket(user->stream);
 
@@ -711,6 +792,9 @@ void logout_user(SceNetAdhocctlUserNode * user)
 			// Unlink Rightside
 			if(user->game->next != NULL) user->game->next->prev = user->game->prev;
 
+			// Remove from Index
+			_db_game_by_product.erase(product_index_key(user->game->game));
+
 			// Free Game Node Memory
 			free(user->game);
 		}
@@ -797,8 +881,9 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 		if(user->group == NULL)
 		{
 			// Find Group in Game Node
-			SceNetAdhocctlGroupNode * g = user->game->group;
-			while(g != NULL && strncmp((char *)g->group.data, (char *)group->data, ADHOCCTL_GROUPNAME_LEN) != 0) g = g->next;
+			AdhocGroupKey groupKey = group_index_key(user->game, *group);
+			auto existingGroup = _db_group_by_name.find(groupKey);
+			SceNetAdhocctlGroupNode * g = existingGroup != _db_group_by_name.end() ? existingGroup->second : NULL;
 
 			// BSSID Packet
 			SceNetAdhocctlConnectBSSIDPacketS2C bssid;
@@ -831,6 +916,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 
 					// Copy Group Name
 					g->group = *group;
+					_db_group_by_name[groupKey] = g;
 
 					// Increase Group Counter for Game
 					g->game->groupcount++;
@@ -1018,6 +1104,9 @@ void disconnect_user(SceNetAdhocctlUserNode * user)
 			// Unlink Rightside
 			if(user->group->next != NULL) user->group->next->prev = user->group->prev;
 
+			// Remove from Index
+			_db_group_by_name.erase(group_index_key(user->game, user->group->group));
+
 			// Free Group Memory
 			free(user->group);
 
@@ -1698,6 +1787,13 @@ int proAdhocServerThread(int port) // (int argc, char * argv[])
 	// Created Listening Socket
 	if(server != SOCKET_ERROR)
 	{
+		// Port 0 lets the OS pick one, so report the Port actually bound
+		struct sockaddr_in bound;
+		socklen_t boundlen = sizeof(bound);
+		if (getsockname(server, (struct sockaddr *)&bound, &boundlen) == 0)
+			port = ntohs(bound.sin_port);
+		adhocServerPort = (uint16_t)port;
+
 		// Notify User
 		INFO_LOG(SCENET, "AdhocServer: Listening for Connections on TCP Port %u", port); //SERVER_PORT
 
@@ -1862,7 +1958,8 @@ int create_listen_socket(uint16_t port)
 		else {
 			ERROR_LOG(SCENET, "AdhocServer: Bind returned %i (Socket error %d)", bindresult, errno);
 			auto n = GetI18NCategory("Networking");
-			host->NotifyUserMessage(std::string(n->T("AdhocServer Failed to Bind Port")) + " " + std::to_string(port), 3.0, 0x0000ff);
+			if (host)
+				host->NotifyUserMessage(std::string(n->T("AdhocServer Failed to Bind Port")) + " " + std::to_string(port), 3.0, 0x0000ff);
 		}
 
 		// Close Socket
@@ -1890,10 +1987,50 @@ int server_loop(int server)
 	// Create Empty Status Logfile
 	update_status();
 
+	// Readiness Sets (rebuilt every pass, slot 0 is the listening socket)
+	std::vector<pollfd> pollfds;
+	std::vector<SceNetAdhocctlUserNode *> pollusers;
+
+	// Complete Packets may still be waiting in a RX Buffer
+	bool pending = false;
+
 	// Handling Loop
 	while (adhocServerRunning) //(_status == 1)
 	{
+		// Collect Sockets
+		pollfds.clear();
+		pollusers.clear();
+		pollfd pfd;
+		memset(&pfd, 0, sizeof(pfd));
+		pfd.fd = server;
+		pfd.events = POLLIN;
+		pollfds.push_back(pfd);
+
+		// Don't wait if there's something to do already
+		int timeout = pending ? 0 : SERVER_POLL_TIMEOUT_MS;
+		time_t now = time(NULL);
+		for (SceNetAdhocctlUserNode * user = _db_user; user != NULL; user = user->next)
+		{
+			pfd.fd = user->stream;
+			pollfds.push_back(pfd);
+			pollusers.push_back(user);
+
+			// Timed out Users are dropped below
+			if (now - user->last_recv >= SERVER_USER_TIMEOUT) timeout = 0;
+		}
+
+		// Wait for Readiness
+		int pollresult = adhocserver_poll(pollfds.data(), (unsigned long)pollfds.size(), timeout);
+		if (pollresult < 0)
+		{
+			// Fall back to probing every socket, but don't spin
+			if (errno != EINTR) WARN_LOG(SCENET, "AdhocServer: poll failed (Socket error %d)", errno);
+			for (auto &fd : pollfds) fd.revents = POLLIN;
+			sleep_ms(10);
+		}
+
 		// Login Block
+		if (pollfds[0].revents != 0)
 		{
 			// Login Result
 			int loginresult = 0;
@@ -1935,18 +2072,23 @@ int server_loop(int server)
 			} while(loginresult != -1);
 		}
 
-		// Receive Data from Users
-		SceNetAdhocctlUserNode * user = _db_user;
-		while(user != NULL)
+		// Receive Data from Users (accepted Users are picked up on the next pass)
+		pending = false;
+		for (size_t i = 0; i < pollusers.size(); i++)
 		{
-			// Next User (for safe delete)
-			SceNetAdhocctlUserNode * next = user->next;
+			SceNetAdhocctlUserNode * user = pollusers[i];
 
-			// Receive Data from User
-			int recvresult = recv(user->stream, (char*)user->rx + user->rxpos, sizeof(user->rx) - user->rxpos, MSG_NOSIGNAL);
+			// Receive Data from ready User
+			int recvresult = -1;
+			int recverror = EAGAIN;
+			if (pollfds[i + 1].revents != 0)
+			{
+				recvresult = recv(user->stream, (char*)user->rx + user->rxpos, sizeof(user->rx) - user->rxpos, MSG_NOSIGNAL);
+				if (recvresult == -1) recverror = errno;
+			}
 
 			// Connection Closed or Timed Out
-			if(recvresult == 0 || (recvresult == -1 && errno != EAGAIN && errno != EWOULDBLOCK) || get_user_state(user) == USER_STATE_TIMED_OUT)
+			if(recvresult == 0 || (recvresult == -1 && recverror != EAGAIN && recverror != EWOULDBLOCK) || get_user_state(user) == USER_STATE_TIMED_OUT)
 			{
 				// Logout User
 				logout_user(user);
@@ -1965,6 +2107,10 @@ int server_loop(int server)
 					user->last_recv = time(NULL);
 				}
 
+				// Remember enough to check on the User after handling the Packet (which might log it out)
+				uint32_t userip = user->resolver.ip;
+				uint32_t rxbefore = user->rxpos;
+
 				// Waiting for Login Packet
 				if(get_user_state(user) == USER_STATE_WAITING)
 				{
@@ -2078,21 +2224,23 @@ int server_loop(int server)
 						logout_user(user);
 					}
 				}
-			}
 
-			// Move Pointer
-			user = next;
+				// Another complete Packet might be left in the RX Buffer, don't wait for new data before looking
+				auto alive = _db_user_by_ip.find(userip);
+				if (alive != _db_user_by_ip.end() && alive->second == user && user->rxpos > 0 && user->rxpos < rxbefore) pending = true;
+			}
 		}
 
-		// Prevent needless CPU Overload (1ms Sleep)
-		sleep_ms(10);
-
 		// Don't do anything if it's paused, otherwise the log will be flooded
 		while (adhocServerRunning && Core_IsStepping() && coreState != CORE_POWERDOWN) sleep_ms(10);
 	}
 
 	// Free User Database Memory
 	free_database();
+	_db_user_by_ip.clear();
+	_db_user_by_mac.clear();
+	_db_game_by_product.clear();
+	_db_group_by_name.clear();
 
 	// Close Server Socket
 	closesocket(server);
@@ -2100,3 +2248,190 @@ int server_loop(int server)
 	// Return Success
 	return 0;
 }
+
+/**
+ * Size of a Server to Client Packet
+ * @param opcode Packet Opcode
+ * @return Packet Size or 0 for unknown Opcodes
+ */
+static int loadtest_packet_size(uint8_t opcode)
+{
+	switch (opcode) {
+	case OPCODE_PING:
+	case OPCODE_SCAN_COMPLETE:
+		return 1;
+	case OPCODE_CONNECT:
+		return (int)sizeof(SceNetAdhocctlConnectPacketS2C);
+	case OPCODE_DISCONNECT:
+		return (int)sizeof(SceNetAdhocctlDisconnectPacketS2C);
+	case OPCODE_SCAN:
+		return (int)sizeof(SceNetAdhocctlScanPacketS2C);
+	case OPCODE_CONNECT_BSSID:
+		return (int)sizeof(SceNetAdhocctlConnectBSSIDPacketS2C);
+	case OPCODE_CHAT:
+		return (int)sizeof(SceNetAdhocctlChatPacketS2C);
+	default:
+		return 0;
+	}
+}
+
+struct LoadTestPlayer {
+	int fd = -1;
+	int expectedPeers = 0;
+	int peers = 0;
+	bool bssid = false;
+	bool failed = false;
+	uint8_t rx[1024];
+	uint32_t rxpos = 0;
+};
+
+int proAdhocServerLoadTest(uint16_t port, int players, int groupSize)
+{
+	if (players <= 0 || groupSize <= 0)
+		return -1;
+
+	// The Server tells Users apart by IP, so every Player needs its own Loopback Address.
+	// Only Linux routes all of 127.0.0.0/8 by default, elsewhere these need to be configured.
+	int probe = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (probe == -1)
+		return -1;
+	struct sockaddr_in alias;
+	memset(&alias, 0, sizeof(alias));
+	alias.sin_family = AF_INET;
+	alias.sin_addr.s_addr = htonl(0x7F010001);
+	bool aliasesAvailable = bind(probe, (struct sockaddr *)&alias, sizeof(alias)) != SOCKET_ERROR;
+	closesocket(probe);
+	if (!aliasesAvailable) {
+		WARN_LOG(SCENET, "AdhocServer: Load test needs 127.1.x.y loopback addresses, which aren't available here");
+		return -2;
+	}
+
+	double start = time_now_d();
+	std::vector<LoadTestPlayer> clients(players);
+
+	// Log in every Player and join its Group
+	for (int i = 0; i < players; i++)
+	{
+		LoadTestPlayer &client = clients[i];
+		int group = i / groupSize;
+		client.expectedPeers = std::min(groupSize, players - group * groupSize) - 1;
+
+		client.fd = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (client.fd == -1) {
+			client.failed = true;
+			continue;
+		}
+		setSockNoSIGPIPE(client.fd, 1);
+
+		// Give each Player its own Loopback Address
+		struct sockaddr_in local;
+		memset(&local, 0, sizeof(local));
+		local.sin_family = AF_INET;
+		local.sin_addr.s_addr = htonl(0x7F010001 + ((i / 250) << 8) + (i % 250));
+		if (bind(client.fd, (struct sockaddr *)&local, sizeof(local)) == SOCKET_ERROR) {
+			ERROR_LOG(SCENET, "AdhocServer: Load test couldn't bind player %d to its own loopback address (Socket error %d)", i, errno);
+			client.failed = true;
+			continue;
+		}
+
+		struct sockaddr_in server;
+		memset(&server, 0, sizeof(server));
+		server.sin_family = AF_INET;
+		server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		server.sin_port = htons(port);
+		if (connect(client.fd, (struct sockaddr *)&server, sizeof(server)) == SOCKET_ERROR) {
+			ERROR_LOG(SCENET, "AdhocServer: Load test player %d failed to connect (Socket error %d)", i, errno);
+			client.failed = true;
+			continue;
+		}
+
+		SceNetAdhocctlLoginPacketC2S login;
+		memset(&login, 0, sizeof(login));
+		login.base.opcode = OPCODE_LOGIN;
+		login.mac.data[0] = 0x02;
+		login.mac.data[4] = (uint8_t)(i >> 8);
+		login.mac.data[5] = (uint8_t)i;
+		snprintf((char *)login.name.data, sizeof(login.name.data), "Player%d", i);
+		memcpy(login.game.data, "ULUS10511", PRODUCT_CODE_LENGTH);
+
+		SceNetAdhocctlConnectPacketC2S join;
+		memset(&join, 0, sizeof(join));
+		join.base.opcode = OPCODE_CONNECT;
+		char groupname[ADHOCCTL_GROUPNAME_LEN + 1];
+		snprintf(groupname, sizeof(groupname), "LT%06d", group);
+		memcpy(join.group.data, groupname, ADHOCCTL_GROUPNAME_LEN);
+
+		if (send(client.fd, (const char *)&login, sizeof(login), MSG_NOSIGNAL) != (int)sizeof(login) || send(client.fd, (const char *)&join, sizeof(join), MSG_NOSIGNAL) != (int)sizeof(join)) {
+			ERROR_LOG(SCENET, "AdhocServer: Load test player %d failed to log in (Socket error %d)", i, errno);
+			client.failed = true;
+		}
+	}
+
+	// Wait until every Player saw all of its Peers and the Group BSSID
+	std::vector<pollfd> pollfds;
+	std::vector<LoadTestPlayer *> waiting;
+	double deadline = time_now_d() + 10.0;
+	while (time_now_d() < deadline)
+	{
+		pollfds.clear();
+		waiting.clear();
+		for (auto &client : clients)
+		{
+			if (client.failed || (client.bssid && client.peers >= client.expectedPeers))
+				continue;
+			pollfd pfd;
+			memset(&pfd, 0, sizeof(pfd));
+			pfd.fd = client.fd;
+			pfd.events = POLLIN;
+			pollfds.push_back(pfd);
+			waiting.push_back(&client);
+		}
+		if (waiting.empty())
+			break;
+
+		if (adhocserver_poll(pollfds.data(), (unsigned long)pollfds.size(), 100) <= 0)
+			continue;
+
+		for (size_t i = 0; i < waiting.size(); i++)
+		{
+			if (pollfds[i].revents == 0)
+				continue;
+			LoadTestPlayer &client = *waiting[i];
+			int received = recv(client.fd, (char *)client.rx + client.rxpos, sizeof(client.rx) - client.rxpos, MSG_NOSIGNAL);
+			if (received <= 0) {
+				client.failed = true;
+				continue;
+			}
+			client.rxpos += received;
+
+			// Consume complete Packets
+			while (client.rxpos > 0)
+			{
+				int size = loadtest_packet_size(client.rx[0]);
+				if (size == 0) {
+					client.failed = true;
+					break;
+				}
+				if (client.rxpos < (uint32_t)size)
+					break;
+				if (client.rx[0] == OPCODE_CONNECT) client.peers++;
+				if (client.rx[0] == OPCODE_CONNECT_BSSID) client.bssid = true;
+				client.rxpos -= size;
+				memmove(client.rx, client.rx + size, client.rxpos);
+			}
+		}
+	}
+
+	// Count and disconnect Players
+	int failed = 0;
+	for (auto &client : clients)
+	{
+		if (client.failed || !client.bssid || client.peers != client.expectedPeers)
+			failed++;
+		if (client.fd != -1)
+			closesocket(client.fd);
+	}
+
+	INFO_LOG(SCENET, "AdhocServer: Load test with %d players in groups of %d finished in %0.1f ms, %d failed", players, groupSize, (time_now_d() - start) * 1000.0, failed);
+	return failed;
+}
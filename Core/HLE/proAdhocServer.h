@@ -39,6 +39,9 @@
 // Server User Timeout (in seconds)
 #define SERVER_USER_TIMEOUT 15
 
+// Server Poll Timeout (in milliseconds, bounds how long a shutdown request can go unnoticed)
+#define SERVER_POLL_TIMEOUT_MS 100
+
 // Server SQLite3 Database
 #define SERVER_DATABASE "database.db"
 
@@ -368,6 +371,17 @@ void update_status();
 */
 int proAdhocServerThread(int port); // (int argc, char * argv[])
 
+/**
+ * Load Test Client, simulates Players logging into a running Server over Loopback
+ * @param port Server TCP Port
+ * @param players Number of simulated Players (each gets its own 127.1.x.y Address)
+ * @param groupSize Players per Group
+ * @return Number of Players that didn't see their whole Group, -1 on invalid Arguments, -2 if the Host has no 127.1.x.y Loopback Addresses
+ */
+int proAdhocServerLoadTest(uint16_t port, int players, int groupSize);
+
 //extern int _status;
 extern std::atomic<bool> adhocServerRunning;
+// TCP Port the running Server listens on (useful when started on Port 0)
+extern std::atomic<uint16_t> adhocServerPort;
 extern std::thread adhocServerThread;
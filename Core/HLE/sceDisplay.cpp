@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <map>
 #include <mutex>
@@ -27,12 +28,16 @@
 #include <sys/time.h>
 #endif
 
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/Data/Text/I18n.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/System/System.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/CoreTiming.h"
@@ -43,6 +48,7 @@
 #include "Core/System.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelThread.h"
@@ -171,6 +177,50 @@ static int lastFlipsTooFrequent = 0;
 static u64 lastFlipCycles = 0;
 static u64 nextFlipCycles = 0;
 
+struct FrameStatsRecord {
+	int frame;
+	// Since recording started.
+	double timeMs;
+	// Host time since the previous flip.
+	double frameMs;
+	// Everything but waiting, so frameMs - presentWaitMs.
+	double emuMs;
+	// Emulated CPU including JIT compiles, so emuMs - hleMs.
+	double cpuMs;
+	double jitCompileMs;
+	// Includes display lists run synchronously from sceGe calls.
+	double hleMs;
+	double geMs;
+	double texDecodeMs;
+	double texHashMs;
+	// Frame pacing sleeps and the flip itself, as in the frame time graph.
+	double presentWaitMs;
+	int audioUnderruns;
+};
+
+// Running times from kernelStats and gpuStats, which are reset every host frame.
+struct FrameStatsTotals {
+	double jitCompile = 0.0;
+	double hle = 0.0;
+	double ge = 0.0;
+	double texDecode = 0.0;
+	double texHash = 0.0;
+};
+
+// About 10 minutes at 60 fps.
+static const int frameStatsSize = 36000;
+static std::mutex frameStatsLock;
+static std::atomic<bool> frameStatsEnabled;
+static std::vector<FrameStatsRecord> frameStats;
+static int frameStatsPos = 0;
+static int frameStatsValid = 0;
+static int frameStatsCount = 0;
+static double frameStatsStartTime = 0.0;
+static double frameStatsLastTime = 0.0;
+static double frameStatsWait = 0.0;
+static FrameStatsTotals frameStatsBase;
+static FrameStatsTotals frameStatsCarried;
+
 void hleEnterVblank(u64 userdata, int cyclesLate);
 void hleLeaveVblank(u64 userdata, int cyclesLate);
 void hleAfterFlip(u64 userdata, int cyclesLate);
@@ -246,6 +296,10 @@ void __DisplayInit() {
 	frameTimeHistoryPos = 0;
 	lastFrameTimeHistory = 0.0;
 
+	// Don't count the time between games as a frame.
+	frameStatsLastTime = time_now_d();
+	frameStatsWait = 0.0;
+
 	__KernelRegisterWaitTypeFuncs(WAITTYPE_VBLANK, __DisplayVblankBeginCallback, __DisplayVblankEndCallback);
 }
 
@@ -522,15 +576,170 @@ void __DisplayGetDebugStats(char *stats, size_t bufsize) {
 	snprintf(stats, bufsize,
 		"Kernel processing time: %0.2f ms\n"
 		"Slowest syscall: %s : %0.2f ms\n"
-		"Most active syscall: %s : %0.2f ms\n%s",
+		"Most active syscall: %s : %0.2f ms\n"
+		"Memory allocs: %d, frees: %d : %0.2f ms\n"
+		"JIT compile time: %0.2f ms\n%s",
 		kernelStats.msInSyscalls * 1000.0f,
 		kernelStats.slowestSyscallName ? kernelStats.slowestSyscallName : "(none)",
 		kernelStats.slowestSyscallTime * 1000.0f,
 		kernelStats.summedSlowestSyscallName ? kernelStats.summedSlowestSyscallName : "(none)",
 		kernelStats.summedSlowestSyscallTime * 1000.0f,
+		kernelStats.memAllocs,
+		kernelStats.memFrees,
+		kernelStats.msInMemAllocator * 1000.0f,
+		kernelStats.msInJitCompiler * 1000.0f,
 		statbuf);
 }
 
+static FrameStatsTotals GetFrameStatsTotals() {
+	FrameStatsTotals totals;
+	totals.jitCompile = kernelStats.msInJitCompiler;
+	totals.hle = kernelStats.msInSyscalls;
+	totals.ge = gpuStats.msProcessingDisplayLists;
+	totals.texDecode = gpuStats.msDecodingTextures;
+	totals.texHash = gpuStats.msHashingTextures;
+	return totals;
+}
+
+// Adds what was spent since base, treating a total lower than base as having been reset.
+static void AddFrameStatsTotals(FrameStatsTotals &dest, const FrameStatsTotals &cur, const FrameStatsTotals &base) {
+	auto delta = [](double c, double b) {
+		return c >= b ? c - b : c;
+	};
+	dest.jitCompile += delta(cur.jitCompile, base.jitCompile);
+	dest.hle += delta(cur.hle, base.hle);
+	dest.ge += delta(cur.ge, base.ge);
+	dest.texDecode += delta(cur.texDecode, base.texDecode);
+	dest.texHash += delta(cur.texHash, base.texHash);
+}
+
+void __DisplayAccumulateFrameStats() {
+	if (!frameStatsEnabled)
+		return;
+	AddFrameStatsTotals(frameStatsCarried, GetFrameStatsTotals(), frameStatsBase);
+	frameStatsBase = FrameStatsTotals();
+}
+
+static void RecordFrameStats() {
+	double now = time_now_d();
+	FrameStatsTotals cur = GetFrameStatsTotals();
+	FrameStatsTotals spent = frameStatsCarried;
+	AddFrameStatsTotals(spent, cur, frameStatsBase);
+	frameStatsCarried = FrameStatsTotals();
+	frameStatsBase = cur;
+
+	FrameStatsRecord record;
+	record.frame = frameStatsCount++;
+	record.timeMs = (now - frameStatsStartTime) * 1000.0;
+	record.frameMs = (now - frameStatsLastTime) * 1000.0;
+	record.presentWaitMs = frameStatsWait * 1000.0;
+	record.emuMs = std::max(record.frameMs - record.presentWaitMs, 0.0);
+	record.jitCompileMs = spent.jitCompile * 1000.0;
+	record.hleMs = spent.hle * 1000.0;
+	record.cpuMs = std::max(record.emuMs - record.hleMs, 0.0);
+	record.geMs = spent.ge * 1000.0;
+	record.texDecodeMs = spent.texDecode * 1000.0;
+	record.texHashMs = spent.texHash * 1000.0;
+	record.audioUnderruns = __AudioTakeUnderrunCount();
+	frameStatsLastTime = now;
+	frameStatsWait = 0.0;
+
+	std::lock_guard<std::mutex> guard(frameStatsLock);
+	frameStats[frameStatsPos++] = record;
+	frameStatsPos = frameStatsPos % frameStatsSize;
+	if (frameStatsValid < frameStatsSize) {
+		++frameStatsValid;
+	}
+}
+
+void __DisplayStartFrameStats() {
+	if (frameStatsEnabled)
+		return;
+
+	std::lock_guard<std::mutex> guard(frameStatsLock);
+	frameStats.resize(frameStatsSize);
+	frameStatsPos = 0;
+	frameStatsValid = 0;
+	frameStatsCount = 0;
+	frameStatsStartTime = time_now_d();
+	frameStatsLastTime = frameStatsStartTime;
+	frameStatsWait = 0.0;
+	frameStatsBase = GetFrameStatsTotals();
+	frameStatsCarried = FrameStatsTotals();
+	__AudioTakeUnderrunCount();
+
+	// The times below are only measured while collecting debug stats.
+	Core_ForceDebugStats(true);
+	frameStatsEnabled = true;
+}
+
+void __DisplayStopFrameStats() {
+	if (!frameStatsEnabled)
+		return;
+	frameStatsEnabled = false;
+	Core_ForceDebugStats(false);
+}
+
+bool __DisplayExportFrameStats(const Path &filename) {
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		ERROR_LOG(SCEDISPLAY, "Unable to open frame stats file for writing: %s", filename.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(frameStatsLock);
+	const bool asJson = filename.GetFileExtension() == ".json";
+	const int first = frameStatsValid < frameStatsSize ? 0 : frameStatsPos;
+
+	json::JsonWriter writer;
+	if (asJson) {
+		writer.begin();
+		writer.pushArray("frames");
+	} else {
+		fprintf(f, "frame,time_ms,frame_ms,emu_ms,cpu_ms,jit_compile_ms,hle_ms,ge_ms,tex_decode_ms,tex_hash_ms,present_wait_ms,audio_underruns\n");
+	}
+
+	for (int i = 0; i < frameStatsValid; ++i) {
+		const FrameStatsRecord &record = frameStats[(first + i) % frameStatsSize];
+		if (asJson) {
+			writer.pushDict();
+			writer.writeInt("frame", record.frame);
+			writer.writeRaw("timeMs", StringFromFormat("%.3f", record.timeMs));
+			writer.writeRaw("frameMs", StringFromFormat("%.3f", record.frameMs));
+			writer.writeRaw("emuMs", StringFromFormat("%.3f", record.emuMs));
+			writer.writeRaw("cpuMs", StringFromFormat("%.3f", record.cpuMs));
+			writer.writeRaw("jitCompileMs", StringFromFormat("%.3f", record.jitCompileMs));
+			writer.writeRaw("hleMs", StringFromFormat("%.3f", record.hleMs));
+			writer.writeRaw("geMs", StringFromFormat("%.3f", record.geMs));
+			writer.writeRaw("texDecodeMs", StringFromFormat("%.3f", record.texDecodeMs));
+			writer.writeRaw("texHashMs", StringFromFormat("%.3f", record.texHashMs));
+			writer.writeRaw("presentWaitMs", StringFromFormat("%.3f", record.presentWaitMs));
+			writer.writeInt("audioUnderruns", record.audioUnderruns);
+			writer.pop();
+		} else {
+			fprintf(f, "%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
+				record.frame, record.timeMs, record.frameMs, record.emuMs, record.cpuMs, record.jitCompileMs,
+				record.hleMs, record.geMs, record.texDecodeMs, record.texHashMs, record.presentWaitMs, record.audioUnderruns);
+		}
+	}
+
+	if (asJson) {
+		writer.pop();
+		writer.end();
+		const std::string data = writer.str();
+		fwrite(data.data(), 1, data.size(), f);
+	}
+
+	bool success = !ferror(f);
+	success = fclose(f) == 0 && success;
+	if (!success) {
+		ERROR_LOG(SCEDISPLAY, "Failed to write frame stats: %s", filename.c_str());
+		return false;
+	}
+	INFO_LOG(SCEDISPLAY, "Exported %d frame stats records to %s", frameStatsValid, filename.c_str());
+	return true;
+}
+
 
 
 void __DisplaySetWasPaused() {
@@ -683,7 +892,9 @@ static void DoFrameIdleTiming() {
 		}
 
 		if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
-			frameSleepHistory[frameTimeHistoryPos] += time_now_d() - before;
+			double slept = time_now_d() - before;
+			frameSleepHistory[frameTimeHistoryPos] += slept;
+			frameStatsWait += slept;
 		}
 	}
 }
@@ -850,8 +1061,13 @@ void __DisplayFlip(int cyclesLate) {
 
 		if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
 			// Track how long we sleep (whether vsync or sleep_ms.)
-			frameSleepHistory[frameSleepPos] += time_now_d() - lastFrameTimeHistory;
+			double slept = time_now_d() - lastFrameTimeHistory;
+			frameSleepHistory[frameSleepPos] += slept;
+			frameStatsWait += slept;
 		}
+
+		if (frameStatsEnabled)
+			RecordFrameStats();
 	} else {
 		// Okay, there's no new frame to draw.  But audio may be playing, so we need to time still.
 		DoFrameIdleTiming();
@@ -915,6 +1131,7 @@ void hleLagSync(u64 userdata, int cyclesLate) {
 
 	if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
 		frameSleepHistory[frameTimeHistoryPos] += now - before;
+		frameStatsWait += now - before;
 	}
 }
 
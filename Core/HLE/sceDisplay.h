@@ -19,6 +19,8 @@
 
 #include "Core/MemMap.h"
 
+class Path;
+
 void __DisplayInit();
 void __DisplayDoState(PointerWrap &p);
 void __DisplayShutdown();
@@ -48,4 +50,13 @@ int __DisplayGetFlipCount();
 // Call this when resuming to avoid a small speedup burst
 void __DisplaySetWasPaused();
 
+// Per-flip timing records (CPU, JIT, HLE, GE, texture, wait, audio), kept in a ring buffer.
+// Recording forces debug stats collection on, so the numbers are only as fine as those.
+void __DisplayStartFrameStats();
+void __DisplayStopFrameStats();
+// Must be called before kernelStats and gpuStats are reset for the next host frame.
+void __DisplayAccumulateFrameStats();
+// Writes JSON if the filename ends in .json, otherwise CSV.
+bool __DisplayExportFrameStats(const Path &filename);
+
 void Register_sceDisplay_driver();
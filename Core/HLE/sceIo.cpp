@@ -136,11 +136,12 @@ static MemStickFatState lastMemStickFatState;
 
 static AsyncIOManager ioManager;
 static bool ioManagerThreadEnabled = false;
-static std::thread *ioManagerThread;
 
 // TODO: Is it better to just put all on the thread?
 // Let's try. (was 256)
 const int IO_THREAD_MIN_DATA_SIZE = 0;
+// Lets a game stream several files at once without one read waiting on another.
+const int IO_THREAD_COUNT = 2;
 
 #define SCE_STM_FDIR 0x1000
 #define SCE_STM_FREG 0x2000
@@ -559,13 +560,6 @@ static void __IoAsyncEndCallback(SceUID threadID, SceUID prevCallbackId) {
 	}
 }
 
-static void __IoManagerThread() {
-	SetCurrentThreadName("IO");
-	while (ioManagerThreadEnabled && coreState != CORE_BOOT_ERROR && coreState != CORE_RUNTIME_ERROR && coreState != CORE_POWERDOWN) {
-		ioManager.RunEventsUntil(CoreTiming::GetTicks() + msToCycles(1000));
-	}
-}
-
 static void __IoWakeManager(CoreLifecycle stage) {
 	// Ping the thread so that it knows to check coreState.
 	if (stage == CoreLifecycle::STOPPING) {
@@ -666,9 +660,8 @@ void __IoInit() {
 	memset(fds, 0, sizeof(fds));
 
 	ioManagerThreadEnabled = true;
-	ioManager.SetThreadEnabled(true);
 	Core_ListenLifecycle(&__IoWakeManager);
-	ioManagerThread = new std::thread(&__IoManagerThread);
+	ioManager.StartThreads(IO_THREAD_COUNT);
 
 	__KernelRegisterWaitTypeFuncs(WAITTYPE_ASYNCIO, __IoAsyncBeginCallback, __IoAsyncEndCallback);
 
@@ -748,14 +741,8 @@ void __IoDoState(PointerWrap &p) {
 
 void __IoShutdown() {
 	ioManagerThreadEnabled = false;
-	ioManager.SyncThread();
-	ioManager.FinishEventLoop();
-	if (ioManagerThread != nullptr) {
-		ioManagerThread->join();
-		delete ioManagerThread;
-		ioManagerThread = nullptr;
-		ioManager.Shutdown();
-	}
+	ioManager.StopThreads();
+	ioManager.Shutdown();
 
 	for (int i = 0; i < PSP_COUNT_FDS; ++i) {
 		asyncParams[i].op = IoAsyncOp::NONE;
@@ -1055,7 +1042,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 				// If there's a pending operation on this file, wait for it to finish and don't overwrite it.
 				useThread = !ioManager.HasOperation(f->handle);
 				if (!useThread) {
-					ioManager.SyncThread();
+					ioManager.SyncHandle(f->handle);
 				}
 			}
 			if (useThread) {
@@ -1193,7 +1180,7 @@ static bool __IoWrite(int &result, int id, u32 data_addr, int size, int &us) {
 			// If there's a pending operation on this file, wait for it to finish and don't overwrite it.
 			useThread = !ioManager.HasOperation(f->handle);
 			if (!useThread) {
-				ioManager.SyncThread();
+				ioManager.SyncHandle(f->handle);
 			}
 		}
 		if (useThread) {
@@ -1343,7 +1330,7 @@ static s64 __IoLseekDest(FileNode *f, s64 offset, int whence, FileMove &seek) {
 
 	// Let's make sure this isn't incorrect mid-operation.
 	if (ioManager.HasOperation(f->handle)) {
-		ioManager.SyncThread();
+		ioManager.SyncHandle(f->handle);
 	}
 
 	s64 newPos = 0;
@@ -556,6 +556,10 @@ struct KernelStats {
 		summedMsInSyscalls.clear();
 		summedSlowestSyscallTime = 0;
 		summedSlowestSyscallName = 0;
+		memAllocs = 0;
+		memFrees = 0;
+		msInMemAllocator = 0;
+		msInJitCompiler = 0;
 	}
 
 	double msInSyscalls;
@@ -564,6 +568,12 @@ struct KernelStats {
 	std::map<KernelStatsSyscall, double> summedMsInSyscalls;
 	double summedSlowestSyscallTime;
 	const char *summedSlowestSyscallName;
+	// Kernel memory (partitions and VPL) allocations and frees.
+	int memAllocs;
+	int memFrees;
+	double msInMemAllocator;
+	// Not really kernel, but the CPU side of the frame.
+	double msInJitCompiler;
 };
 
 extern KernelStats kernelStats;
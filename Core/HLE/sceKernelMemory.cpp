@@ -21,6 +21,7 @@
 #include <map>
 
 #include "Common/Thread/ParallelLoop.h"
+#include "Common/TimeUtil.h"
 #include "Core/CoreTiming.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/HLE/HLE.h"
@@ -214,7 +215,14 @@ struct SceKernelVplHeader {
 	}
 
 	u32 Allocate(u32 size) {
-		u32 allocBlocks = ((size + 7) / 8) + 1;
+		double start = time_now_d();
+		kernelStats.memAllocs++;
+		u32 addr = AllocateBlocks(((size + 7) / 8) + 1);
+		kernelStats.msInMemAllocator += time_now_d() - start;
+		return addr;
+	}
+
+	u32 AllocateBlocks(u32 allocBlocks) {
 		auto prev = nextFreeBlock_;
 		do {
 			auto b = prev->next;
@@ -234,6 +242,7 @@ struct SceKernelVplHeader {
 	}
 
 	bool Free(u32 ptr) {
+		kernelStats.memFrees++;
 		auto b = PSPPointer<SceKernelVplBlock>::Create(ptr - 8);
 		// Is it even in the right range?  Can't be the last block, which is always 0.
 		if (!b.IsValid() || ptr < FirstBlockPtr() || ptr >= LastBlockPtr()) {
@@ -22,13 +22,92 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #include "Core/HW/AsyncIOManager.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 
+void AsyncIOManager::StartThreads(int count) {
+	std::lock_guard<std::mutex> guard(resultsLock_);
+	_assert_(threads_.empty());
+	threadsFinishing_ = false;
+	threadsActive_ = count;
+	for (int i = 0; i < count; ++i) {
+		threads_.push_back(std::thread([this, i] {
+			WorkerLoop(i);
+		}));
+	}
+}
+
+void AsyncIOManager::StopThreads() {
+	FinishEventLoop();
+	for (auto &thread : threads_) {
+		thread.join();
+	}
+	threads_.clear();
+}
+
+void AsyncIOManager::FinishEventLoop() {
+	std::lock_guard<std::mutex> guard(resultsLock_);
+	threadsFinishing_ = true;
+	eventsWait_.notify_all();
+}
+
+void AsyncIOManager::WorkerLoop(int index) {
+	static const char *const names[] = { "IO", "IO 2", "IO 3", "IO 4" };
+	SetCurrentThreadName(names[index & 3]);
+
+	std::unique_lock<std::mutex> guard(resultsLock_);
+	while (true) {
+		// Take the oldest event whose handle isn't busy on another worker, to keep each handle in order.
+		auto it = events_.begin();
+		while (it != events_.end() && handlesRunning_.find(it->handle) != handlesRunning_.end())
+			++it;
+		if (it == events_.end()) {
+			if (threadsFinishing_ && events_.empty())
+				break;
+			eventsWait_.wait(guard);
+			continue;
+		}
+
+		AsyncIOEvent ev = *it;
+		events_.erase(it);
+		handlesRunning_.insert(ev.handle);
+
+		guard.unlock();
+		ProcessEvent(ev);
+		guard.lock();
+
+		handlesRunning_.erase(ev.handle);
+		// The next event for this handle may be runnable now.
+		eventsWait_.notify_one();
+		resultsWait_.notify_all();
+	}
+
+	threadsActive_--;
+	resultsWait_.notify_all();
+}
+
+bool AsyncIOManager::IsScheduled(u32 handle) {
+	if (handlesRunning_.find(handle) != handlesRunning_.end())
+		return true;
+	for (const AsyncIOEvent &ev : events_) {
+		if (ev.handle == handle)
+			return true;
+	}
+	return false;
+}
+
+void AsyncIOManager::WaitScheduled(std::unique_lock<std::mutex> &guard, u32 handle) {
+	while (IsScheduled(handle) && results_.find(handle) == results_.end()) {
+		resultsWait_.wait(guard);
+	}
+}
+
 bool AsyncIOManager::HasOperation(u32 handle) {
+	std::lock_guard<std::mutex> guard(resultsLock_);
 	if (resultsPending_.find(handle) != resultsPending_.end()) {
 		return true;
 	}
@@ -39,13 +118,34 @@ bool AsyncIOManager::HasOperation(u32 handle) {
 }
 
 void AsyncIOManager::ScheduleOperation(AsyncIOEvent ev) {
-	{
-		std::lock_guard<std::mutex> guard(resultsLock_);
-		if (!resultsPending_.insert(ev.handle).second) {
-			ERROR_LOG_REPORT(SCEIO, "Scheduling operation for file %d while one is pending (type %d)", ev.handle, ev.type);
-		}
+	std::unique_lock<std::mutex> guard(resultsLock_);
+	if (!resultsPending_.insert(ev.handle).second) {
+		ERROR_LOG_REPORT(SCEIO, "Scheduling operation for file %d while one is pending (type %d)", ev.handle, ev.type);
+	}
+
+	if (threadsActive_ == 0) {
+		// No workers, so just run it now.
+		guard.unlock();
+		ProcessEvent(ev);
+		return;
+	}
+
+	events_.push_back(ev);
+	eventsWait_.notify_one();
+}
+
+void AsyncIOManager::SyncHandle(u32 handle) {
+	std::unique_lock<std::mutex> guard(resultsLock_);
+	while (IsScheduled(handle)) {
+		resultsWait_.wait(guard);
+	}
+}
+
+void AsyncIOManager::SyncThread() {
+	std::unique_lock<std::mutex> guard(resultsLock_);
+	while (!events_.empty() || !handlesRunning_.empty()) {
+		resultsWait_.wait(guard);
 	}
-	ScheduleEvent(ev);
 }
 
 void AsyncIOManager::Shutdown() {
@@ -85,13 +185,7 @@ bool AsyncIOManager::ReadResult(u32 handle, AsyncIOResult &result) {
 
 bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
 	std::unique_lock<std::mutex> guard(resultsLock_);
-	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
-		if (PopResult(handle, result)) {
-			return true;
-		}
-		resultsWait_.wait_for(guard, std::chrono::milliseconds(16));
-	}
+	WaitScheduled(guard, handle);
 	return PopResult(handle, result);
 }
 
@@ -99,13 +193,7 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 	AsyncIOResult result;
 
 	std::unique_lock<std::mutex> guard(resultsLock_);
-	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
-		if (ReadResult(handle, result)) {
-			return result.finishTicks;
-		}
-		resultsWait_.wait_for(guard, std::chrono::milliseconds(16));
-	}
+	WaitScheduled(guard, handle);
 	if (ReadResult(handle, result)) {
 		return result.finishTicks;
 	}
@@ -146,7 +234,7 @@ void AsyncIOManager::EventResult(u32 handle, AsyncIOResult result) {
 		ERROR_LOG_REPORT(SCEIO, "Overwriting previous result for file action on handle %d", handle);
 	}
 	results_[handle] = result;
-	resultsWait_.notify_one();
+	resultsWait_.notify_all();
 }
 
 void AsyncIOManager::DoState(PointerWrap &p) {
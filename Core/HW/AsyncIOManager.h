@@ -15,19 +15,22 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#pragma once
+
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <set>
 #include <mutex>
+#include <thread>
+#include <vector>
 
-#include "Core/ThreadEventQueue.h"
-
-class NoBase {
-};
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
+#include "Core/CoreTiming.h"
 
 enum AsyncIOEventType {
 	IO_EVENT_INVALID,
-	IO_EVENT_SYNC,
-	IO_EVENT_FINISH,
 	IO_EVENT_READ,
 	IO_EVENT_WRITE,
 };
@@ -75,26 +78,36 @@ struct AsyncIOResult {
 	u32 invalidateAddr;
 };
 
-typedef ThreadEventQueue<NoBase, AsyncIOEvent, AsyncIOEventType, IO_EVENT_INVALID, IO_EVENT_SYNC, IO_EVENT_FINISH> IOThreadEventQueue;
-class AsyncIOManager : public IOThreadEventQueue {
+// Operations on different handles run in parallel on a pool of workers, while
+// operations on the same handle always run one at a time in the order scheduled.
+class AsyncIOManager {
 public:
+	void StartThreads(int count);
+	// Finishes everything already scheduled, then joins the workers.
+	void StopThreads();
+	// Lets the workers exit once the queue is empty, without waiting for them.
+	void FinishEventLoop();
+
 	void DoState(PointerWrap &p);
 
 	bool HasOperation(u32 handle);
 	void ScheduleOperation(AsyncIOEvent ev);
+	// Waits for any scheduled operation on handle, leaving the result to be collected.
+	void SyncHandle(u32 handle);
+	// Waits for every scheduled operation.
+	void SyncThread();
 	void Shutdown();
 
 	bool HasResult(u32 handle);
 	bool WaitResult(u32 handle, AsyncIOResult &result);
 	u64 ResultFinishTicks(u32 handle);
 
-protected:
-	void ProcessEvent(AsyncIOEvent ref) override;
-	bool ShouldExitEventLoop() override {
-		return coreState == CORE_BOOT_ERROR || coreState == CORE_RUNTIME_ERROR || coreState == CORE_POWERDOWN;
-	}
-
 private:
+	void WorkerLoop(int index);
+	bool IsScheduled(u32 handle);
+	void WaitScheduled(std::unique_lock<std::mutex> &guard, u32 handle);
+	void ProcessEvent(AsyncIOEvent ev);
+
 	bool PopResult(u32 handle, AsyncIOResult &result);
 	bool ReadResult(u32 handle, AsyncIOResult &result);
 	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr);
@@ -102,8 +115,17 @@ class AsyncIOManager : public IOThreadEventQueue {
 
 	void EventResult(u32 handle, AsyncIOResult result);
 
+	// Protects everything below, the queue as well as the results.
 	std::mutex resultsLock_;
 	std::condition_variable resultsWait_;
+	std::condition_variable eventsWait_;
+	std::deque<AsyncIOEvent> events_;
+	std::set<u32> handlesRunning_;
+	std::vector<std::thread> threads_;
+	// Workers that haven't exited yet.  With none, operations run as they're scheduled.
+	int threadsActive_ = 0;
+	bool threadsFinishing_ = false;
+
 	std::set<u32> resultsPending_;
 	std::map<u32, AsyncIOResult> results_;
 };
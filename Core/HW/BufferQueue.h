@@ -127,6 +127,28 @@ struct BufferQueue {
 		return bytesgot;
 	}
 
+	// Like get_front(), but skips the first offset bytes of the queue.
+	int get_at(int offset, unsigned char *buf, int wantedsize) {
+		if (wantedsize <= 0 || offset < 0)
+			return 0;
+		int bytesgot = getQueueSize() - offset;
+		if (bytesgot <= 0)
+			return 0;
+		if (wantedsize < bytesgot)
+			bytesgot = wantedsize;
+		int pos = start + offset;
+		if (pos >= bufQueueSize)
+			pos -= bufQueueSize;
+		int firstSize = bufQueueSize - pos;
+		if (bytesgot <= firstSize) {
+			memcpy(buf, bufQueue + pos, bytesgot);
+		} else {
+			memcpy(buf, bufQueue + pos, firstSize);
+			memcpy(buf + firstSize, bufQueue, bytesgot - firstSize);
+		}
+		return bytesgot;
+	}
+
 	void DoState(PointerWrap &p);
 
 private:
@@ -15,7 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/HW/MediaEngine.h"
@@ -29,6 +31,17 @@
 
 #include <algorithm>
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #ifdef USE_FFMPEG
 
 extern "C" {
@@ -117,8 +130,27 @@ static int getPixelFormatBytes(int pspFormat)
 	}
 }
 
+#ifdef USE_FFMPEG
+// How many frames the decode-ahead thread may decode before the game asks for them.
+static const size_t MAX_DECODE_AHEAD_FRAMES = 3;
+
+static void setSwsFullRange(SwsContext *sws_ctx) {
+	int *inv_coefficients;
+	int *coefficients;
+	int srcRange, dstRange;
+	int brightness, contrast, saturation;
+
+	if (sws_getColorspaceDetails(sws_ctx, &inv_coefficients, &srcRange, &coefficients, &dstRange, &brightness, &contrast, &saturation) != -1) {
+		srcRange = 0;
+		dstRange = 0;
+		sws_setColorspaceDetails(sws_ctx, inv_coefficients, srcRange, coefficients, dstRange, brightness, contrast, saturation);
+	}
+}
+#endif
+
 MediaEngine::MediaEngine(): m_pdata(0) {
 #ifdef USE_FFMPEG
+	m_aheadPixelMode = GE_CMODE_32BIT_ABGR8888;
 	m_pFormatCtx = 0;
 	m_pCodecCtxs.clear();
 	m_pFrame = 0;
@@ -174,6 +206,13 @@ void MediaEngine::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+#ifdef USE_FFMPEG
+	// Frames decoded ahead were not yet seen by the game, so they aren't part of the state.
+	// On load, the context is reopened from the committed stream position below.
+	if (p.mode == p.MODE_READ && m_aheadThread.joinable())
+		closeContext();
+#endif
+
 	Do(p, m_videoStream);
 	Do(p, m_audioStream);
 
@@ -240,6 +279,10 @@ void MediaEngine::DoState(PointerWrap &p) {
 
 static int MpegReadbuffer(void *opaque, uint8_t *buf, int buf_size) {
 	MediaEngine *mpeg = (MediaEngine *)opaque;
+#ifdef USE_FFMPEG
+	if (mpeg->m_aheadFrame)
+		return mpeg->readAhead(buf, buf_size);
+#endif
 
 	int size = buf_size;
 	if (mpeg->m_mpegheaderReadPos < mpeg->m_mpegheaderSize) {
@@ -362,6 +405,7 @@ bool MediaEngine::openContext(bool keepReadPos) {
 void MediaEngine::closeContext()
 {
 #ifdef USE_FFMPEG
+	stopDecodeAhead();
 	if (m_buffer)
 		av_free(m_buffer);
 	if (m_pFrameRGB)
@@ -393,6 +437,9 @@ bool MediaEngine::loadStream(const u8 *buffer, int readSize, int RingbufferSize)
 {
 	closeMedia();
 
+#ifdef USE_FFMPEG
+	m_aheadBroken = false;
+#endif
 	m_videopts = 0;
 	m_lastPts = -1;
 	m_audiopts = 0;
@@ -418,6 +465,7 @@ bool MediaEngine::addVideoStream(int streamNum, int streamId) {
 		// no need to add an existing stream.
 		if ((u32)streamNum < m_pFormatCtx->nb_streams)
 			return true;
+		abandonDecodeAhead();
 		const AVCodec *h264_codec = avcodec_find_decoder(AV_CODEC_ID_H264);
 		if (!h264_codec)
 			return false;
@@ -452,8 +500,15 @@ bool MediaEngine::addVideoStream(int streamNum, int streamId) {
 int MediaEngine::addStreamData(const u8 *buffer, int addSize) {
 	int size = addSize;
 	if (size > 0 && m_pdata) {
+#ifdef USE_FFMPEG
+		std::unique_lock<std::mutex> guard(m_aheadLock);
+#endif
 		if (!m_pdata->push(buffer, size)) 
 			size  = 0;
+#ifdef USE_FFMPEG
+		guard.unlock();
+		m_aheadCond.notify_all();
+#endif
 		if (m_demux) {
 			m_demux->addStreamData(buffer, addSize);
 		}
@@ -513,6 +568,7 @@ bool MediaEngine::setVideoStream(int streamNum, bool force) {
 	}
 
 #ifdef USE_FFMPEG
+	abandonDecodeAhead();
 	if (m_pFormatCtx && m_pCodecCtxs.find(streamNum) == m_pCodecCtxs.end()) {
 		// Get a pointer to the codec context for the video stream
 		if ((u32)streamNum >= m_pFormatCtx->nb_streams) {
@@ -638,32 +694,30 @@ void MediaEngine::updateSwsFormat(int videoPixelMode) {
 				NULL
 			);
 
-		int *inv_coefficients;
-		int *coefficients;
-		int srcRange, dstRange;
-		int brightness, contrast, saturation;
-
-		if (sws_getColorspaceDetails(m_sws_ctx, &inv_coefficients, &srcRange, &coefficients, &dstRange, &brightness, &contrast, &saturation) != -1) {
-			srcRange = 0;
-			dstRange = 0;
-			sws_setColorspaceDetails(m_sws_ctx, inv_coefficients, srcRange, coefficients, dstRange, brightness, contrast, saturation);
-		}
+		setSwsFullRange(m_sws_ctx);
 	}
 #endif
 }
 
-bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
+void MediaEngine::scaleVideoFrame(int videoPixelMode) {
 #ifdef USE_FFMPEG
 	auto codecIter = m_pCodecCtxs.find(m_videoStream);
 	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+	if (!m_pCodecCtx || !m_pFrameRGB)
+		return;
 
-	if (!m_pFormatCtx)
-		return false;
-	if (!m_pCodecCtx)
-		return false;
-	if (!m_pFrame)
-		return false;
+	updateSwsFormat(videoPixelMode);
+	// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
+	// Update the linesize for the new format too.  We started with the largest size, so it should fit.
+	m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+
+	sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
+		m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+#endif
+}
 
+#ifdef USE_FFMPEG
+bool MediaEngine::decodeFrame(AVCodecContext *codecCtx, DecodedFrame &out, s64 &videopts, s64 &lastPts) {
 	AVPacket packet;
 	av_init_packet(&packet);
 	int frameFinished;
@@ -684,10 +738,10 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 48, 101)
 			if (packet.size != 0)
-				avcodec_send_packet(m_pCodecCtx, &packet);
-			int result = avcodec_receive_frame(m_pCodecCtx, m_pFrame);
+				avcodec_send_packet(codecCtx, &packet);
+			int result = avcodec_receive_frame(codecCtx, out.frame);
 			if (result == 0) {
-				result = m_pFrame->pkt_size;
+				result = out.frame->pkt_size;
 				frameFinished = 1;
 			} else if (result == AVERROR(EAGAIN)) {
 				result = 0;
@@ -696,52 +750,38 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 				frameFinished = 0;
 			}
 #else
-			int result = avcodec_decode_video2(m_pCodecCtx, m_pFrame, &frameFinished, &packet);
+			int result = avcodec_decode_video2(codecCtx, out.frame, &frameFinished, &packet);
 #endif
 			if (frameFinished) {
-				if (!m_pFrameRGB) {
-					setVideoDim();
-				}
-				if (m_pFrameRGB && !skipFrame) {
-					updateSwsFormat(videoPixelMode);
-					// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
-					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
-					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
-
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
-				}
-
 #if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(55, 58, 100)
-				int64_t bestPts = m_pFrame->best_effort_timestamp;
-				int64_t ptsDuration = m_pFrame->pkt_duration;
+				int64_t bestPts = out.frame->best_effort_timestamp;
+				int64_t ptsDuration = out.frame->pkt_duration;
 #else
-				int64_t bestPts = av_frame_get_best_effort_timestamp(m_pFrame);
-				int64_t ptsDuration = av_frame_get_pkt_duration(m_pFrame);
+				int64_t bestPts = av_frame_get_best_effort_timestamp(out.frame);
+				int64_t ptsDuration = av_frame_get_pkt_duration(out.frame);
 #endif
 				if (ptsDuration == 0) {
-					if (m_lastPts == bestPts - m_firstTimeStamp || bestPts == AV_NOPTS_VALUE) {
+					if (lastPts == bestPts - m_firstTimeStamp || bestPts == AV_NOPTS_VALUE) {
 						// TODO: Assuming 29.97 if missing.
-						m_videopts += 3003;
+						videopts += 3003;
 					} else {
-						m_videopts = bestPts - m_firstTimeStamp;
-						m_lastPts = m_videopts;
+						videopts = bestPts - m_firstTimeStamp;
+						lastPts = videopts;
 					}
 				} else if (bestPts != AV_NOPTS_VALUE) {
-					m_videopts = bestPts + ptsDuration - m_firstTimeStamp;
-					m_lastPts = m_videopts;
+					videopts = bestPts + ptsDuration - m_firstTimeStamp;
+					lastPts = videopts;
 				} else {
-					m_videopts += ptsDuration;
-					m_lastPts = m_videopts;
+					videopts += ptsDuration;
+					lastPts = videopts;
 				}
 				bGetFrame = true;
 			}
 			if (result <= 0 && dataEnd) {
 				// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
 				// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
-				m_isVideoEnd = !bGetFrame && (m_pdata->getQueueSize() == 0);
-				if (m_isVideoEnd)
-					m_decodingsize = 0;
+				out.endChecked = true;
+				out.videoEnd = !bGetFrame && pendingStreamBytes() == 0;
 				break;
 			}
 		}
@@ -751,7 +791,264 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 		av_free_packet(&packet);
 #endif
 	}
+	out.gotFrame = bGetFrame;
+	out.videopts = videopts;
+	out.lastPts = lastPts;
 	return bGetFrame;
+}
+
+int MediaEngine::pendingStreamBytes() {
+	if (m_aheadFrame) {
+		std::lock_guard<std::mutex> guard(m_aheadLock);
+		return m_pdata->getQueueSize() - m_aheadCursor;
+	}
+	return m_pdata->getQueueSize();
+}
+
+bool MediaEngine::canDecodeAhead() const {
+	// With several video streams, the game may switch between them, and the demuxer
+	// drops packets for streams other than the current one.
+	return g_Config.bVideoDecodeAhead && !m_aheadBroken && m_pFormatCtx && m_expectedVideoStreams <= 1;
+}
+
+void MediaEngine::startDecodeAhead(int videoPixelMode) {
+	m_aheadCursor = 0;
+	m_aheadHeaderPos = m_mpegheaderReadPos;
+	m_aheadVideopts = m_videopts;
+	m_aheadLastPts = m_lastPts;
+	m_aheadPixelMode = videoPixelMode;
+	m_aheadStop = false;
+	m_aheadRelease = false;
+	m_aheadPaused = false;
+	m_aheadThread = std::thread([this] { decodeAheadThread(); });
+}
+
+void MediaEngine::stopDecodeAhead() {
+	if (!m_aheadThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_aheadLock);
+		m_aheadStop = true;
+	}
+	m_aheadCond.notify_all();
+	m_aheadThread.join();
+
+	for (auto &frame : m_aheadQueue)
+		freeDecodedFrame(frame);
+	m_aheadQueue.clear();
+	m_aheadCursor = 0;
+	m_aheadStop = false;
+	m_aheadRelease = false;
+
+	sws_freeContext(m_aheadSwsCtx);
+	m_aheadSwsCtx = nullptr;
+	m_aheadSwsFmt = -1;
+}
+
+void MediaEngine::abandonDecodeAhead() {
+	if (!m_aheadThread.joinable())
+		return;
+
+	// The demuxer has already read past what the game consumed, so we have to restart
+	// it from the committed position, just like loading a savestate would.
+	WARN_LOG(ME, "Video stream layout changed during playback, disabling decode-ahead");
+	closeContext();
+	AudioClose(&m_audioContext);
+	m_aheadBroken = true;
+	openContext(true);
+}
+
+void MediaEngine::freeDecodedFrame(DecodedFrame &frame) {
+	if (frame.frame)
+		av_frame_free(&frame.frame);
+	if (frame.rgb)
+		av_free(frame.rgb);
+	frame.rgb = nullptr;
+}
+
+int MediaEngine::readAhead(u8 *buf, int buf_size) {
+	DecodedFrame *frame = m_aheadFrame;
+	if (m_aheadHeaderPos < m_mpegheaderSize) {
+		int size = std::min(buf_size, m_mpegheaderSize - m_aheadHeaderPos);
+		memcpy(buf, m_mpegheader + m_aheadHeaderPos, size);
+		m_aheadHeaderPos += size;
+		frame->headerBytes += size;
+		return size;
+	}
+
+	std::unique_lock<std::mutex> guard(m_aheadLock);
+	// Only do short reads once the game is waiting on this frame.  That way, we read exactly
+	// what a synchronous decode would have at that point, and the result stays the same.
+	while (!m_aheadStop && !m_aheadRelease && m_pdata->getQueueSize() - m_aheadCursor < buf_size)
+		m_aheadCond.wait(guard);
+	if (m_aheadStop)
+		return 0;
+
+	int size = m_pdata->get_at(m_aheadCursor, buf, buf_size);
+	m_aheadCursor += size;
+	frame->streamBytes += size;
+	if (size > 0)
+		frame->decodingSize = size;
+	return size;
+}
+
+void MediaEngine::decodeAheadThread() {
+	SetCurrentThreadName("MediaDecodeAhead");
+
+	std::unique_lock<std::mutex> guard(m_aheadLock);
+	while (!m_aheadStop) {
+		// After a failed decode, wait until the game has seen it before trying again.
+		if (m_aheadQueue.size() >= MAX_DECODE_AHEAD_FRAMES || (m_aheadPaused && !m_aheadQueue.empty())) {
+			m_aheadCond.wait(guard);
+			continue;
+		}
+		guard.unlock();
+
+		DecodedFrame frame;
+		frame.frame = av_frame_alloc();
+		{
+			std::lock_guard<std::mutex> decodeGuard(m_decodeLock);
+			auto codecIter = m_pCodecCtxs.find(m_videoStream);
+			if (codecIter != m_pCodecCtxs.end()) {
+				m_aheadFrame = &frame;
+				decodeFrame(codecIter->second, frame, m_aheadVideopts, m_aheadLastPts);
+				m_aheadFrame = nullptr;
+			} else {
+				frame.endChecked = true;
+			}
+		}
+
+		const AVFrame *decoded = frame.frame;
+		if (frame.gotFrame && decoded->width > 0 && decoded->height > 0) {
+			int pixelMode = m_aheadPixelMode;
+			AVPixelFormat swsFmt = getSwsFormat(pixelMode);
+			SwsContext *sws_ctx = sws_getCachedContext(m_aheadSwsCtx, decoded->width, decoded->height, (AVPixelFormat)decoded->format,
+				decoded->width, decoded->height, swsFmt, SWS_BILINEAR, NULL, NULL, NULL);
+			if (sws_ctx != m_aheadSwsCtx || swsFmt != m_aheadSwsFmt) {
+				setSwsFullRange(sws_ctx);
+				m_aheadSwsCtx = sws_ctx;
+				m_aheadSwsFmt = swsFmt;
+			}
+			if (sws_ctx) {
+				frame.rgb = (u8 *)av_malloc(decoded->width * decoded->height * sizeof(u32));
+				frame.rgbPixelMode = pixelMode;
+				frame.rgbWidth = decoded->width;
+				frame.rgbHeight = decoded->height;
+				uint8_t *planes[4] = { frame.rgb };
+				int linesizes[4] = { getPixelFormatBytes(pixelMode) * decoded->width };
+				sws_scale(sws_ctx, decoded->data, decoded->linesize, 0, decoded->height, planes, linesizes);
+			}
+		}
+
+		guard.lock();
+		if (m_aheadStop) {
+			freeDecodedFrame(frame);
+			break;
+		}
+		m_aheadPaused = !frame.gotFrame;
+		m_aheadRelease = false;
+		m_aheadQueue.push_back(frame);
+		m_aheadDoneCond.notify_all();
+	}
+}
+
+bool MediaEngine::commitDecodedFrame(DecodedFrame &frame, int videoPixelMode, bool skipFrame) {
+	{
+		std::lock_guard<std::mutex> guard(m_aheadLock);
+		m_pdata->pop_front(0, frame.streamBytes);
+		m_aheadCursor -= frame.streamBytes;
+	}
+	m_mpegheaderReadPos += frame.headerBytes;
+	if (frame.decodingSize >= 0)
+		m_decodingsize = frame.decodingSize;
+
+	if (frame.gotFrame) {
+		av_frame_unref(m_pFrame);
+		av_frame_move_ref(m_pFrame, frame.frame);
+		m_videopts = frame.videopts;
+		m_lastPts = frame.lastPts;
+
+		if (!m_pFrameRGB) {
+			std::lock_guard<std::mutex> decodeGuard(m_decodeLock);
+			setVideoDim();
+		}
+		if (m_pFrameRGB && !skipFrame) {
+			if (frame.rgb && frame.rgbPixelMode == videoPixelMode && frame.rgbWidth == m_desWidth && frame.rgbHeight == m_desHeight) {
+				// Already scaled on the worker, just take over its buffer.
+				av_free(m_buffer);
+				m_buffer = frame.rgb;
+				frame.rgb = nullptr;
+				m_pFrameRGB->data[0] = m_buffer;
+				m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+			} else {
+				std::lock_guard<std::mutex> decodeGuard(m_decodeLock);
+				scaleVideoFrame(videoPixelMode);
+			}
+		}
+	}
+
+	if (frame.endChecked) {
+		m_isVideoEnd = frame.videoEnd;
+		if (m_isVideoEnd)
+			m_decodingsize = 0;
+	}
+	return frame.gotFrame;
+}
+#endif // USE_FFMPEG
+
+bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
+#ifdef USE_FFMPEG
+	auto codecIter = m_pCodecCtxs.find(m_videoStream);
+	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+
+	if (!m_pFormatCtx)
+		return false;
+	if (!m_pCodecCtx)
+		return false;
+	if (!m_pFrame)
+		return false;
+
+	if (m_aheadThread.joinable() || canDecodeAhead()) {
+		if (!m_aheadThread.joinable())
+			startDecodeAhead(videoPixelMode);
+		m_aheadPixelMode = videoPixelMode;
+
+		DecodedFrame frame;
+		{
+			std::unique_lock<std::mutex> guard(m_aheadLock);
+			if (m_aheadQueue.empty()) {
+				// Let the worker finish this frame with whatever data we have, like we would have inline.
+				m_aheadRelease = true;
+				m_aheadCond.notify_all();
+				m_aheadDoneCond.wait(guard, [this] { return !m_aheadQueue.empty(); });
+			}
+			frame = m_aheadQueue.front();
+			m_aheadQueue.pop_front();
+		}
+		m_aheadCond.notify_all();
+
+		bool gotFrame = commitDecodedFrame(frame, videoPixelMode, skipFrame);
+		freeDecodedFrame(frame);
+		return gotFrame;
+	}
+
+	DecodedFrame decoded;
+	decoded.frame = m_pFrame;
+	if (decodeFrame(m_pCodecCtx, decoded, m_videopts, m_lastPts)) {
+		if (!m_pFrameRGB) {
+			setVideoDim();
+		}
+		if (m_pFrameRGB && !skipFrame) {
+			scaleVideoFrame(videoPixelMode);
+		}
+	}
+	if (decoded.endChecked) {
+		m_isVideoEnd = decoded.videoEnd;
+		if (m_isVideoEnd)
+			m_decodingsize = 0;
+	}
+	return decoded.gotFrame;
 #else
 	// If video engine is not available, just add to the timestamp at least.
 	m_videopts += 3003;
@@ -762,12 +1059,47 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 // Helpers that null out alpha (which seems to be the case on the PSP.)
 // Some games depend on this, for example Sword Art Online (doesn't clear A's from buffer.)
 inline void writeVideoLineRGBA(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON, investigate why AV_PIX_FMT_RGB0 does not work.
+	// TODO: Investigate why AV_PIX_FMT_RGB0 does not work.
 	u32_le *dest = (u32_le *)destp;
-	const u32_le *src = (u32_le *)srcp;
+	const u32_le *src = (const u32_le *)srcp;
 
 	const u32 mask = 0x00FFFFFF;
-	for (int i = 0; i < width; ++i) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i maskx4 = _mm_set1_epi32(mask);
+	for (; i + 4 <= width; i += 4) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_and_si128(pixels, maskx4));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint32x4_t maskx4 = vdupq_n_u32(mask);
+	for (; i + 4 <= width; i += 4) {
+		vst1q_u32((uint32_t *)(dest + i), vandq_u32(vld1q_u32((const uint32_t *)(src + i)), maskx4));
+	}
+#endif
+	for (; i < width; ++i) {
+		dest[i] = src[i] & mask;
+	}
+}
+
+inline void writeVideoLineMasked16(void *destp, const void *srcp, int width, u16 mask) {
+	u16_le *dest = (u16_le *)destp;
+	const u16_le *src = (const u16_le *)srcp;
+
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i maskx8 = _mm_set1_epi16((short)mask);
+	for (; i + 8 <= width; i += 8) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_and_si128(pixels, maskx8));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t maskx8 = vdupq_n_u16(mask);
+	for (; i + 8 <= width; i += 8) {
+		vst1q_u16((uint16_t *)(dest + i), vandq_u16(vld1q_u16((const uint16_t *)(src + i)), maskx8));
+	}
+#endif
+	for (; i < width; ++i) {
 		dest[i] = src[i] & mask;
 	}
 }
@@ -777,25 +1109,11 @@ inline void writeVideoLineABGR5650(void *destp, const void *srcp, int width) {
 }
 
 inline void writeVideoLineABGR5551(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON.
-	u16_le *dest = (u16_le *)destp;
-	const u16_le *src = (u16_le *)srcp;
-
-	const u16 mask = 0x7FFF;
-	for (int i = 0; i < width; ++i) {
-		dest[i] = src[i] & mask;
-	}
+	writeVideoLineMasked16(destp, srcp, width, 0x7FFF);
 }
 
 inline void writeVideoLineABGR4444(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON.
-	u16_le *dest = (u16_le *)destp;
-	const u16_le *src = (u16_le *)srcp;
-
-	const u16 mask = 0x0FFF;
-	for (int i = 0; i < width; ++i) {
-		dest[i] = src[i] & mask;
-	}
+	writeVideoLineMasked16(destp, srcp, width, 0x0FFF);
 }
 
 int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMode) {
@@ -24,7 +24,13 @@
 
 // An approximation of what the interface will look like. Similar to JPCSP's.
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
+
 #include "Common/CommonTypes.h"
 #include "Core/HLE/sceMpeg.h"
 #include "Core/HW/MpegDemux.h"
@@ -98,8 +104,42 @@ class MediaEngine
 	bool SetupStreams();
 	bool setVideoDim(int width = 0, int height = 0);
 	void updateSwsFormat(int videoPixelMode);
+	void scaleVideoFrame(int videoPixelMode);
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2);
 
+#ifdef USE_FFMPEG
+	// Result of decoding one frame, either inline or on the decode-ahead thread.
+	struct DecodedFrame {
+		AVFrame *frame = nullptr;
+		// Only from the decode-ahead thread: the frame scaled to rgbPixelMode, or null.
+		// Always allocated at 32-bit size, so it can replace m_buffer.
+		u8 *rgb = nullptr;
+		int rgbPixelMode = -1;
+		int rgbWidth = 0;
+		int rgbHeight = 0;
+		// What the decode consumed, applied when the frame is handed to the game.
+		int headerBytes = 0;
+		int streamBytes = 0;
+		int decodingSize = -1;
+		s64 videopts = 0;
+		s64 lastPts = -1;
+		bool gotFrame = false;
+		bool endChecked = false;
+		bool videoEnd = false;
+	};
+
+	bool decodeFrame(AVCodecContext *codecCtx, DecodedFrame &out, s64 &videopts, s64 &lastPts);
+	int pendingStreamBytes();
+
+	bool canDecodeAhead() const;
+	void startDecodeAhead(int videoPixelMode);
+	void stopDecodeAhead();
+	void abandonDecodeAhead();
+	void decodeAheadThread();
+	bool commitDecodedFrame(DecodedFrame &frame, int videoPixelMode, bool skipFrame);
+	static void freeDecodedFrame(DecodedFrame &frame);
+#endif
+
 public:  // TODO: Very little of this below should be public.
 
 	// Video ffmpeg context - not used for audio
@@ -144,4 +184,30 @@ class MediaEngine
 
 	// used for audio type 
 	int m_audioType;
+
+#ifdef USE_FFMPEG
+	// Decode-ahead state.  The worker only peeks at m_pdata (at m_aheadCursor), the
+	// game-visible state (m_pdata, pts, header read pos) only changes on commit.
+	int readAhead(u8 *buf, int buf_size);
+
+	std::thread m_aheadThread;
+	std::mutex m_aheadLock;
+	// Held by whoever is inside the ffmpeg decoder (codec context, format context.)
+	std::mutex m_decodeLock;
+	std::condition_variable m_aheadCond;
+	std::condition_variable m_aheadDoneCond;
+	std::deque<DecodedFrame> m_aheadQueue;
+	DecodedFrame *m_aheadFrame = nullptr;
+	SwsContext *m_aheadSwsCtx = nullptr;
+	int m_aheadSwsFmt = -1;
+	std::atomic<int> m_aheadPixelMode;
+	int m_aheadCursor = 0;
+	int m_aheadHeaderPos = 0;
+	s64 m_aheadVideopts = 0;
+	s64 m_aheadLastPts = -1;
+	bool m_aheadStop = false;
+	bool m_aheadRelease = false;
+	bool m_aheadPaused = false;
+	bool m_aheadBroken = false;
+#endif
 };
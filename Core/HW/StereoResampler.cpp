@@ -221,6 +221,7 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 			// int missing = numSamples * 2 - currentSample;
 			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
 			underrunCount_++;
+			underrunsSinceTake_++;
 			break;
 		}
 		u32 indexR2 = indexR + 2; //next sample
@@ -333,6 +334,10 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 	// }
 }
 
+int StereoResampler::TakeUnderrunCount() {
+	return underrunsSinceTake_.exchange(0);
+}
+
 void StereoResampler::ResetStatCounters() {
 	underrunCount_ = 0;
 	overrunCount_ = 0;
@@ -45,6 +45,8 @@ class StereoResampler {
 
 	void GetAudioDebugStats(char *buf, size_t bufSize);
 	void ResetStatCounters();
+	// Underruns since the last call, safe to use from the emu thread.
+	int TakeUnderrunCount();
 
 private:
 	void UpdateBufferSize();
@@ -68,6 +70,7 @@ class StereoResampler {
 	int overrunCount_ = 0;
 	int underrunCountTotal_ = 0;
 	int overrunCountTotal_ = 0;
+	std::atomic<int> underrunsSinceTake_{};
 
 	int droppedSamples_ = 0;
 
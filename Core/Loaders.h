@@ -88,6 +88,11 @@ class FileLoader {
 	virtual std::string LatestError() const {
 		return "";
 	}
+
+	// If the whole file is mapped into memory, returns it so callers can copy without ReadAt.
+	virtual const u8 *MappedData() {
+		return nullptr;
+	}
 };
 
 class ProxiedFileLoader : public FileLoader {
@@ -23,9 +23,11 @@
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
@@ -38,6 +40,7 @@
 #include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
 
 namespace MIPSComp {
 
@@ -220,21 +223,36 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 		if (coreState != 0) {
 			break;
 		}
+		// The last block run, so we can link its exit to wherever it went.
+		int lastBlock = -1;
 		while (mips_->downcount >= 0) {
 			u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
 			u32 opcode = inst & 0xFF000000;
 			if (opcode == MIPS_EMUHACK_OPCODE) {
-				u32 data = inst & 0xFFFFFF;
-				IRBlock *block = blocks_.GetBlock(data);
-				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				int blockNum = inst & 0xFFFFFF;
+				if (lastBlock != -1) {
+					blocks_.LinkExit(lastBlock, mips_->pc, blockNum);
+				}
+				// Keep following linked exits, only going back to memory when there isn't one.
+				do {
+					IRBlock *block = blocks_.GetBlock(blockNum);
+					mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+					lastBlock = blockNum;
+					// Links only depend on the target block, so they stay good even if this one was destroyed while running.
+					blockNum = blocks_.GetLinkedExit(lastBlock, mips_->pc);
+				} while (blockNum != -1 && mips_->downcount >= 0);
 				if (!Memory::IsValidAddress(mips_->pc)) {
 					Core_ExecException(mips_->pc, mips_->pc, ExecExceptionType::JUMP);
 					break;
 				}
 			} else {
 				// RestoreRoundingMode(true);
+				double start = coreCollectDebugStats ? time_now_d() : 0.0;
 				Compile(mips_->pc);
+				if (start != 0.0)
+					kernelStats.msInJitCompiler += time_now_d() - start;
 				// ApplyRoundingMode(true);
+				lastBlock = -1;
 			}
 		}
 	}
@@ -247,6 +265,7 @@ bool IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	return false;
 }
 
+// IR blocks have no native exit code to patch, they're linked through IRBlockCache::LinkExit() instead.
 void IRJit::LinkBlock(u8 *exitPoint, const u8 *checkedEntry) {
 	Crash();
 }
@@ -266,6 +285,7 @@ void IRBlockCache::Clear() {
 	}
 	blocks_.clear();
 	byPage_.clear();
+	linksTo_.clear();
 }
 
 void IRBlockCache::InvalidateICache(u32 address, u32 length) {
@@ -280,13 +300,38 @@ void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 		const std::vector<int> &blocksInPage = iter->second;
 		for (int i : blocksInPage) {
 			if (blocks_[i].OverlapsRange(address, length)) {
+				u32 start, size;
+				blocks_[i].GetRange(start, size);
 				// Not removing from the page, hopefully doesn't build up with small recompiles.
 				blocks_[i].Destroy(i);
+				// Anything jumping straight here must go back to checking memory.
+				UnlinkExitsTo(start);
 			}
 		}
 	}
 }
 
+void IRBlockCache::LinkExit(int i, u32 dest, int target) {
+	IRBlock *source = GetBlock(i);
+	IRBlock *block = GetBlock(target);
+	if (!source || !block || !block->IsValid()) {
+		return;
+	}
+	u32 start, size;
+	block->GetRange(start, size);
+	if (start == dest && source->LinkExit(dest, target)) {
+		linksTo_.insert(std::make_pair(dest, i));
+	}
+}
+
+void IRBlockCache::UnlinkExitsTo(u32 dest) {
+	auto range = linksTo_.equal_range(dest);
+	for (auto it = range.first; it != range.second; ++it) {
+		blocks_[it->second].UnlinkExit(dest);
+	}
+	linksTo_.erase(range.first, range.second);
+}
+
 void IRBlockCache::FinalizeBlock(int i, bool preload) {
 	if (!preload) {
 		blocks_[i].Finalize(i);
@@ -469,6 +514,51 @@ void IRBlock::Destroy(int number) {
 	}
 }
 
+void IRBlock::FindStaticExits() {
+	int count = 0;
+	for (int i = 0; i < numInstructions_ && count < MAX_LINKED_EXITS; ++i) {
+		switch (instr_[i].op) {
+		case IROp::ExitToConst:
+		case IROp::ExitToConstIfEq:
+		case IROp::ExitToConstIfNeq:
+		case IROp::ExitToConstIfGtZ:
+		case IROp::ExitToConstIfGeZ:
+		case IROp::ExitToConstIfLtZ:
+		case IROp::ExitToConstIfLeZ:
+		case IROp::ExitToConstIfFpTrue:
+		case IROp::ExitToConstIfFpFalse:
+			if (count == 0 || exits_[0].dest != instr_[i].constant) {
+				exits_[count].dest = instr_[i].constant;
+				exits_[count].block = -1;
+				count++;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+bool IRBlock::LinkExit(u32 dest, int block) {
+	for (Exit &exit : exits_) {
+		if (exit.dest == dest && dest != 0) {
+			if (exit.block == block)
+				return false;
+			exit.block = block;
+			return true;
+		}
+	}
+	return false;
+}
+
+void IRBlock::UnlinkExit(u32 dest) {
+	for (Exit &exit : exits_) {
+		if (exit.dest == dest)
+			exit.block = -1;
+	}
+}
+
 u64 IRBlock::CalculateHash() const {
 	if (origAddr_) {
 		// This is unfortunate.  In case of emuhacks, we have to make a copy.
@@ -47,6 +47,7 @@ class IRBlock {
 		origSize_ = b.origSize_;
 		origFirstOpcode_ = b.origFirstOpcode_;
 		hash_ = b.hash_;
+		memcpy(exits_, b.exits_, sizeof(exits_));
 		b.instr_ = nullptr;
 	}
 
@@ -60,6 +61,7 @@ class IRBlock {
 		if (!inst.empty()) {
 			memcpy(instr_, &inst[0], sizeof(IRInst) * inst.size());
 		}
+		FindStaticExits();
 	}
 
 	const IRInst *GetInstructions() const { return instr_; }
@@ -87,8 +89,29 @@ class IRBlock {
 	void Finalize(int number);
 	void Destroy(int number);
 
+	// Block number already known to be at dest, if dest is a static exit of this block, or -1.
+	int GetLinkedExit(u32 dest) const {
+		for (const Exit &exit : exits_) {
+			if (exit.dest == dest && dest != 0)
+				return exit.block;
+		}
+		return -1;
+	}
+	bool LinkExit(u32 dest, int block);
+	void UnlinkExit(u32 dest);
+
 private:
 	u64 CalculateHash() const;
+	void FindStaticExits();
+
+	// Constant branch targets, cached with the block compiled there once it's been run.
+	struct Exit {
+		u32 dest = 0;
+		int block = -1;
+	};
+	enum {
+		MAX_LINKED_EXITS = 2,
+	};
 
 	IRInst *instr_;
 	u16 numInstructions_;
@@ -96,6 +119,7 @@ class IRBlock {
 	u32 origSize_;
 	u64 hash_ = 0;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
+	Exit exits_[MAX_LINKED_EXITS];
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
@@ -119,6 +143,14 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 	int FindPreloadBlock(u32 em_address);
 
+	// Lets block i go straight to block target when it exits to dest, without checking memory.
+	void LinkExit(int i, u32 dest, int target);
+	int GetLinkedExit(int i, u32 dest) const {
+		if (i >= 0 && i < (int)blocks_.size())
+			return blocks_[i].GetLinkedExit(dest);
+		return -1;
+	}
+
 	std::vector<u32> SaveAndClearEmuHackOps();
 	void RestoreSavedEmuHackOps(std::vector<u32> saved);
 
@@ -128,9 +160,12 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 private:
 	u32 AddressToPage(u32 addr) const;
+	void UnlinkExitsTo(u32 dest);
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+	// Blocks with a linked exit, by exit address.
+	std::unordered_multimap<u32, int> linksTo_;
 };
 
 class IRJit : public JitInterface {
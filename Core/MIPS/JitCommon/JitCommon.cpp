@@ -24,9 +24,12 @@
 #include "Common/StringUtils.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/TimeUtil.h"
 
 #include "Core/Util/DisArm64.h"
 #include "Core/Config.h"
+#include "Core/System.h"
+#include "Core/HLE/sceKernel.h"
 
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -47,7 +50,10 @@
 namespace MIPSComp {
 	JitInterface *jit;
 	void JitAt() {
+		double start = coreCollectDebugStats ? time_now_d() : 0.0;
 		jit->Compile(currentMIPS->pc);
+		if (start != 0.0)
+			kernelStats.msInJitCompiler += time_now_d() - start;
 	}
 
 	void DoDummyJitState(PointerWrap &p) {
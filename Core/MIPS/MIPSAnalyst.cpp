@@ -1309,6 +1309,17 @@ namespace MIPSAnalyst {
 		return 0;
 	}
 
+	bool GetFunctionAt(u32 startAddr, AnalyzedFunction *result) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		for (const AnalyzedFunction &f : functions) {
+			if (f.start == startAddr) {
+				*result = f;
+				return true;
+			}
+		}
+		return false;
+	}
+
 	void SetHashMapFilename(const std::string& filename) {
 		if (filename.empty())
 			hashmapFileName = GetSysDirectory(DIRECTORY_SYSTEM) / "knownfuncs.ini";
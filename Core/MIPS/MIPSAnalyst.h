@@ -119,6 +119,8 @@ namespace MIPSAnalyst
 	void StoreHashMap(Path filename = Path());
 
 	const char *LookupHash(u64 hash, u32 funcSize);
+	// Copies the analyzed function that starts at startAddr, returns false if there's none.
+	bool GetFunctionAt(u32 startAddr, AnalyzedFunction *result);
 	void ReplaceFunctions();
 
 	void UpdateHashMap();
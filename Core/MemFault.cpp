@@ -17,8 +17,12 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <unordered_set>
+#include <vector>
 
 #include "Common/MachineContext.h"
 
@@ -32,7 +36,10 @@
 #endif
 
 #include "Common/Log.h"
+#include "Common/MemoryUtil.h"
 #include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/Debugger/Breakpoints.h"
 #include "Core/MemFault.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
@@ -45,11 +52,153 @@ MemoryExceptionType g_lastMemoryExceptionType;
 
 std::unordered_set<const uint8_t *> g_ignoredAddresses;
 
+// Watch state of each page of main RAM, indexed from the kernel base.  The fault handler
+// can't take locks, so it only reads and flags these.
+enum : uint8_t {
+	WATCH_NONE = 0,
+	WATCH_WRITES = 1,
+	// Reads and writes.
+	WATCH_READS = 2,
+	// Opened up after a fault, waiting for MemFault_ProcessWatchpoints().
+	WATCH_OPENED = 0x80,
+};
+// Enough for the largest RAM size with the smallest page size.
+static const u32 MAX_WATCH_PAGES = 0x04000000 / 4096;
+static std::atomic<uint8_t> g_watchState[MAX_WATCH_PAGES];
+
+// Serializes changes to the watched pages, but isn't taken by the fault handler.
+static std::mutex g_watchLock;
+static std::vector<u32> g_watchedPages;
+static std::atomic<bool> g_anyWatchedPages(false);
+static std::atomic<bool> g_watchRearmPending(false);
+
+// Hits are only recorded by the fault handler, and reported from the emu thread afterward.
+// Jitted code only runs on the emu thread, so there's a single producer and consumer.
+struct WatchpointHit {
+	u32 address;
+	u32 pc;
+	int size;
+	bool write;
+};
+static const int MAX_PENDING_HITS = 32;
+static WatchpointHit g_pendingHits[MAX_PENDING_HITS];
+static std::atomic<int> g_numPendingHits(0);
+static std::atomic<int> g_numDroppedHits(0);
+
+static u32 WatchPageAddress(u32 index) {
+	return PSP_GetKernelMemoryBase() + index * (u32)GetMemoryProtectPageSize();
+}
+
+static void ProtectWatchedPage(u32 index, uint8_t state) {
+	ProtectRAMPages(WatchPageAddress(index), GetMemoryProtectPageSize(), (state & WATCH_READS) ? 0 : MEM_PROT_READ);
+}
+
+// Must hold g_watchLock.
+static void UnprotectAllWatchedPages() {
+	for (u32 index : g_watchedPages) {
+		ProtectRAMPages(WatchPageAddress(index), GetMemoryProtectPageSize(), MEM_PROT_READ | MEM_PROT_WRITE);
+		g_watchState[index] = WATCH_NONE;
+	}
+	g_watchedPages.clear();
+	g_anyWatchedPages = false;
+	g_watchRearmPending = false;
+}
+
 void MemFault_Init() {
 	g_numReportedBadAccesses = 0;
 	g_lastCrashAddress = nullptr;
 	g_lastMemoryExceptionType = MemoryExceptionType::NONE;
 	g_ignoredAddresses.clear();
+
+	// The views are new, so nothing is protected anymore.
+	{
+		std::lock_guard<std::mutex> guard(g_watchLock);
+		for (u32 index : g_watchedPages)
+			g_watchState[index] = WATCH_NONE;
+		g_watchedPages.clear();
+		g_anyWatchedPages = false;
+		g_watchRearmPending = false;
+		g_numPendingHits = 0;
+		g_numDroppedHits = 0;
+	}
+	CBreakPoints::UpdateMemCheckProtection();
+}
+
+bool MemFault_ProtectWatchpoints(const std::vector<MemCheck> &checks) {
+#ifdef MACHINE_CONTEXT_SUPPORTED
+	if (!IsActive())
+		return false;
+
+	const u32 pageSize = GetMemoryProtectPageSize();
+	std::vector<std::pair<u32, uint8_t>> pages;
+	for (const MemCheck &check : checks) {
+		if (check.cond & MEMCHECK_WRITE_ONCHANGE)
+			return false;
+		u32 start = check.start & 0x3FFFFFFF;
+		u32 end = check.end != 0 ? (check.end & 0x3FFFFFFF) : start + 1;
+		if (!IsRAMAddress(start) || !IsRAMAddress(end - 1) || end <= start)
+			return false;
+
+		uint8_t state = (check.cond & MEMCHECK_READ) ? WATCH_READS : WATCH_WRITES;
+		u32 first = (start - PSP_GetKernelMemoryBase()) / pageSize;
+		u32 last = (end - 1 - PSP_GetKernelMemoryBase()) / pageSize;
+		if (last >= MAX_WATCH_PAGES)
+			return false;
+		for (u32 index = first; index <= last; ++index)
+			pages.push_back(std::make_pair(index, state));
+	}
+
+	std::lock_guard<std::mutex> guard(g_watchLock);
+	UnprotectAllWatchedPages();
+	for (const auto &page : pages) {
+		// Any read check on a page means reads must fault too.
+		uint8_t prev = g_watchState[page.first];
+		if (prev == WATCH_NONE)
+			g_watchedPages.push_back(page.first);
+		g_watchState[page.first] = std::max(prev, page.second);
+	}
+	for (u32 index : g_watchedPages)
+		ProtectWatchedPage(index, g_watchState[index]);
+	g_anyWatchedPages = !g_watchedPages.empty();
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MemFault_UnprotectWatchpoints() {
+	std::lock_guard<std::mutex> guard(g_watchLock);
+	UnprotectAllWatchedPages();
+}
+
+void MemFault_ProcessWatchpoints() {
+	int numHits = g_numPendingHits;
+	if (numHits != 0) {
+		WatchpointHit hits[MAX_PENDING_HITS];
+		std::copy(g_pendingHits, g_pendingHits + numHits, hits);
+		g_numPendingHits = 0;
+		int dropped = g_numDroppedHits.exchange(0);
+		if (dropped != 0)
+			WARN_LOG(MEMMAP, "Missed %d watchpoint hits in one slice", dropped);
+		for (int i = 0; i < numHits; ++i) {
+			// The pc is only approximate in jitted code.
+			CBreakPoints::ExecMemCheck(hits[i].address, hits[i].write, hits[i].size, hits[i].pc, "CPU");
+		}
+	}
+
+	if (!g_watchRearmPending)
+		return;
+
+	std::lock_guard<std::mutex> guard(g_watchLock);
+	g_watchRearmPending = false;
+	for (u32 index : g_watchedPages) {
+		uint8_t state = g_watchState[index];
+		if (state & WATCH_OPENED) {
+			state &= ~WATCH_OPENED;
+			g_watchState[index] = state;
+			ProtectWatchedPage(index, state);
+		}
+	}
 }
 
 bool MemFault_MayBeResumable() {
@@ -85,10 +234,88 @@ static bool DisassembleNativeAt(const uint8_t *codePtr, int instructionSize, std
 	return false;
 }
 
+static bool AnalyzeAccess(const uint8_t *codePtr, bool *write, int *size) {
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
+	LSInstructionInfo info{};
+	if (X86AnalyzeMOV(codePtr, info)) {
+		*write = info.isMemoryWrite;
+		*size = info.operandSize / 8;
+		return true;
+	}
+#elif PPSSPP_ARCH(ARM64)
+	uint32_t word;
+	memcpy(&word, codePtr, 4);
+	Arm64LSInstructionInfo info{};
+	if (Arm64AnalyzeLoadStore((uint64_t)codePtr, word, &info)) {
+		*write = info.isMemoryWrite;
+		*size = 1 << info.size;
+		return true;
+	}
+#elif PPSSPP_ARCH(ARM)
+	uint32_t word;
+	memcpy(&word, codePtr, 4);
+	ArmLSInstructionInfo info{};
+	if (ArmAnalyzeLoadStore((uint32_t)codePtr, word, &info)) {
+		*write = info.isMemoryWrite;
+		*size = 1 << info.size;
+		return true;
+	}
+#endif
+	return false;
+}
+
+// Runs inside the fault handler, so this must not lock or allocate.
+static bool HandleWatchpointFault(uint32_t guestAddress, const uint8_t *codePtr) {
+	u32 address = guestAddress & 0x3FFFFFFF;
+	// The uncached kernel view starts at 0xC0000000, not 0xC8000000 (see MemMap.cpp.)
+	if ((guestAddress & 0xC0000000) == 0xC0000000 && address < g_MemorySize)
+		address += PSP_GetKernelMemoryBase();
+
+	u32 offset = address - PSP_GetKernelMemoryBase();
+	if (address < PSP_GetKernelMemoryBase() || offset >= g_MemorySize)
+		return false;
+	u32 index = offset / (u32)GetMemoryProtectPageSize();
+	if (index >= MAX_WATCH_PAGES || g_watchState[index] == WATCH_NONE)
+		return false;
+
+	// Let the access go through, and protect it again next slice.
+	ProtectRAMPages(WatchPageAddress(index), GetMemoryProtectPageSize(), MEM_PROT_READ | MEM_PROT_WRITE);
+	g_watchState[index] |= WATCH_OPENED;
+	g_watchRearmPending = true;
+
+	// Other code (HLE, GPU, savestates) has its own memchecks or none, just let it through.
+	if (MIPSComp::jit && MIPSComp::jit->CodeInRange(codePtr)) {
+		bool write = false;
+		int size = 4;
+		if (AnalyzeAccess(codePtr, &write, &size)) {
+			int n = g_numPendingHits;
+			if (n < MAX_PENDING_HITS) {
+				g_pendingHits[n] = WatchpointHit{ address, currentMIPS->pc, size, write };
+				g_numPendingHits = n + 1;
+			} else {
+				g_numDroppedHits++;
+			}
+		}
+	}
+	return true;
+}
+
 bool HandleFault(uintptr_t hostAddress, void *ctx) {
 	SContext *context = (SContext *)ctx;
 	const uint8_t *codePtr = (uint8_t *)(context->CTX_PC);
 
+	uintptr_t baseAddress = (uintptr_t)base;
+#ifdef MASKED_PSP_MEMORY
+	const uintptr_t addressSpaceSize = 0x40000000ULL;
+#else
+	const uintptr_t addressSpaceSize = 0x100000000ULL;
+#endif
+
+	if (g_anyWatchedPages && hostAddress >= baseAddress && hostAddress < baseAddress + addressSpaceSize) {
+		if (HandleWatchpointFault((uint32_t)(hostAddress - baseAddress), codePtr))
+			return true;
+	}
+
 	// We set this later if we think it can be resumed from.
 	g_lastCrashAddress = nullptr;
 
@@ -99,13 +326,6 @@ bool HandleFault(uintptr_t hostAddress, void *ctx) {
 		return false;
 	}
 
-	uintptr_t baseAddress = (uintptr_t)base;
-#ifdef MASKED_PSP_MEMORY
-	const uintptr_t addressSpaceSize = 0x40000000ULL;
-#else
-	const uintptr_t addressSpaceSize = 0x100000000ULL;
-#endif
-
 	// Check whether hostAddress is within the PSP memory space, which (likely) means it was a guest executable that did the bad access.
 	if (hostAddress < baseAddress || hostAddress >= baseAddress + addressSpaceSize) {
 		// Host address outside - this was a different kind of crash.
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
+
+struct MemCheck;
 
 namespace Memory {
 
@@ -18,4 +21,16 @@ void MemFault_IgnoreLastCrash();
 // just leave it as-is.
 bool HandleFault(uintptr_t hostAddress, void *context);
 
+// Memchecks by page protection, so jitted code doesn't have to check every access.
+// The pages holding the checks are protected in all RAM views.  Faults from jitted code are
+// recorded, and reported to CBreakPoints on the emu thread by MemFault_ProcessWatchpoints().
+// After a hit the page stays open until the next CoreTiming slice, so other accesses to it in
+// the meantime are missed.  Returns false if the checks can't be handled this way (outside
+// main RAM, "on change" checks, or no fault handling on this platform.)
+bool MemFault_ProtectWatchpoints(const std::vector<MemCheck> &checks);
+void MemFault_UnprotectWatchpoints();
+// Reports recorded hits and protects pages again that were opened up after a fault.
+// Call on the emu thread, outside jitted code.
+void MemFault_ProcessWatchpoints();
+
 }
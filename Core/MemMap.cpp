@@ -392,6 +392,22 @@ bool IsActive() {
 	return base != nullptr;
 }
 
+bool ProtectRAMPages(u32 address, u32 size, uint32_t memProtFlags) {
+	u32 offset = (address & 0x3FFFFFFF) - PSP_GetKernelMemoryBase();
+	if (!IsActive() || offset >= g_MemorySize || size > g_MemorySize - offset)
+		return false;
+
+	bool success = true;
+	for (int i = 0; i < num_views; i++) {
+		const MemoryView &view = views[i];
+		if (!(view.flags & MV_IS_PRIMARY_RAM) || !*view.out_ptr || CanIgnoreView(view) || offset + size > view.size)
+			continue;
+		if (!ProtectMemoryPages(*view.out_ptr + offset, size, memProtFlags))
+			success = false;
+	}
+	return success;
+}
+
 // Wanting to avoid include pollution, MemMap.h is included a lot.
 MemoryInitedLock::MemoryInitedLock()
 {
@@ -109,6 +109,9 @@ struct MemoryView
 // Uses a memory arena to set up an emulator-friendly memory map
 bool MemoryMap_Setup(u32 flags);
 void MemoryMap_Shutdown(u32 flags);
+// Changes protection of a RAM range (page aligned) in every view of main RAM, cached or not.
+// Returns false if it's not all within main RAM.
+bool ProtectRAMPages(u32 address, u32 size, uint32_t memProtFlags);
 
 // Init and Shutdown
 bool Init();
@@ -55,6 +55,7 @@
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/HLE/sceAudio.h"
+#include "Core/HLE/sceDisplay.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -391,6 +392,7 @@ void Core_UpdateDebugStats(bool collectStats) {
 		mipsr4k.ClearJitCache();
 	}
 
+	__DisplayAccumulateFrameStats();
 	kernelStats.ResetFrame();
 	gpuStats.ResetFrame();
 }
@@ -519,6 +521,9 @@ void PSP_Shutdown() {
 		MIPSAnalyst::StoreHashMap();
 	}
 #endif
+	if (g_Config.bFuncCycleStats) {
+		Replacement_StoreCycleStats();
+	}
 
 	if (pspIsIniting)
 		Core_NotifyLifecycle(CoreLifecycle::START_COMPLETE);
@@ -20,7 +20,9 @@
 #include <atomic>
 #include <cstring>
 #include <memory>
+#include <sstream>
 #include <png.h>
+#include <zstd.h>
 
 #include "ext/xxhash.h"
 
@@ -29,6 +31,7 @@
 #include "Common/Data/Format/ZIMLoad.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Text/Parsers.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
 #include "Common/Thread/ParallelLoop.h"
@@ -41,7 +44,20 @@
 #include "Core/ELF/ParamSFO.h"
 #include "GPU/Common/TextureDecoder.h"
 
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#include <io.h>
+#elif !PPSSPP_PLATFORM(SWITCH)
+#include <sys/mman.h>
+#endif
+
+#if PPSSPP_PLATFORM(SWITCH)
+#define fseeko fseek
+#endif
+
 static const std::string INI_FILENAME = "textures.ini";
+static const std::string ARCHIVE_FILENAME = "textures.ppk";
+static const std::string NEW_ARCHIVE_EXTENSION = ".new";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
 static const int MAX_MIP_LEVELS = 12;  // 12 should be plenty, 8 is the max mip levels supported by the PSP.
@@ -75,11 +91,58 @@ void TextureReplacer::NotifyConfigChanged() {
 		enabled_ = File::Exists(basePath_) && File::IsDirectory(basePath_);
 	}
 
+	archive_.reset();
+	if (enabled_) {
+		OpenArchive();
+	}
+
 	if (enabled_) {
 		enabled_ = LoadIni();
 	}
 }
 
+// A rebuilt archive is written next to the old one, which may still be open and mapped.  It's moved
+// into place once the old one can be replaced (not until restart on Windows), and used directly until then.
+void TextureReplacer::OpenArchive() {
+	const Path filename = basePath_ / ARCHIVE_FILENAME;
+	const Path newFilename = filename.WithExtraExtension(NEW_ARCHIVE_EXTENSION);
+	Path openFilename = filename;
+	if (File::Exists(newFilename)) {
+		bool replaced = (!File::Exists(filename) || File::Delete(filename)) && File::Rename(newFilename, filename);
+		if (!replaced)
+			openFilename = newFilename;
+	}
+	if (!File::Exists(openFilename))
+		return;
+
+	archive_ = std::make_shared<TextureArchive>();
+	if (!archive_->Open(openFilename)) {
+		archive_.reset();
+	}
+}
+
+bool TextureReplacer::LoadIniFile(IniFile &ini, const std::string &filename) {
+	// Loose files win, so a packed ini can still be tweaked.
+	if (File::Exists(basePath_ / filename)) {
+		return ini.LoadFromVFS((basePath_ / filename).ToString());
+	}
+
+	int index = archive_ ? archive_->Find(filename) : -1;
+	std::vector<uint8_t> data;
+	if (index < 0 || !archive_->Read(index, data)) {
+		return false;
+	}
+	std::istringstream stream(std::string((const char *)data.data(), data.size()));
+	return ini.Load(stream);
+}
+
+bool TextureReplacer::ReplacementExists(const std::string &hashfile) {
+	if (File::Exists(basePath_ / hashfile)) {
+		return true;
+	}
+	return archive_ && archive_->Find(hashfile) >= 0;
+}
+
 bool TextureReplacer::LoadIni() {
 	// TODO: Use crc32c?
 	hash_ = ReplacedTextureHash::QUICK;
@@ -95,10 +158,8 @@ bool TextureReplacer::LoadIni() {
 	// Prevents dumping the mipmaps.
 	ignoreMipmap_ = false;
 
-	if (File::Exists(basePath_ / INI_FILENAME)) {
-		IniFile ini;
-		ini.LoadFromVFS((basePath_ / INI_FILENAME).ToString());
-
+	IniFile ini;
+	if (LoadIniFile(ini, INI_FILENAME)) {
 		if (!LoadIniValues(ini)) {
 			return false;
 		}
@@ -109,7 +170,7 @@ bool TextureReplacer::LoadIni() {
 			if (!overrideFilename.empty() && overrideFilename != INI_FILENAME) {
 				INFO_LOG(G3D, "Loading extra texture ini: %s", overrideFilename.c_str());
 				IniFile overrideIni;
-				overrideIni.LoadFromVFS((basePath_ / overrideFilename).ToString());
+				LoadIniFile(overrideIni, overrideFilename);
 
 				if (!LoadIniValues(overrideIni, true)) {
 					return false;
@@ -399,14 +460,25 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 	for (int i = 0; i < MAX_MIP_LEVELS; ++i) {
 		const std::string hashfile = LookupHashFile(cachekey, hash, i);
 		const Path filename = basePath_ / hashfile;
-		if (hashfile.empty() || !File::Exists(filename)) {
+		if (hashfile.empty()) {
 			// Out of valid mip levels.  Bail out.
 			break;
 		}
+		// Like ini files, loose images win over the archive, so a packed texture can still be tweaked.
+		int archiveIndex = -1;
+		if (!File::Exists(filename)) {
+			archiveIndex = archive_ ? archive_->Find(hashfile) : -1;
+			if (archiveIndex < 0)
+				break;
+		}
 
 		ReplacedTextureLevel level;
 		level.fmt = ReplacedTextureFormat::F_8888;
 		level.file = filename;
+		if (archiveIndex >= 0) {
+			level.archive = archive_;
+			level.archiveIndex = archiveIndex;
+		}
 		bool good = PopulateLevel(level);
 
 		// We pad files that have been hashrange'd so they are the same texture size.
@@ -451,6 +523,10 @@ static ReplacedImageType Identify(FILE *fp) {
 }
 
 bool TextureReplacer::PopulateLevel(ReplacedTextureLevel &level) {
+	if (level.archive) {
+		return level.archive->ImageSize(level.archiveIndex, &level.w, &level.h);
+	}
+
 	bool good = false;
 
 	FILE *fp = File::OpenCFile(level.file, "rb");
@@ -527,7 +603,7 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 	const Path saveFilename = basePath_ / NEW_TEXTURE_DIR / hashfile;
 
 	// If it's empty, it's an ignored hash, we intentionally don't save.
-	if (hashfile.empty() || File::Exists(filename)) {
+	if (hashfile.empty() || ReplacementExists(hashfile)) {
 		// If it exists, must've been decoded and saved as a new texture already.
 		return;
 	}
@@ -848,6 +924,35 @@ void ReplacedTexture::PrepareData(int level) {
 	const ReplacedTextureLevel &info = levels_[level];
 	std::vector<uint8_t> &out = levelData_[level];
 
+	if (info.archive) {
+		int w, h;
+		std::vector<uint8_t> image;
+		if (!info.archive->ImageSize(info.archiveIndex, &w, &h) || !info.archive->Read(info.archiveIndex, image)) {
+			ERROR_LOG(G3D, "Could not load texture replacement: %s - bad archive entry", info.file.c_str());
+			return;
+		}
+		if (w > info.w || h > info.h) {
+			ERROR_LOG(G3D, "Texture replacement changed since header read: %s", info.file.c_str());
+			return;
+		}
+
+		if (w == info.w && h == info.h) {
+			out.swap(image);
+		} else {
+			// Hashrange'd, so pad it out.
+			out.resize(info.w * info.h * 4);
+			for (int y = 0; y < h; ++y) {
+				memcpy(&out[info.w * 4 * y], &image[w * 4 * y], w * 4);
+			}
+		}
+
+		CheckAlphaResult res = CheckAlphaRGBA8888Basic((u32 *)&out[0], info.w, w, h);
+		if (res == CHECKALPHA_ANY || level == 0) {
+			alphaStatus_ = ReplacedTextureAlpha(res);
+		}
+		return;
+	}
+
 	FILE *fp = File::OpenCFile(info.file, "rb");
 	if (!fp) {
 		// Leaving the data sized at zero means failure.
@@ -1026,3 +1131,285 @@ bool TextureReplacer::GenerateIni(const std::string &gameID, Path &generatedFile
 	}
 	return File::Exists(generatedFilename);
 }
+
+bool TextureReplacer::GenerateArchive(const std::string &gameID, Path &generatedFilename) {
+	if (gameID.empty())
+		return false;
+
+	Path texturesDirectory = GetSysDirectory(DIRECTORY_TEXTURES) / gameID;
+	if (!File::Exists(texturesDirectory))
+		return false;
+
+	// The current archive may be open, so write next to it and let OpenArchive() move it into place.
+	generatedFilename = (texturesDirectory / ARCHIVE_FILENAME).WithExtraExtension(NEW_ARCHIVE_EXTENSION);
+	return TextureArchive::Build(texturesDirectory, generatedFilename);
+}
+
+static const char ARCHIVE_MAGIC[4] = { 'P', 'P', 'T', 'A' };
+static const u32 ARCHIVE_VERSION = 1;
+// Decompression speed barely depends on the level, so we can afford a decent one when packing.
+static const int ARCHIVE_COMPRESSION_LEVEL = 9;
+
+struct TextureArchiveHeader {
+	char magic[4];
+	u32 version;
+	u32 numEntries;
+	u32 reserved;
+	u64 indexOffset;
+};
+
+TextureArchive::~TextureArchive() {
+#if PPSSPP_PLATFORM(WINDOWS)
+	if (mapped_)
+		UnmapViewOfFile(mapped_);
+	if (mapping_)
+		CloseHandle((HANDLE)mapping_);
+#elif !PPSSPP_PLATFORM(SWITCH)
+	if (mapped_)
+		munmap((void *)mapped_, mappedSize_);
+#endif
+	if (fp_)
+		fclose(fp_);
+}
+
+bool TextureArchive::Open(const Path &filename) {
+	fp_ = File::OpenCFile(filename, "rb");
+	if (!fp_)
+		return false;
+
+	TextureArchiveHeader header;
+	if (fread(&header, sizeof(header), 1, fp_) != 1 || memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) != 0) {
+		ERROR_LOG(G3D, "Not a texture archive: %s", filename.c_str());
+		return false;
+	}
+	if (header.version != ARCHIVE_VERSION) {
+		ERROR_LOG(G3D, "Unsupported texture archive version %d: %s", header.version, filename.c_str());
+		return false;
+	}
+
+	uint64_t fileSize = File::GetFileSize(fp_);
+	if (header.indexOffset + (u64)header.numEntries * sizeof(Entry) > fileSize) {
+		ERROR_LOG(G3D, "Truncated texture archive: %s", filename.c_str());
+		return false;
+	}
+
+	index_.resize(header.numEntries);
+	if (fseeko(fp_, header.indexOffset, SEEK_SET) != 0 || fread(index_.data(), sizeof(Entry), index_.size(), fp_) != index_.size()) {
+		ERROR_LOG(G3D, "Could not read texture archive index: %s", filename.c_str());
+		return false;
+	}
+	for (const Entry &entry : index_) {
+		if (entry.offset + entry.compressedSize > header.indexOffset) {
+			ERROR_LOG(G3D, "Corrupt texture archive index: %s", filename.c_str());
+			return false;
+		}
+	}
+
+	// Mapping lets the OS page in only what's used.  Reads work without it, just slower.
+	if (fileSize <= (uint64_t)(size_t)-1) {
+#if PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
+		HANDLE mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(fp_)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			mapped_ = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (mapped_)
+				mapping_ = mapping;
+			else
+				CloseHandle(mapping);
+		}
+#elif !PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(SWITCH)
+		void *mapped = mmap(nullptr, (size_t)fileSize, PROT_READ, MAP_SHARED, fileno(fp_), 0);
+		if (mapped != MAP_FAILED)
+			mapped_ = (const uint8_t *)mapped;
+#endif
+		mappedSize_ = mapped_ ? (size_t)fileSize : 0;
+	}
+
+	INFO_LOG(G3D, "Opened texture archive with %d files%s: %s", (int)index_.size(), mapped_ ? "" : " (not mapped)", filename.c_str());
+	return true;
+}
+
+u64 TextureArchive::HashPath(const std::string &path) {
+	// Match how textures.ini paths are written, regardless of slashes or case.
+	std::string normalized = ReplaceAll(path, "\\", "/");
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), tolower);
+	return XXH64(normalized.data(), normalized.size(), 0);
+}
+
+int TextureArchive::Find(const std::string &path) const {
+	u64 hash = HashPath(path);
+	auto it = std::lower_bound(index_.begin(), index_.end(), hash, [](const Entry &entry, u64 h) {
+		return entry.pathHash < h;
+	});
+	if (it == index_.end() || it->pathHash != hash)
+		return -1;
+	return (int)(it - index_.begin());
+}
+
+bool TextureArchive::ImageSize(int index, int *w, int *h) const {
+	const Entry &entry = index_[index];
+	if (entry.w == 0 || entry.h == 0 || entry.size != entry.w * entry.h * 4)
+		return false;
+	*w = entry.w;
+	*h = entry.h;
+	return true;
+}
+
+bool TextureArchive::Read(int index, std::vector<uint8_t> &out) const {
+	const Entry &entry = index_[index];
+
+	std::vector<uint8_t> buffer;
+	const uint8_t *compressed = mapped_ ? mapped_ + entry.offset : nullptr;
+	if (!compressed) {
+		std::lock_guard<std::mutex> guard(readLock_);
+		buffer.resize(entry.compressedSize);
+		if (fseeko(fp_, entry.offset, SEEK_SET) != 0 || fread(buffer.data(), 1, buffer.size(), fp_) != buffer.size())
+			return false;
+		compressed = buffer.data();
+	}
+
+	out.resize(entry.size);
+	size_t size = ZSTD_decompress(out.data(), out.size(), compressed, entry.compressedSize);
+	return !ZSTD_isError(size) && size == entry.size;
+}
+
+static void ListPackFiles(const Path &dir, const std::string &prefix, std::vector<std::string> &files) {
+	std::vector<File::FileInfo> entries;
+	File::GetFilesInDir(dir, &entries);
+	for (const auto &info : entries) {
+		if (info.isDirectory) {
+			// Newly dumped textures aren't part of the pack.
+			if (prefix.empty() && info.name + "/" == NEW_TEXTURE_DIR)
+				continue;
+			ListPackFiles(info.fullName, prefix + info.name + "/", files);
+		} else {
+			files.push_back(prefix + info.name);
+		}
+	}
+}
+
+static bool DecodeForArchive(const Path &filename, std::vector<uint8_t> &out, int *w, int *h) {
+	FILE *fp = File::OpenCFile(filename, "rb");
+	if (!fp)
+		return false;
+
+	bool success = false;
+	auto imageType = Identify(fp);
+	if (imageType == ReplacedImageType::ZIM) {
+		std::vector<uint8_t> zim((size_t)File::GetFileSize(fp));
+		int flags;
+		uint8_t *image = nullptr;
+		if (fread(zim.data(), 1, zim.size(), fp) == zim.size() && LoadZIMPtr(zim.data(), zim.size(), w, h, &flags, &image)) {
+			success = (flags & ZIM_FORMAT_MASK) == ZIM_RGBA8888;
+			if (success)
+				out.assign(image, image + *w * *h * 4);
+		}
+		free(image);
+	} else if (imageType == ReplacedImageType::PNG) {
+		png_image png = {};
+		png.version = PNG_IMAGE_VERSION;
+		if (png_image_begin_read_from_stdio(&png, fp)) {
+			png.format = PNG_FORMAT_RGBA;
+			*w = png.width;
+			*h = png.height;
+			out.resize(png.width * png.height * 4);
+			success = png_image_finish_read(&png, nullptr, out.data(), png.width * 4, nullptr) != 0;
+		}
+		png_image_free(&png);
+	}
+	fclose(fp);
+
+	if (!success)
+		ERROR_LOG(G3D, "Could not pack texture replacement: %s", filename.c_str());
+	return success;
+}
+
+bool TextureArchive::Build(const Path &packDir, const Path &filename) {
+	std::vector<std::string> files;
+	ListPackFiles(packDir, "", files);
+
+	// Write under a temp name, so a failed build never leaves a truncated archive behind.
+	const Path tempFilename = filename.WithExtraExtension(".tmp");
+	FILE *fp = File::OpenCFile(tempFilename, "wb");
+	if (!fp) {
+		ERROR_LOG(G3D, "Unable to create texture archive: %s", tempFilename.c_str());
+		return false;
+	}
+
+	TextureArchiveHeader header{};
+	memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = ARCHIVE_VERSION;
+	bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+	std::vector<Entry> index;
+	u64 offset = sizeof(header);
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> compressed;
+	for (const std::string &name : files) {
+		if (!success)
+			break;
+
+		Entry entry{};
+		entry.pathHash = HashPath(name);
+		if (endsWithNoCase(name, ".png") || endsWithNoCase(name, ".zim")) {
+			int w = 0, h = 0;
+			if (!DecodeForArchive(packDir / name, data, &w, &h))
+				continue;
+			entry.w = w;
+			entry.h = h;
+		} else if (endsWithNoCase(name, ".ini")) {
+			FILE *src = File::OpenCFile(packDir / name, "rb");
+			if (!src)
+				continue;
+			data.resize((size_t)File::GetFileSize(src));
+			bool read = fread(data.data(), 1, data.size(), src) == data.size();
+			fclose(src);
+			if (!read)
+				continue;
+		} else {
+			// Not something we'd ever look up.
+			continue;
+		}
+
+		compressed.resize(ZSTD_compressBound(data.size()));
+		size_t compressedSize = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), ARCHIVE_COMPRESSION_LEVEL);
+		if (ZSTD_isError(compressedSize)) {
+			ERROR_LOG(G3D, "Could not compress %s for texture archive", name.c_str());
+			continue;
+		}
+
+		entry.offset = offset;
+		entry.compressedSize = (u32)compressedSize;
+		entry.size = (u32)data.size();
+		success = fwrite(compressed.data(), 1, compressedSize, fp) == compressedSize;
+		offset += compressedSize;
+		index.push_back(entry);
+	}
+
+	std::sort(index.begin(), index.end(), [](const Entry &a, const Entry &b) {
+		return a.pathHash < b.pathHash;
+	});
+	for (size_t i = 1; i < index.size(); ++i) {
+		if (index[i - 1].pathHash == index[i].pathHash) {
+			// Practically impossible with 64 bits, unless the same file is there with different case.
+			ERROR_LOG(G3D, "Duplicate path in texture archive, check for files differing only in case");
+			success = false;
+		}
+	}
+
+	header.numEntries = (u32)index.size();
+	header.indexOffset = offset;
+	success = success && fwrite(index.data(), sizeof(Entry), index.size(), fp) == index.size();
+	success = success && fseeko(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+	fclose(fp);
+
+	if (success && File::Exists(filename))
+		success = File::Delete(filename);
+	if (!success || !File::Rename(tempFilename, filename)) {
+		ERROR_LOG(G3D, "Failed to write texture archive: %s", filename.c_str());
+		File::Delete(tempFilename);
+		return false;
+	}
+
+	NOTICE_LOG(G3D, "Packed %d of %d files into texture archive: %s", (int)index.size(), (int)files.size(), filename.c_str());
+	return true;
+}
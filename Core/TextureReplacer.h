@@ -18,6 +18,8 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -34,6 +36,7 @@ class TextureCacheCommon;
 class TextureReplacer;
 class ReplacedTextureTask;
 class LimitedWaitable;
+class TextureArchive;
 
 enum class ReplacedTextureFormat {
 	F_5650,
@@ -64,6 +67,46 @@ struct ReplacedTextureLevel {
 	int h;
 	ReplacedTextureFormat fmt;
 	Path file;
+	// Set when the level comes from a packed archive rather than file.
+	std::shared_ptr<TextureArchive> archive;
+	int archiveIndex = -1;
+};
+
+// A whole texture pack folder in one file: images are stored decoded (RGBA8888) and zstd compressed,
+// and everything is found through a sorted index of path hashes.  Mapped into memory when possible.
+class TextureArchive {
+public:
+	~TextureArchive();
+
+	bool Open(const Path &filename);
+
+	// Paths are relative to the pack folder, as used in textures.ini.  Returns -1 if missing.
+	int Find(const std::string &path) const;
+	bool ImageSize(int index, int *w, int *h) const;
+	bool Read(int index, std::vector<uint8_t> &out) const;
+
+	// Packs every image and ini file in packDir (except new/) into filename.
+	static bool Build(const Path &packDir, const Path &filename);
+
+private:
+	struct Entry {
+		u64 pathHash;
+		u64 offset;
+		u32 compressedSize;
+		u32 size;
+		u32 w;
+		u32 h;
+	};
+
+	static u64 HashPath(const std::string &path);
+
+	FILE *fp_ = nullptr;
+	const uint8_t *mapped_ = nullptr;
+	size_t mappedSize_ = 0;
+	void *mapping_ = nullptr;
+	std::vector<Entry> index_;
+	// Only for reads when we couldn't map.
+	mutable std::mutex readLock_;
 };
 
 struct ReplacementCacheKey {
@@ -212,9 +255,13 @@ class TextureReplacer {
 	void Decimate(bool forcePressure);
 
 	static bool GenerateIni(const std::string &gameID, Path &generatedFilename);
+	static bool GenerateArchive(const std::string &gameID, Path &generatedFilename);
 
 protected:
+	void OpenArchive();
 	bool LoadIni();
+	bool LoadIniFile(IniFile &ini, const std::string &filename);
+	bool ReplacementExists(const std::string &hashfile);
 	bool LoadIniValues(IniFile &ini, bool isOverride = false);
 	void ParseHashRange(const std::string &key, const std::string &value);
 	void ParseFiltering(const std::string &key, const std::string &value);
@@ -237,6 +284,7 @@ class TextureReplacer {
 	std::string gameID_;
 	Path basePath_;
 	ReplacedTextureHash hash_ = ReplacedTextureHash::QUICK;
+	std::shared_ptr<TextureArchive> archive_;
 	typedef std::pair<int, int> WidthHeightPair;
 	std::unordered_map<u64, WidthHeightPair> hashranges_;
 	std::unordered_map<u64, float> reducehashranges_;
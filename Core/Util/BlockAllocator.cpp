@@ -17,15 +17,53 @@
 
 #include <cstring>
 
+#include "Common/BitScan.h"
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/HLE/sceKernel.h"
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// The blocks form a linked list in address order, with indexes on the side so allocations
+// don't need to walk it.  Results must match a first fit (or last fit from the top) walk of the list.
+
+// Counts allocator calls and their time in the per-frame kernel stats.
+struct AllocatorStatsScope {
+	AllocatorStatsScope(int &counter) : start_(time_now_d()) {
+		counter++;
+	}
+	~AllocatorStatsScope() {
+		kernelStats.msInMemAllocator += time_now_d() - start_;
+	}
+	double start_;
+};
+
+template <typename B>
+static inline u32 BottomOffset(const B &b, u32 grain) {
+	u32 offset = b.start % grain;
+	if (offset != 0)
+		offset = grain - offset;
+	return offset;
+}
+
+template <typename B>
+static inline u32 TopOffset(const B &b, u32 size, u32 grain) {
+	return (b.start + b.size - size) % grain;
+}
+
+template <typename B>
+static inline bool BlockFits(const B &b, u32 size, u32 grain, bool fromTop) {
+	u32 offset = fromTop ? TopOffset(b, size, grain) : BottomOffset(b, grain);
+	return b.size >= offset + size;
+}
+
+static inline int FreeClass(u32 size) {
+	return 31 - (int)clz32_nonzero(size);
+}
 
 BlockAllocator::BlockAllocator(int grain) : bottom_(NULL), top_(NULL), grain_(grain)
 {
@@ -44,6 +82,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize, bool suballoc) {
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
 	suballoc_ = suballoc;
+	IndexBlock(top_);
 }
 
 void BlockAllocator::Shutdown()
@@ -55,10 +94,77 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+
+	blocksByAddress_.clear();
+	for (auto &freeBlocks : freeBlocks_)
+		freeBlocks.clear();
+	freeBytes_ = 0;
+}
+
+void BlockAllocator::IndexBlock(Block *b) {
+	// Empty blocks can't hold an address or an allocation.
+	if (b->size == 0)
+		return;
+	blocksByAddress_[b->start] = b;
+	if (!b->taken) {
+		freeBlocks_[FreeClass(b->size)].insert(b);
+		freeBytes_ += b->size;
+	}
+}
+
+void BlockAllocator::UnindexBlock(Block *b) {
+	if (b->size == 0)
+		return;
+	auto it = blocksByAddress_.find(b->start);
+	if (it != blocksByAddress_.end() && it->second == b)
+		blocksByAddress_.erase(it);
+	if (!b->taken && freeBlocks_[FreeClass(b->size)].erase(b) != 0)
+		freeBytes_ -= b->size;
+}
+
+void BlockAllocator::RebuildIndex() {
+	blocksByAddress_.clear();
+	for (auto &freeBlocks : freeBlocks_)
+		freeBlocks.clear();
+	freeBytes_ = 0;
+	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		IndexBlock(bp);
+}
+
+BlockAllocator::Block *BlockAllocator::FindFreeBlock(u32 size, u32 grain, bool fromTop) {
+	// Blocks in smaller classes are all smaller than size.  Within each larger class, take the
+	// first block (by address) that fits, and keep the lowest (or highest, from the top) of those.
+	Block *best = NULL;
+	for (int c = FreeClass(size); c < FREE_CLASSES; ++c) {
+		const auto &freeBlocks = freeBlocks_[c];
+		if (!fromTop) {
+			for (Block *bp : freeBlocks) {
+				if (best && bp->start > best->start)
+					break;
+				if (BlockFits(*bp, size, grain, false)) {
+					best = bp;
+					break;
+				}
+			}
+		} else {
+			for (auto it = freeBlocks.rbegin(); it != freeBlocks.rend(); ++it) {
+				Block *bp = *it;
+				if (best && bp->start < best->start)
+					break;
+				if (BlockFits(*bp, size, grain, true)) {
+					best = bp;
+					break;
+				}
+			}
+		}
+	}
+	return best;
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
 {
+	AllocatorStatsScope stats(kernelStats.memAllocs);
+
 	// Sanity check
 	if (size == 0 || size > rangeSize_) {
 		ERROR_LOG(SCEKERNEL, "Clearly bogus size: %08x - failing allocation", size);
@@ -74,67 +180,35 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	// upalign size to grain
 	size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
 
-	if (!fromTop)
+	Block *bp = FindFreeBlock(size, grain, fromTop);
+	if (bp != NULL)
 	{
-		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		Block &b = *bp;
+		UnindexBlock(bp);
+		if (!fromTop)
 		{
-			Block &b = *bp;
-			u32 offset = b.start % grain;
-			if (offset != 0)
-				offset = grain - offset;
+			//Allocate from bottom of mem
+			u32 offset = BottomOffset(b, grain);
 			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeAfter(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
+			if (b.size != needed)
+				InsertFreeAfter(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeBefore(&b, offset);
 		}
-	}
-	else
-	{
-		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
+		else
 		{
-			Block &b = *bp;
-			u32 offset = (b.start + b.size - size) % grain;
+			// Allocate from top of mem.
+			u32 offset = TopOffset(b, size, grain);
 			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeBefore(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
+			if (b.size != needed)
+				InsertFreeBefore(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeAfter(&b, offset);
 		}
+		b.taken = true;
+		IndexBlock(bp);
+		b.SetAllocated(tag, suballoc_);
+		return b.start;
 	}
 
 	//Out of memory :(
@@ -151,6 +225,7 @@ u32 BlockAllocator::Alloc(u32 &size, bool fromTop, const char *tag)
 
 u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 {
+	AllocatorStatsScope stats(kernelStats.memAllocs);
 	CheckBlocks();
 	if (size > rangeSize_) {
 		ERROR_LOG(SCEKERNEL, "Clearly bogus size: %08x - failing allocation", size);
@@ -193,19 +268,23 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			//good to go
 			else if (b.start == alignedPosition)
 			{
+				UnindexBlock(bp);
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
 				b.taken = true;
+				IndexBlock(bp);
 				b.SetAllocated(tag, suballoc_);
 				CheckBlocks();
 				return position;
 			}
 			else
 			{
+				UnindexBlock(bp);
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
 				b.taken = true;
+				IndexBlock(bp);
 				b.SetAllocated(tag, suballoc_);
 
 				return position;
@@ -228,10 +307,12 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 {
 	DEBUG_LOG(SCEKERNEL, "Merging Blocks");
 
+	// fromBlock must already be unindexed, and is indexed again once merged.
 	Block *prev = fromBlock->prev;
 	while (prev != NULL && prev->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(prev);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -252,6 +333,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -262,14 +344,18 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 		top_ = fromBlock;
 	else
 		next->prev = fromBlock;
+
+	IndexBlock(fromBlock);
 }
 
 bool BlockAllocator::Free(u32 position)
 {
+	AllocatorStatsScope stats(kernelStats.memFrees);
 	Block *b = GetBlockFromAddress(position);
 	if (b && b->taken)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
+		UnindexBlock(b);
 		b->taken = false;
 		MergeFreeBlocks(b);
 		return true;
@@ -283,10 +369,12 @@ bool BlockAllocator::Free(u32 position)
 
 bool BlockAllocator::FreeExact(u32 position)
 {
+	AllocatorStatsScope stats(kernelStats.memFrees);
 	Block *b = GetBlockFromAddress(position);
 	if (b && b->taken && b->start == position)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
+		UnindexBlock(b);
 		b->taken = false;
 		MergeFreeBlocks(b);
 		return true;
@@ -309,6 +397,7 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 
 	b->start += size;
 	b->size -= size;
+	IndexBlock(inserted);
 	return inserted;
 }
 
@@ -322,6 +411,7 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(inserted);
 	return inserted;
 }
 
@@ -347,28 +437,22 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 
 inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
-	return NULL;
+	const BlockAllocator *self = this;
+	return const_cast<Block *>(self->GetBlockFromAddress(addr));
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// The block starting at or before addr is the only one that might contain it.
+	auto it = blocksByAddress_.upper_bound(addr);
+	if (it == blocksByAddress_.begin())
+		return NULL;
+	--it;
+	const Block &b = *it->second;
+	if (b.start <= addr && b.start + b.size > addr)
 	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
+		// Got one!
+		return it->second;
 	}
 	return NULL;
 }
@@ -405,13 +489,13 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// The largest block is in the highest non-empty size class.
+	for (int c = FREE_CLASSES - 1; c >= 0 && maxFreeBlock == 0; --c)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
+		for (const Block *bp : freeBlocks_[c])
 		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
+			if (bp->size > maxFreeBlock)
+				maxFreeBlock = bp->size;
 		}
 	}
 	if (maxFreeBlock & (grain_ - 1))
@@ -421,15 +505,7 @@ u32 BlockAllocator::GetLargestFreeBlockSize() const
 
 u32 BlockAllocator::GetTotalFreeBytes() const
 {
-	u32 sum = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			sum += b.size;
-		}
-	}
+	u32 sum = freeBytes_;
 	if (sum & (grain_ - 1))
 		WARN_LOG_REPORT(HLE, "GetTotalFreeBytes: free size %08x does not align to grain %08x.", sum, grain_);
 	return sum;
@@ -480,6 +556,9 @@ void BlockAllocator::DoState(PointerWrap &p)
 	Do(p, rangeStart_);
 	Do(p, rangeSize_);
 	Do(p, grain_);
+
+	if (p.mode == p.MODE_READ)
+		RebuildIndex();
 }
 
 BlockAllocator::Block::Block(u32 _start, u32 _size, bool _taken, Block *_prev, Block *_next)
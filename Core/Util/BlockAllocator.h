@@ -19,6 +19,9 @@
 
 class PointerWrap;
 
+#include <map>
+#include <set>
+
 #include "Common/CommonTypes.h"
 
 class BlockAllocator
@@ -72,6 +75,15 @@ class BlockAllocator
 		Block *next;
 	};
 
+	struct BlockStartLess {
+		bool operator()(const Block *a, const Block *b) const {
+			return a->start < b->start;
+		}
+	};
+
+	// Free blocks are bucketed by floor(log2(size)).
+	static const int FREE_CLASSES = 32;
+
 	Block *bottom_;
 	Block *top_;
 	u32 rangeStart_;
@@ -80,6 +92,17 @@ class BlockAllocator
 	u32 grain_;
 	bool suballoc_;
 
+	// Indexes mirror the list: every non-empty block by start address, and free blocks by size class
+	// in address order.  A block must be unindexed before its start, size, or taken flag change.
+	std::map<u32, Block *> blocksByAddress_;
+	std::set<Block *, BlockStartLess> freeBlocks_[FREE_CLASSES];
+	u32 freeBytes_ = 0;
+
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void RebuildIndex();
+	Block *FindFreeBlock(u32 size, u32 grain, bool fromTop);
+
 	void MergeFreeBlocks(Block *fromBlock);
 	Block *GetBlockFromAddress(u32 addr);
 	const Block *GetBlockFromAddress(u32 addr) const;
@@ -16,8 +16,11 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPClient.h"
 #include "Common/Net/HTTPServer.h"
@@ -31,6 +34,7 @@
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "Core/Debugger/WebSocket.h"
+#include "Core/FileLoaders/LocalFileLoader.h"
 #include "Core/WebServer.h"
 
 enum class ServerStatus {
@@ -49,6 +53,15 @@ static ServerStatus serverStatus;
 static std::mutex serverStatusLock;
 static int serverFlags;
 
+// Discs stay open while they're being streamed, shared by all connections.
+struct OpenDisc {
+	std::shared_ptr<LocalFileLoader> file;
+	double lastUsed;
+};
+static const double OPEN_DISC_IDLE_TIMEOUT = 60.0;
+static std::map<Path, OpenDisc> openDiscs;
+static std::mutex openDiscsLock;
+
 static void UpdateStatus(ServerStatus s) {
 	std::lock_guard<std::mutex> guard(serverStatusLock);
 	serverStatus = s;
@@ -159,12 +172,80 @@ static Path LocalFromRemotePath(const std::string &path) {
 	return Path();
 }
 
-static void DiscHandler(const http::Request &request, const Path &filename) {
-	s64 sz = File::GetFileSize(filename);
+static std::shared_ptr<LocalFileLoader> OpenDiscFile(const Path &filename) {
+	std::lock_guard<std::mutex> guard(openDiscsLock);
+	double now = time_now_d();
+
+	// Close anything nobody has asked for in a while (the file might be replaced or removed.)
+	for (auto it = openDiscs.begin(); it != openDiscs.end(); ) {
+		if (it->first != filename && it->second.lastUsed + OPEN_DISC_IDLE_TIMEOUT < now) {
+			it = openDiscs.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	auto it = openDiscs.find(filename);
+	if (it != openDiscs.end()) {
+		it->second.lastUsed = now;
+		return it->second.file;
+	}
 
+	std::shared_ptr<LocalFileLoader> file = std::make_shared<LocalFileLoader>(filename);
+	if (!file->Exists())
+		return nullptr;
+	openDiscs[filename] = OpenDisc{ file, now };
+	return file;
+}
+
+static void CloseDiscFiles() {
+	std::lock_guard<std::mutex> guard(openDiscsLock);
+	openDiscs.clear();
+}
+
+static bool SendDiscRange(const http::Request &request, LocalFileLoader *file, s64 begin, s64 len) {
+	// Headers have to go out before we write to the socket directly.
+	if (!request.Out()->Flush())
+		return false;
+
+#ifndef _WIN32
+	s64 sent = fd_util::SendFile(request.fd(), file->GetFD(), begin, len, 20.0);
+	if (sent < 0)
+		return false;
+	begin += sent;
+	len -= sent;
+#endif
+
+	// Whatever sendfile couldn't do (or everything, on Windows), copy in large chunks.
+	const size_t CHUNK_SIZE = 256 * 1024;
+	std::vector<char> buf;
+	if (len > 0)
+		buf.resize((size_t)std::min(len, (s64)CHUNK_SIZE));
+	while (len > 0) {
+		size_t chunklen = (size_t)std::min(len, (s64)CHUNK_SIZE);
+		if (file->ReadAt(begin, 1, chunklen, &buf[0]) != chunklen)
+			return false;
+		if (!request.Out()->Push(&buf[0], chunklen))
+			return false;
+		begin += chunklen;
+		len -= chunklen;
+	}
+	return request.Out()->Flush();
+}
+
+void HandleDiscRequest(const http::Request &request, const Path &filename) {
+	std::shared_ptr<LocalFileLoader> file = OpenDiscFile(filename);
+	if (!file) {
+		request.WriteHttpResponseHeader("1.0", 500, -1, "text/plain");
+		request.Out()->Push("File access failed.");
+		return;
+	}
+	s64 sz = file->FileSize();
+
+	// Responses with a length use HTTP/1.1, so clients streaming a disc can reuse the connection.
 	std::string range;
 	if (request.Method() == http::RequestHeader::HEAD) {
-		request.WriteHttpResponseHeader("1.0", 200, sz, "application/octet-stream", "Accept-Ranges: bytes\r\n");
+		request.WriteHttpResponseHeader("1.1", 200, sz, "application/octet-stream", "Accept-Ranges: bytes\r\n");
 	} else if (request.GetHeader("range", &range)) {
 		s64 begin = 0, last = 0;
 		if (sscanf(range.c_str(), "bytes=%lld-%lld", &begin, &last) != 2) {
@@ -179,32 +260,17 @@ static void DiscHandler(const http::Request &request, const Path &filename) {
 			return;
 		}
 
-		FILE *fp = File::OpenCFile(filename, "rb");
-		if (!fp || fseek(fp, begin, SEEK_SET) != 0) {
-			request.WriteHttpResponseHeader("1.0", 500, -1, "text/plain");
-			request.Out()->Push("File access failed.");
-			if (fp) {
-				fclose(fp);
-			}
-			return;
-		}
-
 		s64 len = last - begin + 1;
 		char contentRange[1024];
 		sprintf(contentRange, "Content-Range: bytes %lld-%lld/%lld\r\n", begin, last, sz);
-		request.WriteHttpResponseHeader("1.0", 206, len, "application/octet-stream", contentRange);
-
-		const size_t CHUNK_SIZE = 16 * 1024;
-		char *buf = new char[CHUNK_SIZE];
-		for (s64 pos = 0; pos < len; pos += CHUNK_SIZE) {
-			s64 chunklen = std::min(len - pos, (s64)CHUNK_SIZE);
-			if (fread(buf, chunklen, 1, fp) != 1)
-				break;
-			request.Out()->Push(buf, chunklen);
+		request.WriteHttpResponseHeader("1.1", 206, len, "application/octet-stream", contentRange);
+
+		if (!SendDiscRange(request, file.get(), begin, len)) {
+			// We can't take back the headers, so the connection must go.
+			ERROR_LOG(FILESYS, "Failed to send range %lld-%lld of %s", begin, last, filename.c_str());
+			request.Out()->Discard();
+			request.CloseAfterResponse();
 		}
-		fclose(fp);
-		delete[] buf;
-		request.Out()->Flush();
 	} else {
 		request.WriteHttpResponseHeader("1.0", 418, -1, "text/plain");
 		request.Out()->Push("This server only supports range requests.");
@@ -272,7 +338,7 @@ static void HandleFallback(const http::Request &request) {
 	if (serverFlags & (int)WebServerFlags::DISCS) {
 		Path filename = LocalFromRemotePath(request.resource());
 		if (!filename.empty()) {
-			DiscHandler(request, filename);
+			HandleDiscRequest(request, filename);
 			return;
 		}
 	}
@@ -345,6 +411,7 @@ static void ExecuteWebServer() {
 	http->Stop();
 	StopAllDebuggers();
 	delete http;
+	CloseDiscFiles();
 
 	UpdateStatus(ServerStatus::FINISHED);
 }
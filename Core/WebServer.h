@@ -15,6 +15,16 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#pragma once
+
+#include <string>
+
+class Path;
+
+namespace http {
+class Request;
+}
+
 enum class WebServerFlags {
 	DISCS = 1,
 	DEBUGGER = 2,
@@ -29,3 +39,6 @@ bool WebServerStopped(WebServerFlags flags);
 void ShutdownWebServer();
 
 bool RemoteISOFileSupported(const std::string &filename);
+
+// Answers HEAD and range requests for a local disc image (also used by the unit tests.)
+void HandleDiscRequest(const http::Request &request, const Path &filename);
@@ -57,6 +57,7 @@ FramebufferManagerCommon::~FramebufferManagerCommon() {
 		DestroyFramebuf(vfb);
 	}
 	vfbs_.clear();
+	InvalidateVFBIndex();
 
 	for (auto &tempFB : tempFBOs_) {
 		tempFB.second.fbo->Release();
@@ -109,8 +110,7 @@ void FramebufferManagerCommon::SetDisplayFramebuffer(u32 framebuf, u32 stride, G
 VirtualFramebuffer *FramebufferManagerCommon::GetVFBAt(u32 addr) {
 	addr &= 0x3FFFFFFF;
 	VirtualFramebuffer *match = nullptr;
-	for (size_t i = 0; i < vfbs_.size(); ++i) {
-		VirtualFramebuffer *v = vfbs_[i];
+	for (VirtualFramebuffer *v : FindVFBCandidates(VFB_INDEX_COLOR_MEMORY, addr, addr)) {
 		if (v->fb_address == addr) {
 			// Could check w too but whatever
 			if (match == nullptr || match->last_frame_render < v->last_frame_render) {
@@ -121,6 +121,105 @@ VirtualFramebuffer *FramebufferManagerCommon::GetVFBAt(u32 addr) {
 	return match;
 }
 
+// Below this many framebuffers, just checking them all is cheaper than the index.
+static const size_t VFB_INDEX_MIN_BUFFERS = 8;
+
+static u32 VFBIndexAddress(u32 addr, bool foldMirrors) {
+	addr &= 0x3FFFFFFF;
+	// Texture matching ignores the VRAM swizzle mirrors, see TextureCacheCommon::MatchFramebuffer().
+	if (foldMirrors && Memory::IsVRAMAddress(addr)) {
+		addr &= ~0x00600000;
+	}
+	return addr;
+}
+
+void FramebufferManagerCommon::RebuildVFBIndex() {
+	for (auto &index : vfbIndex_) {
+		index.clear();
+	}
+	vfbUnindexed_.clear();
+
+	for (size_t i = 0; i < vfbs_.size(); ++i) {
+		const VirtualFramebuffer *vfb = vfbs_[i];
+		if (vfb->fb_stride <= 0) {
+			vfbUnindexed_.push_back((u32)i);
+			continue;
+		}
+
+		// 4 bytes per pixel covers both buffer formats and any texture format read from it.
+		// Never empty, since a lookup at exactly the start address may still match.
+		const u64 size = std::max((u64)vfb->fb_stride * vfb->height * 4, (u64)1);
+		auto add = [&](VFBIndexKind kind, u32 start) {
+			const u32 end = (u32)std::min((u64)start + size, (u64)0xFFFFFFFF);
+			vfbIndex_[kind].push_back(VFBIndexEntry{ start, end, end, (u32)i });
+		};
+		add(VFB_INDEX_COLOR_MEMORY, VFBIndexAddress(vfb->fb_address, false));
+		add(VFB_INDEX_COLOR_TEXTURE, VFBIndexAddress(vfb->fb_address, true));
+		add(VFB_INDEX_DEPTH_TEXTURE, VFBIndexAddress(vfb->z_address, true));
+	}
+
+	for (auto &index : vfbIndex_) {
+		std::sort(index.begin(), index.end(), [](const VFBIndexEntry &a, const VFBIndexEntry &b) {
+			return a.start < b.start;
+		});
+		u32 maxEnd = 0;
+		for (VFBIndexEntry &entry : index) {
+			maxEnd = std::max(maxEnd, entry.end);
+			entry.maxEnd = maxEnd;
+		}
+	}
+
+	vfbIndexDirty_ = false;
+}
+
+void FramebufferManagerCommon::CollectVFBCandidates(VFBIndexKind kind, u32 addr) {
+	addr = VFBIndexAddress(addr, kind != VFB_INDEX_COLOR_MEMORY);
+
+	// Walk back from the last entry starting at or before addr, until nothing earlier can reach it.
+	const std::vector<VFBIndexEntry> &index = vfbIndex_[kind];
+	auto it = std::upper_bound(index.begin(), index.end(), addr, [](u32 a, const VFBIndexEntry &entry) {
+		return a < entry.start;
+	});
+	while (it != index.begin()) {
+		--it;
+		if (it->maxEnd <= addr) {
+			break;
+		}
+		if (it->end > addr) {
+			vfbCandidates_.push_back(it->position);
+		}
+	}
+}
+
+const std::vector<VirtualFramebuffer *> &FramebufferManagerCommon::FindVFBCandidates(VFBIndexKind kind, u32 addrA, u32 addrB) {
+	if (vfbs_.size() < VFB_INDEX_MIN_BUFFERS) {
+		return vfbs_;
+	}
+	if (vfbIndexDirty_) {
+		RebuildVFBIndex();
+	}
+
+	vfbCandidates_.clear();
+	CollectVFBCandidates(kind, addrA);
+	if (addrB != addrA) {
+		CollectVFBCandidates(kind, addrB);
+	}
+	vfbCandidates_.insert(vfbCandidates_.end(), vfbUnindexed_.begin(), vfbUnindexed_.end());
+
+	// Callers pick between overlapping matches by order, so keep the order of vfbs_.
+	std::sort(vfbCandidates_.begin(), vfbCandidates_.end());
+	vfbCandidates_.erase(std::unique(vfbCandidates_.begin(), vfbCandidates_.end()), vfbCandidates_.end());
+	vfbCandidateBuffers_.clear();
+	for (u32 position : vfbCandidates_) {
+		vfbCandidateBuffers_.push_back(vfbs_[position]);
+	}
+	return vfbCandidateBuffers_;
+}
+
+const std::vector<VirtualFramebuffer *> &FramebufferManagerCommon::GetFramebuffersNearTexture(u32 addr, bool depth) {
+	return FindVFBCandidates(depth ? VFB_INDEX_DEPTH_TEXTURE : VFB_INDEX_COLOR_TEXTURE, addr, addr);
+}
+
 u32 FramebufferManagerCommon::ColorBufferByteSize(const VirtualFramebuffer *vfb) const {
 	return vfb->fb_stride * vfb->height * (vfb->format == GE_FORMAT_8888 ? 4 : 2);
 }
@@ -275,6 +374,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 			if (vfb->fb_stride != params.fb_stride) {
 				vfb->fb_stride = params.fb_stride;
 				vfbFormatChanged = true;
+				InvalidateVFBIndex();
 			}
 			if (vfb->format != params.fmt) {
 				vfb->format = params.fmt;
@@ -289,6 +389,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 
 			// Keep track, but this isn't really used.
 			vfb->z_stride = params.z_stride;
+			const u16 oldHeight = vfb->height;
 			// Heuristic: In throughmode, a higher height could be used.  Let's avoid shrinking the buffer.
 			if (params.isModeThrough && (int)vfb->width <= params.fb_stride) {
 				vfb->width = std::max((int)vfb->width, drawing_width);
@@ -297,6 +398,9 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 				vfb->width = drawing_width;
 				vfb->height = drawing_height;
 			}
+			if (vfb->height != oldHeight) {
+				InvalidateVFBIndex();
+			}
 			break;
 		} else if (v->fb_address < params.fb_address && v->fb_address + v->fb_stride * 4 > params.fb_address) {
 			// Possibly a render-to-offset.
@@ -338,7 +442,10 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 				} else {
 					// Even though we won't resize it, let's at least change the size params.
 					vfb->width = drawing_width;
-					vfb->height = drawing_height;
+					if (vfb->height != drawing_height) {
+						vfb->height = drawing_height;
+						InvalidateVFBIndex();
+					}
 				}
 			}
 		} else {
@@ -387,6 +494,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 		vfb->last_frame_render = gpuStats.numFlips;
 		frameLastFramebufUsed_ = gpuStats.numFlips;
 		vfbs_.push_back(vfb);
+		InvalidateVFBIndex();
 		currentRenderVfb_ = vfb;
 
 		if (useBufferedRendering_ && !g_Config.bDisableSlowFramebufEffects) {
@@ -775,6 +883,7 @@ void FramebufferManagerCommon::NotifyVideoUpload(u32 addr, int size, int width,
 			// Resizing may change the viewport/etc.
 			gstate_c.Dirty(DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_CULLRANGE);
 			vfb->fb_stride = width;
+			InvalidateVFBIndex();
 			// This might be a bit wider than necessary, but we'll redetect on next render.
 			vfb->width = width;
 		}
@@ -809,6 +918,7 @@ void FramebufferManagerCommon::UpdateFromMemory(u32 addr, int size, bool safe) {
 					INFO_LOG(FRAMEBUF, "Invalidating FBO for %08x (%i x %i x %i)", vfb->fb_address, vfb->width, vfb->height, vfb->format);
 					DestroyFramebuf(vfb);
 					vfbs_.erase(vfbs_.begin() + i--);
+					InvalidateVFBIndex();
 				}
 			}
 		}
@@ -1215,6 +1325,7 @@ void FramebufferManagerCommon::DecimateFBOs() {
 				INFO_LOG(FRAMEBUF, "Decimating FBO for %08x (%i x %i x %i), age %i", vfb->fb_address, vfb->width, vfb->height, vfb->format, age);
 				DestroyFramebuf(vfb);
 				vfbs_.erase(vfbs_.begin() + i--);
+				InvalidateVFBIndex();
 			}
 		}
 	}
@@ -1359,8 +1470,9 @@ bool FramebufferManagerCommon::NotifyFramebufferCopy(u32 src, u32 dst, int size,
 	u32 dstH = 0;
 	u32 srcY = (u32)-1;
 	u32 srcH = 0;
-	for (size_t i = 0; i < vfbs_.size(); ++i) {
-		VirtualFramebuffer *vfb = vfbs_[i];
+	// A negative size wraps around in the checks below, so only trust the index for sane ones.
+	const std::vector<VirtualFramebuffer *> &candidates = size > 0 ? FindVFBCandidates(VFB_INDEX_COLOR_MEMORY, dst, src) : vfbs_;
+	for (VirtualFramebuffer *vfb : candidates) {
 		if (vfb->fb_stride == 0) {
 			continue;
 		}
@@ -1474,8 +1586,7 @@ void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dst
 	dstBasePtr &= 0x3FFFFFFF;
 	srcBasePtr &= 0x3FFFFFFF;
 
-	for (size_t i = 0; i < vfbs_.size(); ++i) {
-		VirtualFramebuffer *vfb = vfbs_[i];
+	for (VirtualFramebuffer *vfb : FindVFBCandidates(VFB_INDEX_COLOR_MEMORY, dstBasePtr, srcBasePtr)) {
 		const u32 vfb_address = vfb->fb_address & 0x3FFFFFFF;
 		const u32 vfb_size = ColorBufferByteSize(vfb);
 		const u32 vfb_bpp = vfb->format == GE_FORMAT_8888 ? 4 : 2;
@@ -1609,6 +1720,7 @@ VirtualFramebuffer *FramebufferManagerCommon::CreateRAMFramebuffer(uint32_t fbAd
 	textureCache_->NotifyFramebuffer(vfb, NOTIFY_FB_CREATED);
 	vfb->fbo = draw_->CreateFramebuffer({ vfb->renderWidth, vfb->renderHeight, 1, 1, true, name });
 	vfbs_.push_back(vfb);
+	InvalidateVFBIndex();
 
 	u32 byteSize = ColorBufferByteSize(vfb);
 	if (fbAddress + byteSize > framebufRangeEnd_) {
@@ -1935,6 +2047,7 @@ void FramebufferManagerCommon::DestroyAllFBOs() {
 		DestroyFramebuf(vfb);
 	}
 	vfbs_.clear();
+	InvalidateVFBIndex();
 
 	for (VirtualFramebuffer *vfb : bvfbs_) {
 		DestroyFramebuf(vfb);
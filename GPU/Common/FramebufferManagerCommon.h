@@ -286,6 +286,9 @@ class FramebufferManagerCommon {
 	}
 	// TODO: Break out into some form of FBO manager
 	VirtualFramebuffer *GetVFBAt(u32 addr);
+	// The framebuffers a texture at addr might sample from, in the same order as Framebuffers().
+	// This is a conservative filter, callers still need to check each one. Valid until the next lookup.
+	const std::vector<VirtualFramebuffer *> &GetFramebuffersNearTexture(u32 addr, bool depth);
 	VirtualFramebuffer *GetDisplayVFB() {
 		return GetVFBAt(displayFramebufPtr_);
 	}
@@ -344,6 +347,21 @@ class FramebufferManagerCommon {
 	void FlushBeforeCopy();
 	virtual void DecimateFBOs();  // keeping it virtual to let D3D do a little extra
 
+	enum VFBIndexKind {
+		VFB_INDEX_COLOR_MEMORY,
+		VFB_INDEX_COLOR_TEXTURE,
+		VFB_INDEX_DEPTH_TEXTURE,
+		VFB_INDEX_COUNT,
+	};
+	// Must be called whenever vfbs_ changes, or a framebuffer's fb_stride or height does.
+	void InvalidateVFBIndex() {
+		vfbIndexDirty_ = true;
+	}
+	void RebuildVFBIndex();
+	void CollectVFBCandidates(VFBIndexKind kind, u32 addr);
+	// Framebuffers (in vfbs_ order) whose memory may contain addrA or addrB. Valid until the next lookup.
+	const std::vector<VirtualFramebuffer *> &FindVFBCandidates(VFBIndexKind kind, u32 addrA, u32 addrB);
+
 	// Used by ReadFramebufferToMemory and later framebuffer block copies
 	virtual void BlitFramebuffer(VirtualFramebuffer *dst, int dstX, int dstY, VirtualFramebuffer *src, int srcX, int srcY, int w, int h, int bpp, const char *tag) = 0;
 	void CopyFramebufferForColorTexture(VirtualFramebuffer *dst, VirtualFramebuffer *src, int flags);
@@ -411,6 +429,21 @@ class FramebufferManagerCommon {
 	std::vector<VirtualFramebuffer *> vfbs_;
 	std::vector<VirtualFramebuffer *> bvfbs_; // blitting framebuffers (for download)
 
+	// Address intervals of vfbs_, sorted by start, so lookups don't need to check every framebuffer.
+	struct VFBIndexEntry {
+		u32 start;
+		u32 end;
+		// Largest end of this and all preceding entries, lets lookups stop early.
+		u32 maxEnd;
+		u32 position;
+	};
+	std::vector<VFBIndexEntry> vfbIndex_[VFB_INDEX_COUNT];
+	// Framebuffers without a stride, which could overlap anything.
+	std::vector<u32> vfbUnindexed_;
+	std::vector<u32> vfbCandidates_;
+	std::vector<VirtualFramebuffer *> vfbCandidateBuffers_;
+	bool vfbIndexDirty_ = true;
+
 	bool gameUsesSequentialCopies_ = false;
 
 	// Sampled in BeginFrame/UpdateSize for safety.
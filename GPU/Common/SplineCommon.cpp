@@ -17,10 +17,15 @@
 
 #include <string.h>
 #include <algorithm>
+#include <mutex>
+#include <vector>
 
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/CPUDetect.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "ext/xxhash.h"
 
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
@@ -315,8 +320,51 @@ class Tessellator {
 
 		return Sample(u, weights);
 	}
+
+	const T *Line() const { return u; }
+};
+
+#ifdef _M_SSE
+// A pre-tessellated U line with each component splatted, to sample four V steps at once (SoA).
+template<int N>
+struct LineSSE {
+	__m128 c[4][N];
+
+	template<typename T>
+	void Load(const T line[4]) {
+		for (int i = 0; i < 4; ++i) {
+			const float *f = line[i].AsArray();
+			for (int j = 0; j < N; ++j)
+				c[i][j] = _mm_set1_ps(f[j]);
+		}
+	}
+
+	__m128 Sample(int j, const __m128 w[4]) const {
+		const __m128 a = _mm_add_ps(_mm_mul_ps(c[0][j], w[0]), _mm_mul_ps(c[1][j], w[1]));
+		const __m128 b = _mm_add_ps(_mm_mul_ps(c[2][j], w[2]), _mm_mul_ps(c[3][j], w[3]));
+		return _mm_add_ps(a, b);
+	}
 };
 
+// Transposes the weights of four consecutive V steps, so w[i] holds weight i of each.
+static inline void TransposeWeights(const Weight *wv, int count, __m128 basis[4], __m128 deriv[4]) {
+	const Weight &w0 = wv[0];
+	const Weight &w1 = wv[std::min(1, count - 1)];
+	const Weight &w2 = wv[std::min(2, count - 1)];
+	const Weight &w3 = wv[std::min(3, count - 1)];
+	basis[0] = _mm_loadu_ps(w0.basis);
+	basis[1] = _mm_loadu_ps(w1.basis);
+	basis[2] = _mm_loadu_ps(w2.basis);
+	basis[3] = _mm_loadu_ps(w3.basis);
+	_MM_TRANSPOSE4_PS(basis[0], basis[1], basis[2], basis[3]);
+	deriv[0] = _mm_loadu_ps(w0.deriv);
+	deriv[1] = _mm_loadu_ps(w1.deriv);
+	deriv[2] = _mm_loadu_ps(w2.deriv);
+	deriv[3] = _mm_loadu_ps(w3.deriv);
+	_MM_TRANSPOSE4_PS(deriv[0], deriv[1], deriv[2], deriv[3]);
+}
+#endif
+
 ControlPoints::ControlPoints(const SimpleVertex *const *points, int size, SimpleBufferManager &managedBuf) {
 	pos = (Vec3f *)managedBuf.Allocate(sizeof(Vec3f) * size);
 	tex = (Vec2f *)managedBuf.Allocate(sizeof(Vec2f) * size);
@@ -331,77 +379,182 @@ void ControlPoints::Convert(const SimpleVertex *const *points, int size) {
 		col[i] = Vec4f::FromRGBA(points[i]->color_32);
 	}
 	defcolor = points[0]->color_32;
+	this->size = size;
 }
 
+// Below this many output vertices, handing patches to other threads costs more than it saves.
+static const int MIN_PARALLEL_TESS_VERTICES = 4096;
+static const int MIN_TESS_VERTICES_PER_TASK = 1024;
+
 template<class Surface>
 class SubdivisionSurface {
 public:
 	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
-	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+	static void TessellatePatches(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, int lower, int upper) {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
+		for (int patch = lower; patch < upper; ++patch) {
+			const int patch_u = patch % surface.num_patches_u;
+			const int patch_v = patch / surface.num_patches_u;
 			const int start_u = surface.GetTessStart(patch_u);
-			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
-				const int start_v = surface.GetTessStart(patch_v);
-
-				// Prepare 4x4 control points to tessellate
-				const int idx = surface.GetPointIndex(patch_u, patch_v);
-				const int idx_v[4] = { idx, idx + surface.num_points_u, idx + surface.num_points_u * 2, idx + surface.num_points_u * 3 };
-				Tessellator<Vec3f> tess_pos(points.pos, idx_v);
-				Tessellator<Vec4f> tess_col(points.col, idx_v);
-				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
-				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
-
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
-
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
-
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
-
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
-
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
-						if (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
-						} else {
-							vert.color_32 = points.defcolor;
+			const int start_v = surface.GetTessStart(patch_v);
+
+			// Prepare 4x4 control points to tessellate
+			const int idx = surface.GetPointIndex(patch_u, patch_v);
+			const int idx_v[4] = { idx, idx + surface.num_points_u, idx + surface.num_points_u * 2, idx + surface.num_points_u * 3 };
+			Tessellator<Vec3f> tess_pos(points.pos, idx_v);
+			Tessellator<Vec4f> tess_col(points.col, idx_v);
+			Tessellator<Vec2f> tess_tex(points.tex, idx_v);
+			Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
+
+			for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
+				const int index_u = surface.GetIndexU(patch_u, tile_u);
+				const Weight &wu = weights.u[index_u];
+
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
+
+				int tile_v = start_v;
+#ifdef _M_SSE
+				LineSSE<3> line_pos;
+				LineSSE<4> line_col;
+				LineSSE<2> line_tex;
+				LineSSE<3> line_nrm;
+				line_pos.Load(tess_pos.Line());
+				if (sampleCol)
+					line_col.Load(tess_col.Line());
+				if (sampleTex)
+					line_tex.Load(tess_tex.Line());
+				if (sampleNrm)
+					line_nrm.Load(tess_nrm.Line());
+
+				for (; tile_v <= surface.tess_v; tile_v += 4) {
+					const int count = std::min(4, surface.tess_v + 1 - tile_v);
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					__m128 basis[4], deriv[4];
+					TransposeWeights(&weights.v[index_v], count, basis, deriv);
+
+					alignas(16) float pos[3][4];
+					alignas(16) float uv[2][4];
+					alignas(16) float nrm[3][4];
+					alignas(16) u32 color[4];
+					for (int j = 0; j < 3; ++j)
+						_mm_store_ps(pos[j], line_pos.Sample(j, basis));
+					if (sampleCol) {
+						const __m128 scale = _mm_set1_ps(255.0f);
+						// Clamping first gives the same result as the saturating packs in Vec4f::ToRGBA().
+						__m128i c[4];
+						for (int j = 0; j < 4; ++j) {
+							__m128 f = _mm_mul_ps(line_col.Sample(j, basis), scale);
+							c[j] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), scale));
 						}
+						const __m128i rg = _mm_or_si128(c[0], _mm_slli_epi32(c[1], 8));
+						const __m128i ba = _mm_or_si128(_mm_slli_epi32(c[2], 16), _mm_slli_epi32(c[3], 24));
+						const __m128i rgba = _mm_or_si128(rg, ba);
+						_mm_store_si128((__m128i *)color, rgba);
+					}
+					if (sampleTex) {
+						_mm_store_ps(uv[0], line_tex.Sample(0, basis));
+						_mm_store_ps(uv[1], line_tex.Sample(1, basis));
+					}
+					if (sampleNrm) {
+						const __m128 ux = line_nrm.Sample(0, basis), uy = line_nrm.Sample(1, basis), uz = line_nrm.Sample(2, basis);
+						const __m128 vx = line_pos.Sample(0, deriv), vy = line_pos.Sample(1, deriv), vz = line_pos.Sample(2, deriv);
+						__m128 nx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+						__m128 ny = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+						__m128 nz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+						const __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+						__m128 scale = _mm_rsqrt_ps(len2);
+						if (patchFacing)
+							scale = _mm_sub_ps(_mm_setzero_ps(), scale);
+						_mm_store_ps(nrm[0], _mm_mul_ps(nx, scale));
+						_mm_store_ps(nrm[1], _mm_mul_ps(ny, scale));
+						_mm_store_ps(nrm[2], _mm_mul_ps(nz, scale));
+					}
+
+					for (int i = 0; i < count; ++i) {
+						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v + i, patch_u, patch_v)];
+						vert.pos.x = pos[0][i];
+						vert.pos.y = pos[1][i];
+						vert.pos.z = pos[2][i];
+						vert.color_32 = sampleCol ? color[i] : (u32)points.defcolor;
 						if (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
+							vert.uv[0] = uv[0][i];
+							vert.uv[1] = uv[1][i];
 						} else {
 							// Generate texcoord
 							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
+							vert.uv[1] = patch_v + (tile_v + i) * inv_v;
 						}
 						if (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if (patchFacing)
-								vert.nrm *= -1.0f;
+							vert.nrm.x = nrm[0][i];
+							vert.nrm.y = nrm[1][i];
+							vert.nrm.z = nrm[2][i];
 						} else {
 							vert.nrm.SetZero();
 							vert.nrm.z = 1.0f;
 						}
 					}
 				}
+#endif
+
+				for (; tile_v <= surface.tess_v; ++tile_v) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const Weight &wv = weights.v[index_v];
+
+					SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+
+					// Tessellate
+					vert.pos = tess_pos.SampleV(wv.basis);
+					if (sampleCol) {
+						vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+					} else {
+						vert.color_32 = points.defcolor;
+					}
+					if (sampleTex) {
+						tess_tex.SampleV(wv.basis).Write(vert.uv);
+					} else {
+						// Generate texcoord
+						vert.uv[0] = patch_u + tile_u * inv_u;
+						vert.uv[1] = patch_v + tile_v * inv_v;
+					}
+					if (sampleNrm) {
+						const Vec3f derivU = tess_nrm.SampleV(wv.basis);
+						const Vec3f derivV = tess_pos.SampleV(wv.deriv);
+
+						vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
+						if (patchFacing)
+							vert.nrm *= -1.0f;
+					} else {
+						vert.nrm.SetZero();
+						vert.nrm.z = 1.0f;
+					}
+				}
 			}
 		}
+	}
+
+	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
+	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+		const int num_patches = surface.num_patches_u * surface.num_patches_v;
+		const int verts_per_patch = (surface.tess_u + 1) * (surface.tess_v + 1);
+
+		if (num_patches > 1 && num_patches * verts_per_patch >= MIN_PARALLEL_TESS_VERTICES) {
+			// Patches never write the same vertex (splines skip the shared edge), so they can be split freely.
+			const int minPatches = std::max(1, MIN_TESS_VERTICES_PER_TASK / verts_per_patch);
+			ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+				TessellatePatches<sampleNrm, sampleCol, sampleTex, useSSE4, patchFacing>(output, surface, points, weights, lower, upper);
+			}, 0, num_patches, minPatches);
+		} else {
+			TessellatePatches<sampleNrm, sampleCol, sampleTex, useSSE4, patchFacing>(output, surface, points, weights, 0, num_patches);
+		}
 
 		surface.BuildIndex(output.indices, output.count);
 	}
@@ -411,7 +564,7 @@ class SubdivisionSurface {
 
 	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, u32 origVertType) {
 		const bool params[] = {
-			(origVertType & GE_VTYPE_NRM_MASK) != 0 || gstate.isLightingEnabled(),
+			NeedsNormals(origVertType),
 			(origVertType & GE_VTYPE_COL_MASK) != 0,
 			(origVertType & GE_VTYPE_TC_MASK) != 0,
 			cpu_info.bSSE4_1,
@@ -422,16 +575,132 @@ class SubdivisionSurface {
 		TessFunc func = dispatcher.GetFunc(params);
 		func(output, surface, points, weights);
 	}
+
+	static bool NeedsNormals(u32 origVertType) {
+		return (origVertType & GE_VTYPE_NRM_MASK) != 0 || gstate.isLightingEnabled();
+	}
+};
+
+// Tessellated output of recent draws.  Many games resubmit the same patches every frame,
+// so keep the result around, keyed by the control points and everything else that affects it.
+class TessellationCache {
+public:
+	// Doesn't touch the cache itself, since the GE debugger also tessellates from the UI thread.
+	// The points are hashed in chunks through a stack buffer, chaining each hash into the next seed.
+	static u64 ComputeKey(const SurfaceInfo &surface, const ControlPoints &points, u32 flags) {
+		const u32 params[] = {
+			(u32)surface.tess_u, (u32)surface.tess_v, (u32)surface.num_points_u, (u32)surface.num_points_v,
+			(u32)surface.type_u, (u32)surface.type_v, (u32)surface.primType, (u32)surface.patchFacing,
+			(u32)points.defcolor, flags,
+		};
+		u64 key = XXH3_64bits(params, sizeof(params));
+
+		float buf[KEY_CHUNK_POINTS * 9];
+		for (int start = 0; start < points.size; start += KEY_CHUNK_POINTS) {
+			const int count = std::min(points.size - start, (int)KEY_CHUNK_POINTS);
+			float *f = buf;
+			for (int i = start; i < start + count; ++i) {
+				memcpy(f, points.pos[i].AsArray(), sizeof(float) * 3);
+				memcpy(f + 3, points.tex[i].AsArray(), sizeof(float) * 2);
+				memcpy(f + 5, points.col[i].AsArray(), sizeof(float) * 4);
+				f += 9;
+			}
+			key = XXH3_64bits_withSeed(buf, count * 9 * sizeof(float), key);
+		}
+		return key;
+	}
+
+	// Returns true if the output was filled in from the cache.
+	bool Lookup(u64 key, OutputBuffers &output) {
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = entries_.find(key);
+		if (it == entries_.end() || it->second.vertices.empty())
+			return false;
+		Entry &entry = it->second;
+		entry.lastFrame = gpuStats.numFlips;
+		memcpy(output.vertices, entry.vertices.data(), entry.vertices.size() * sizeof(SimpleVertex));
+		memcpy(output.indices, entry.indices.data(), entry.indices.size() * sizeof(u16));
+		output.count = (int)entry.indices.size();
+		return true;
+	}
+
+	// Only keeps the data once the same key shows up a second time, so animated patches don't churn the cache.
+	void Store(u64 key, const OutputBuffers &output, int numVertices) {
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = entries_.find(key);
+		if (it == entries_.end()) {
+			Entry &entry = entries_[key];
+			entry.lastFrame = gpuStats.numFlips;
+		} else if (it->second.vertices.empty()) {
+			Entry &entry = it->second;
+			entry.lastFrame = gpuStats.numFlips;
+			entry.vertices.assign(output.vertices, output.vertices + numVertices);
+			entry.indices.assign(output.indices, output.indices + output.count);
+			bytes_ += entry.Bytes();
+		}
+		Trim();
+	}
+
+	void Clear() {
+		std::lock_guard<std::mutex> guard(lock_);
+		entries_.clear();
+		bytes_ = 0;
+	}
+
+private:
+	struct Entry {
+		std::vector<SimpleVertex> vertices;
+		std::vector<u16> indices;
+		int lastFrame = 0;
+
+		size_t Bytes() const {
+			return vertices.size() * sizeof(SimpleVertex) + indices.size() * sizeof(u16);
+		}
+	};
+
+	void Trim() {
+		while (bytes_ > MAX_BYTES || entries_.size() > MAX_ENTRIES) {
+			auto oldest = entries_.begin();
+			for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+				if (it->second.lastFrame < oldest->second.lastFrame)
+					oldest = it;
+			}
+			bytes_ -= oldest->second.Bytes();
+			entries_.erase(oldest);
+		}
+	}
+
+	static const size_t MAX_BYTES = 8 * 1024 * 1024;
+	static const size_t MAX_ENTRIES = 256;
+	static const int KEY_CHUNK_POINTS = 64;
+
+	std::unordered_map<u64, Entry> entries_;
+	size_t bytes_ = 0;
+	std::mutex lock_;
 };
 
+static TessellationCache tessCache;
+
+u64 TessellationCacheKey(const SurfaceInfo &surface, const ControlPoints &points, u32 origVertType) {
+	// Bit 31 isn't part of any vertex type field, so it can't alias one of them.
+	const u32 normalsFlag = SubdivisionSurface<BezierSurface>::NeedsNormals(origVertType) ? (1u << 31) : 0;
+	const u32 flags = (origVertType & (GE_VTYPE_NRM_MASK | GE_VTYPE_COL_MASK | GE_VTYPE_TC_MASK)) | normalsFlag;
+	return TessellationCache::ComputeKey(surface, points, flags);
+}
+
 template<class Surface>
 void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType, const ControlPoints &points) {
+	const u64 cacheKey = TessellationCacheKey(surface, points, origVertType);
+	if (tessCache.Lookup(cacheKey, output))
+		return;
+
 	using WeightType = typename Surface::WeightType;
 	u32 key_u = WeightType::ToKey(surface.tess_u, surface.num_points_u, surface.type_u);
 	u32 key_v = WeightType::ToKey(surface.tess_v, surface.num_points_v, surface.type_v);
 	Weight2D weights(WeightType::weightsCache, key_u, key_v);
 
 	SubdivisionSurface<Surface>::Tessellate(output, surface, points, weights, origVertType);
+	tessCache.Store(cacheKey, output, surface.GetNumVertices());
 }
 
 template void SoftwareTessellation<BezierSurface>(OutputBuffers &output, const BezierSurface &surface, u32 origVertType, const ControlPoints &points);
@@ -483,6 +752,7 @@ using namespace Spline;
 void DrawEngineCommon::ClearSplineBezierWeights() {
 	Bezier3DWeight::weightsCache.Clear();
 	Spline3DWeight::weightsCache.Clear();
+	tessCache.Clear();
 }
 
 // Specialize to make instance (to avoid link error).
@@ -97,6 +97,8 @@ struct BezierSurface : public SurfaceInfo {
 		num_verts_per_patch = (tess_u + 1) * (tess_v + 1);
 	}
 
+	int GetNumVertices() const { return num_verts_per_patch * num_patches_u * num_patches_v; }
+
 	int GetTessStart(int patch) const { return 0; }
 
 	int GetPointIndex(int patch_u, int patch_v) const { return patch_v * 3 * num_points_u + patch_u * 3; }
@@ -135,6 +137,8 @@ struct SplineSurface : public SurfaceInfo {
 		num_vertices_u = num_patches_u * tess_u + 1;
 	}
 
+	int GetNumVertices() const { return num_vertices_u * (num_patches_v * tess_v + 1); }
+
 	int GetTessStart(int patch) const { return (patch == 0) ? 0 : 1; }
 
 	int GetPointIndex(int patch_u, int patch_v) const { return patch_v * num_points_u + patch_u; }
@@ -190,6 +194,7 @@ struct ControlPoints {
 	Vec2f *tex;
 	Vec4f *col;
 	u32_le defcolor;
+	int size = 0;
 
 	ControlPoints() {}
 	ControlPoints(const SimpleVertex *const *points, int size, SimpleBufferManager &managedBuf);
@@ -205,6 +210,9 @@ struct OutputBuffers {
 template<class Surface>
 void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType, const ControlPoints &points);
 
+// Identifies a software tessellation result by its inputs, including the parts of the vertex type and state that affect it.
+u64 TessellationCacheKey(const SurfaceInfo &surface, const ControlPoints &points, u32 origVertType);
+
 } // namespace Spline
 
 // Define function object for TemplateParameterDispatcher
@@ -30,6 +30,7 @@
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/TextureScalerCommon.h"
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Debugger/Debugger.h"
@@ -392,6 +393,9 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 
 	TexCache::iterator entryIter = cache_.find(cachekey);
 	TexCacheEntry *entry = nullptr;
+	gpuStats.numTextureLookups++;
+	if (entryIter == cache_.end())
+		gpuStats.numTextureLookupMisses++;
 
 	// Note: It's necessary to reset needshadertexclamp, for otherwise DIRTY_TEXCLAMP won't get set later.
 	// Should probably revisit how this works..
@@ -433,6 +437,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			entry->status &= ~TexCacheEntry::STATUS_FORCE_REBUILD;
 		}
 
+		bool periodicRehash = false;
 		if (match) {
 			if (entry->lastFrame != gpuStats.numFlips) {
 				u32 diff = gpuStats.numFlips - entry->lastFrame;
@@ -446,7 +451,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 					} else {
 						entry->framesUntilNextFullHash = entry->numFrames;
 					}
-					rehash = true;
+					periodicRehash = true;
 				} else {
 					entry->framesUntilNextFullHash -= diff;
 				}
@@ -463,10 +468,39 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 				reason = "minihash";
 			} else if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
 				rehash = false;
+				periodicRehash = false;
 			}
 		}
 
-		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
+		if (match && periodicRehash && !rehash) {
+			// Invalidated textures must be checked now, but the backoff rehashes can wait a frame.
+			// Always allow at least one per frame so large textures still get their turn.
+			if ((entry->status & TexCacheEntry::STATUS_INVALIDATED) || rehashBytesThisFrame_ == 0 || rehashBytesThisFrame_ + entry->sizeInRAM <= rehashFrameBudget_) {
+				rehashBytesThisFrame_ += entry->sizeInRAM;
+				rehash = true;
+			} else {
+				entry->framesUntilNextFullHash = 0;
+				gpuStats.numTextureRehashesDeferred++;
+			}
+		}
+
+		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && g_Config.bTexScalingAsync) {
+			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+				TextureScalerCommon &scaler = GetScaler();
+				if (scaler.IsScaleReady(entry->CacheKey(), entry->fullhash)) {
+					if (scaledSwapTimeThisFrame_ < scaledSwapFrameBudget_) {
+						// Swapping in the scaled version isn't a real change, don't count it as one.
+						entry->status |= TexCacheEntry::STATUS_FREE_CHANGE;
+						match = false;
+						reason = "scaled";
+					}
+				} else if (!scaler.IsScalePending(entry->CacheKey(), entry->fullhash) && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
+					// The result was dropped (or never queued), so we need the data again.
+					match = false;
+					reason = "scaling";
+				}
+			}
+		} else if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
 			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
 				// INFO_LOG(G3D, "Reloading texture to do the scaling we skipped..");
 				match = false;
@@ -614,7 +648,8 @@ std::vector<AttachCandidate> TextureCacheCommon::GetFramebufferCandidates(const
 		return std::vector<AttachCandidate>();
 	}
 
-	const std::vector<VirtualFramebuffer *> &framebuffers = framebufferManager_->Framebuffers();
+	const bool depth = channel == FramebufferNotificationChannel::NOTIFY_FB_DEPTH;
+	const std::vector<VirtualFramebuffer *> &framebuffers = framebufferManager_->GetFramebuffersNearTexture(entry.addr + texAddrOffset, depth);
 
 	for (VirtualFramebuffer *framebuffer : framebuffers) {
 		FramebufferMatchInfo match = MatchFramebuffer(entry, framebuffer, texAddrOffset, channel);
@@ -628,7 +663,6 @@ std::vector<AttachCandidate> TextureCacheCommon::GetFramebufferCandidates(const
 	}
 
 	if (candidates.size() > 1) {
-		bool depth = channel == FramebufferNotificationChannel::NOTIFY_FB_DEPTH;
 		WARN_LOG_REPORT_ONCE(multifbcandidate, G3D, "GetFramebufferCandidates(%s): Multiple (%d) candidate framebuffers. texaddr: %08x offset: %d (%dx%d stride %d, %s)",
 			depth ? "DEPTH" : "COLOR", (int)candidates.size(), entry.addr, texAddrOffset, dimWidth(entry.dim), dimHeight(entry.dim), entry.bufw, GeTextureFormatToString(entry.format));
 	}
@@ -1357,18 +1391,16 @@ static void DecodeDXTBlock(uint8_t *out, int outPitch, uint32_t texaddr, const u
 		h = (((int)limited / sizeof(DXTBlock)) / (bufw / 4)) * 4;
 	}
 
+	const int blocksPerRow = (minw + 3) / 4;
 	for (int y = 0; y < h; y += 4) {
 		u32 blockIndex = (y / 4) * (bufw / 4);
 		int blockHeight = std::min(h - y, 4);
-		for (int x = 0; x < minw; x += 4) {
-			if (n == 1)
-				DecodeDXT1Block(dst + outPitch32 * y + x, (const DXT1Block *)src + blockIndex, outPitch32, blockHeight, false);
-			if (n == 3)
-				DecodeDXT3Block(dst + outPitch32 * y + x, (const DXT3Block *)src + blockIndex, outPitch32, blockHeight);
-			if (n == 5)
-				DecodeDXT5Block(dst + outPitch32 * y + x, (const DXT5Block *)src + blockIndex, outPitch32, blockHeight);
-			blockIndex++;
-		}
+		if (n == 1)
+			DecodeDXT1Blocks(dst + outPitch32 * y, (const DXT1Block *)src + blockIndex, blocksPerRow, outPitch32, blockHeight, false);
+		if (n == 3)
+			DecodeDXT3Blocks(dst + outPitch32 * y, (const DXT3Block *)src + blockIndex, blocksPerRow, outPitch32, blockHeight);
+		if (n == 5)
+			DecodeDXT5Blocks(dst + outPitch32 * y, (const DXT5Block *)src + blockIndex, blocksPerRow, outPitch32, blockHeight);
 	}
 	w = (w + 3) & ~3;
 	if (reverseColors) {
@@ -1673,10 +1705,13 @@ void TextureCacheCommon::ApplyTexture() {
 
 		if (nextNeedsRehash_) {
 			PROFILE_THIS_SCOPE("texhash");
+			double hashStart = coreCollectDebugStats ? time_now_d() : 0.0;
 			// Update the hash on the texture.
 			int w = gstate.getTextureWidth(0);
 			int h = gstate.getTextureHeight(0);
 			entry->fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
+			if (hashStart != 0.0)
+				gpuStats.msHashingTextures += time_now_d() - hashStart;
 
 			// TODO: Here we could check the secondary cache; maybe the texture is in there?
 			// We would need to abort the build if so.
@@ -1704,8 +1739,17 @@ void TextureCacheCommon::ApplyTexture() {
 	// Okay, now actually rebuild the texture if needed.
 	if (nextNeedsRebuild_) {
 		_assert_(!entry->texturePtr);
+		bool scaledSwap = g_Config.bTexScalingAsync && (entry->status & TexCacheEntry::STATUS_TO_SCALE) != 0;
+		double buildStart = (scaledSwap || coreCollectDebugStats) ? time_now_d() : 0.0;
 		BuildTexture(entry);
 		InvalidateLastTexture();
+		deferredScaleFactor_ = 1;
+		if (buildStart != 0.0) {
+			double buildTime = time_now_d() - buildStart;
+			if (scaledSwap)
+				scaledSwapTimeThisFrame_ += buildTime;
+			gpuStats.msDecodingTextures += buildTime;
+		}
 	}
 
 	entry->lastFrame = gpuStats.numFlips;
@@ -1713,8 +1757,36 @@ void TextureCacheCommon::ApplyTexture() {
 	gstate_c.SetTextureFullAlpha(entry->GetAlphaStatus() == TexCacheEntry::STATUS_ALPHA_FULL);
 }
 
+bool TextureCacheCommon::DeferScaling(TexCacheEntry *entry, int &scaleFactor) {
+	if (!g_Config.bTexScalingAsync || scaleFactor == 1)
+		return false;
+
+	TextureScalerCommon &scaler = GetScaler();
+	u64 cachekey = entry->CacheKey();
+	if (scaler.IsScaleReady(cachekey, entry->fullhash))
+		return false;
+
+	// Upload it unscaled now, and queue the scaling unless it's already in progress.
+	entry->status |= TexCacheEntry::STATUS_TO_SCALE;
+	deferredScaleFactor_ = scaler.IsScalePending(cachekey, entry->fullhash) ? 1 : scaleFactor;
+	scaleFactor = 1;
+	return true;
+}
+
+void TextureCacheCommon::QueueDeferredScaling(const TexCacheEntry &entry, const u8 *data, int pitch, u32 fmt, int w, int h) {
+	int factor = deferredScaleFactor_;
+	deferredScaleFactor_ = 1;
+	if (factor == 1)
+		return;
+
+	if (GetScaler().ScaleAsync(entry.CacheKey(), entry.fullhash, data, pitch, fmt, w, h, factor)) {
+		texelsScaledThisFrame_ += w * h;
+	}
+}
+
 void TextureCacheCommon::Clear(bool delete_them) {
 	ForgetLastTexture();
+	GetScaler().ClearAsync();
 	for (TexCache::iterator iter = cache_.begin(); iter != cache_.end(); ++iter) {
 		ReleaseTexture(iter->second.get(), delete_them);
 	}
@@ -1742,6 +1814,7 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
 	bool isVideo = IsVideo(entry->addr);
+	entry->status &= ~TexCacheEntry::STATUS_INVALIDATED;
 
 	// Don't even check the texture, just assume it has changed.
 	if (isVideo && g_Config.bTextureBackoffCache) {
@@ -1753,7 +1826,10 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	u32 fullhash;
 	{
 		PROFILE_THIS_SCOPE("texhash");
+		double hashStart = coreCollectDebugStats ? time_now_d() : 0.0;
 		fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
+		if (hashStart != 0.0)
+			gpuStats.msHashingTextures += time_now_d() - hashStart;
 	}
 
 	if (fullhash == entry->fullhash) {
@@ -1882,6 +1958,7 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 					}
 				}
 				entry->framesUntilNextFullHash = 0;
+				entry->status |= TexCacheEntry::STATUS_INVALIDATED;
 			} else {
 				entry->invalidHint++;
 			}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -48,6 +49,7 @@ enum FramebufferNotificationChannel {
 
 struct VirtualFramebuffer;
 class TextureReplacer;
+class TextureScalerCommon;
 
 namespace Draw {
 class DrawContext;
@@ -134,6 +136,9 @@ struct TexCacheEntry {
 		STATUS_FRAMEBUFFER_OVERLAP = 0x1000,
 
 		STATUS_FORCE_REBUILD = 0x2000,
+
+		// Memory was invalidated since the last full hash, so the next rehash can't be deferred.
+		STATUS_INVALIDATED = 0x4000,
 	};
 
 	// Status, but int so we can zero initialize.
@@ -187,9 +192,49 @@ struct TexCacheEntry {
 	static u64 CacheKey(u32 addr, u8 format, u16 dim, u32 cluthash);
 };
 
-// Can't be unordered_map, we use lower_bound ... although for some reason that (used to?) compiles on MSVC.
-// Would really like to replace this with DenseHashMap but can't as long as we need lower_bound.
-typedef std::map<u64, std::unique_ptr<TexCacheEntry>> TexCache;
+// Exact lookups (the hot path in SetTexture) go through a hash index, while range queries
+// (invalidation, CLUT rechecks) still use the ordered map underneath with lower_bound.
+// Iterators are plain map iterators, and stay valid until their entry is erased.
+class TexCache {
+public:
+	typedef std::map<u64, std::unique_ptr<TexCacheEntry>> Map;
+	typedef Map::iterator iterator;
+
+	iterator begin() { return entries_.begin(); }
+	iterator end() { return entries_.end(); }
+	iterator lower_bound(u64 key) { return entries_.lower_bound(key); }
+	iterator upper_bound(u64 key) { return entries_.upper_bound(key); }
+	size_t size() const { return entries_.size(); }
+	bool empty() const { return entries_.empty(); }
+
+	iterator find(u64 key) {
+		auto it = index_.find(key);
+		return it == index_.end() ? entries_.end() : it->second;
+	}
+
+	std::unique_ptr<TexCacheEntry> &operator[](u64 key) {
+		auto it = index_.find(key);
+		if (it != index_.end())
+			return it->second->second;
+		iterator pos = entries_.emplace_hint(entries_.lower_bound(key), key, nullptr);
+		index_[key] = pos;
+		return pos->second;
+	}
+
+	iterator erase(iterator pos) {
+		index_.erase(pos->first);
+		return entries_.erase(pos);
+	}
+
+	void clear() {
+		index_.clear();
+		entries_.clear();
+	}
+
+private:
+	Map entries_;
+	std::unordered_map<u64, iterator> index_;
+};
 
 // Urgh.
 #ifdef IGNORE
@@ -280,6 +325,11 @@ class TextureCacheCommon {
 	void ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool expandTo32Bit);
 	ReplacedTexture &FindReplacement(TexCacheEntry *entry, int &w, int &h);
 
+	// Background scaling: the texture is built unscaled first, and rebuilt once the scaled version is ready.
+	virtual TextureScalerCommon &GetScaler() = 0;
+	bool DeferScaling(TexCacheEntry *entry, int &scaleFactor);
+	void QueueDeferredScaling(const TexCacheEntry &entry, const u8 *data, int pitch, u32 fmt, int w, int h);
+
 	template <typename T>
 	inline const T *GetCurrentClut() {
 		return (const T *)clutBuf_;
@@ -339,6 +389,14 @@ class TextureCacheCommon {
 	double replacementTimeThisFrame_ = 0;
 	// TODO: Maybe vary by FPS...
 	double replacementFrameBudget_ = 0.5 / 60.0;
+	double scaledSwapTimeThisFrame_ = 0;
+	double scaledSwapFrameBudget_ = 0.5 / 60.0;
+	// Periodic (backoff) rehashes are spread out so a burst of them doesn't land on one frame.
+	// Rehashes caused by invalidation are never delayed.
+	u32 rehashBytesThisFrame_ = 0;
+	u32 rehashFrameBudget_ = 1024 * 1024;
+	// Set by DeferScaling() for the level 0 load that follows.
+	int deferredScaleFactor_ = 1;
 
 	TexCache cache_;
 	u32 cacheSizeEstimate_ = 0;
@@ -32,6 +32,17 @@
 #if _M_SSE >= 0x401
 #include <smmintrin.h>
 #endif
+#include <tmmintrin.h>
+#include <immintrin.h>
+
+// SSSE3 and AVX2 code is only called after checking cpu_info, so just those functions are compiled for it.
+#if defined(_MSC_VER)
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
 
 u32 QuickTexHashSSE2(const void *checkp, u32 size) {
 	u32 check = 0;
@@ -65,6 +76,166 @@ u32 QuickTexHashSSE2(const void *checkp, u32 size) {
 
 	return check;
 }
+
+// Same idea as the SSE2 hash, with twice the lanes, so the results differ.
+TARGET_AVX2 u32 QuickTexHashAVX2(const void *checkp, u32 size) {
+	if (((intptr_t)checkp & 0xf) != 0 || (size & 0x7f) != 0) {
+		return QuickTexHashSSE2(checkp, size);
+	}
+
+	__m256i cursor = _mm256_setzero_si256();
+	__m256i cursor2 = _mm256_set_epi16(0x0001U, 0x0083U, 0x4309U, 0x4d9bU, 0xb651U, 0x4b73U, 0x9bd9U, 0xc00bU,
+		0x0107U, 0x2c39U, 0x6a1dU, 0x8f47U, 0x3b5fU, 0xd2a3U, 0x5e65U, 0xe0b1U);
+	const __m256i update = _mm256_set1_epi16(0x2455U);
+	const __m256i *p = (const __m256i *)checkp;
+	for (u32 i = 0; i < size / 32; i += 4) {
+		__m256i chunk = _mm256_mullo_epi16(_mm256_loadu_si256(&p[i]), cursor2);
+		cursor = _mm256_add_epi16(cursor, chunk);
+		cursor = _mm256_xor_si256(cursor, _mm256_loadu_si256(&p[i + 1]));
+		cursor = _mm256_add_epi32(cursor, _mm256_loadu_si256(&p[i + 2]));
+		chunk = _mm256_mullo_epi16(_mm256_loadu_si256(&p[i + 3]), cursor2);
+		cursor = _mm256_xor_si256(cursor, chunk);
+		cursor2 = _mm256_add_epi16(cursor2, update);
+	}
+	cursor = _mm256_add_epi32(cursor, cursor2);
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(cursor), _mm256_extracti128_si256(cursor, 1));
+	sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+	return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+static void DeIndexTexture4To16Basic(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	for (int i = 0; i < length; i += 2) {
+		u8 index = *indexed++;
+		dest[i + 0] = clut[(index >> 0) & 0xf];
+		dest[i + 1] = clut[(index >> 4) & 0xf];
+	}
+}
+
+static void DeIndexTexture4To32Basic(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	for (int i = 0; i < length; i += 2) {
+		u8 index = *indexed++;
+		dest[i + 0] = clut[(index >> 0) & 0xf];
+		dest[i + 1] = clut[(index >> 4) & 0xf];
+	}
+}
+
+#ifdef _M_SSE
+// A 16 entry palette fits in registers as byte planes, so each pshufb looks up 16 pixels at once.
+// Returns the 16 indices for 8 bytes of CLUT4 data, in pixel order.
+TARGET_SSSE3 static inline __m128i ExpandNibbles(__m128i packed) {
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	__m128i low = _mm_and_si128(packed, mask);
+	__m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+	return _mm_unpacklo_epi8(low, high);
+}
+
+// Splits 8 u16 or 4 u32 entries into byte planes, low byte first.
+TARGET_SSSE3 static inline __m128i SplitBytes16(__m128i v) {
+	return _mm_shuffle_epi8(v, _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15));
+}
+
+TARGET_SSSE3 static inline __m128i SplitBytes32(__m128i v) {
+	return _mm_shuffle_epi8(v, _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15));
+}
+
+TARGET_SSSE3 static void DeIndexTexture4To16SSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	if (length < 16) {
+		DeIndexTexture4To16Basic(dest, indexed, length, clut);
+		return;
+	}
+
+	__m128i c0 = SplitBytes16(_mm_loadu_si128((const __m128i *)clut));
+	__m128i c1 = SplitBytes16(_mm_loadu_si128((const __m128i *)(clut + 8)));
+	const __m128i lo = _mm_unpacklo_epi64(c0, c1);
+	const __m128i hi = _mm_unpackhi_epi64(c0, c1);
+
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m128i idx = ExpandNibbles(_mm_loadl_epi64((const __m128i *)(indexed + i / 2)));
+		__m128i rl = _mm_shuffle_epi8(lo, idx);
+		__m128i rh = _mm_shuffle_epi8(hi, idx);
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_unpacklo_epi8(rl, rh));
+		_mm_storeu_si128((__m128i *)(dest + i + 8), _mm_unpackhi_epi8(rl, rh));
+	}
+	if (i < length) {
+		DeIndexTexture4To16Basic(dest + i, indexed + i / 2, length - i, clut);
+	}
+}
+
+TARGET_SSSE3 static void DeIndexTexture4To32SSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	if (length < 16) {
+		DeIndexTexture4To32Basic(dest, indexed, length, clut);
+		return;
+	}
+
+	// Transpose the 16 entries into four planes, one per byte.
+	__m128i c0 = SplitBytes32(_mm_loadu_si128((const __m128i *)clut));
+	__m128i c1 = SplitBytes32(_mm_loadu_si128((const __m128i *)(clut + 4)));
+	__m128i c2 = SplitBytes32(_mm_loadu_si128((const __m128i *)(clut + 8)));
+	__m128i c3 = SplitBytes32(_mm_loadu_si128((const __m128i *)(clut + 12)));
+	__m128i t0 = _mm_unpacklo_epi32(c0, c1);
+	__m128i t1 = _mm_unpackhi_epi32(c0, c1);
+	__m128i t2 = _mm_unpacklo_epi32(c2, c3);
+	__m128i t3 = _mm_unpackhi_epi32(c2, c3);
+	const __m128i b0 = _mm_unpacklo_epi64(t0, t2);
+	const __m128i b1 = _mm_unpackhi_epi64(t0, t2);
+	const __m128i b2 = _mm_unpacklo_epi64(t1, t3);
+	const __m128i b3 = _mm_unpackhi_epi64(t1, t3);
+
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m128i idx = ExpandNibbles(_mm_loadl_epi64((const __m128i *)(indexed + i / 2)));
+		__m128i r0 = _mm_shuffle_epi8(b0, idx);
+		__m128i r1 = _mm_shuffle_epi8(b1, idx);
+		__m128i r2 = _mm_shuffle_epi8(b2, idx);
+		__m128i r3 = _mm_shuffle_epi8(b3, idx);
+		__m128i lo01 = _mm_unpacklo_epi8(r0, r1);
+		__m128i hi01 = _mm_unpackhi_epi8(r0, r1);
+		__m128i lo23 = _mm_unpacklo_epi8(r2, r3);
+		__m128i hi23 = _mm_unpackhi_epi8(r2, r3);
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_unpacklo_epi16(lo01, lo23));
+		_mm_storeu_si128((__m128i *)(dest + i + 4), _mm_unpackhi_epi16(lo01, lo23));
+		_mm_storeu_si128((__m128i *)(dest + i + 8), _mm_unpacklo_epi16(hi01, hi23));
+		_mm_storeu_si128((__m128i *)(dest + i + 12), _mm_unpackhi_epi16(hi01, hi23));
+	}
+	if (i < length) {
+		DeIndexTexture4To32Basic(dest + i, indexed + i / 2, length - i, clut);
+	}
+}
+
+// Same as the SSSE3 version, but 32 pixels per iteration with the planes in both lanes.
+TARGET_AVX2 static void DeIndexTexture4To16AVX2(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	if (length < 32) {
+		DeIndexTexture4To16SSSE3(dest, indexed, length, clut);
+		return;
+	}
+
+	__m128i c0 = SplitBytes16(_mm_loadu_si128((const __m128i *)clut));
+	__m128i c1 = SplitBytes16(_mm_loadu_si128((const __m128i *)(clut + 8)));
+	const __m256i lo = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(c0, c1));
+	const __m256i hi = _mm256_broadcastsi128_si256(_mm_unpackhi_epi64(c0, c1));
+	const __m128i mask = _mm_set1_epi8(0x0F);
+
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m128i packed = _mm_loadu_si128((const __m128i *)(indexed + i / 2));
+		__m128i low = _mm_and_si128(packed, mask);
+		__m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+		__m256i idx = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(low, high)), _mm_unpackhi_epi8(low, high), 1);
+		__m256i rl = _mm256_shuffle_epi8(lo, idx);
+		__m256i rh = _mm256_shuffle_epi8(hi, idx);
+		// The unpacks work per lane, so put the halves back in pixel order.
+		__m256i first = _mm256_unpacklo_epi8(rl, rh);
+		__m256i second = _mm256_unpackhi_epi8(rl, rh);
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256((__m256i *)(dest + i + 16), _mm256_permute2x128_si256(first, second, 0x31));
+	}
+	if (i < length) {
+		DeIndexTexture4To16SSSE3(dest + i, indexed + i / 2, length - i, clut);
+	}
+}
 #endif
 
 // Masks to downalign bufw to 16 bytes, and wrap at 2048.
@@ -307,7 +478,16 @@ void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32
 	}
 }
 
-#if !PPSSPP_ARCH(ARM64) && !defined(_M_SSE)
+DeIndexTexture4To16Func DoDeIndexTexture4To16 = &DeIndexTexture4To16Basic;
+DeIndexTexture4To32Func DoDeIndexTexture4To32 = &DeIndexTexture4To32Basic;
+#ifdef _M_SSE
+static bool useSSSE3DXT = false;
+static void InitDXTLineShuffles();
+#endif
+
+#if defined(_M_SSE)
+QuickTexHashFunc DoQuickTexHash = &QuickTexHashSSE2;
+#elif !PPSSPP_ARCH(ARM64)
 QuickTexHashFunc DoQuickTexHash = &QuickTexHashBasic;
 QuickTexHashFunc StableQuickTexHash = &QuickTexHashNonSSE;
 UnswizzleTex16Func DoUnswizzleTex16 = &DoUnswizzleTex16Basic;
@@ -315,6 +495,19 @@ UnswizzleTex16Func DoUnswizzleTex16 = &DoUnswizzleTex16Basic;
 
 // This has to be done after CPUDetect has done its magic.
 void SetupTextureDecoder() {
+#if defined(_M_SSE)
+	DoQuickTexHash = cpu_info.bAVX2 ? &QuickTexHashAVX2 : &QuickTexHashSSE2;
+	if (cpu_info.bSSSE3) {
+		DoDeIndexTexture4To16 = cpu_info.bAVX2 ? &DeIndexTexture4To16AVX2 : &DeIndexTexture4To16SSSE3;
+		DoDeIndexTexture4To32 = &DeIndexTexture4To32SSSE3;
+		InitDXTLineShuffles();
+		useSSSE3DXT = true;
+	} else {
+		DoDeIndexTexture4To16 = &DeIndexTexture4To16Basic;
+		DoDeIndexTexture4To32 = &DeIndexTexture4To32Basic;
+		useSSSE3DXT = false;
+	}
+#endif
 #if PPSSPP_ARCH(ARM_NEON) && !PPSSPP_ARCH(ARM64)
 	if (cpu_info.bNEON) {
 		DoQuickTexHash = &QuickTexHashNEON;
@@ -333,6 +526,13 @@ class DXTDecoder {
 	inline void WriteColorsDXT3(u32 *dst, const DXT3Block *src, int pitch, int height);
 	inline void WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int height);
 
+	const u32 *Colors() const {
+		return colors_;
+	}
+	const u8 *Alpha() const {
+		return alpha_;
+	}
+
 protected:
 	u32 colors_[4];
 	u8 alpha_[8];
@@ -530,6 +730,120 @@ void DecodeDXT5Block(u32 *dst, const DXT5Block *src, int pitch, int height) {
 	dxt.WriteColorsDXT5(dst, src, pitch, height);
 }
 
+#ifdef _M_SSE
+// For each DXT line byte, the pshufb mask that picks the four texels out of the four colors.
+static __m128i dxtLineShuffles[256];
+
+static void InitDXTLineShuffles() {
+	for (int line = 0; line < 256; ++line) {
+		u8 bytes[16];
+		for (int x = 0; x < 4; ++x) {
+			int c = (line >> (x * 2)) & 3;
+			for (int k = 0; k < 4; ++k) {
+				bytes[x * 4 + k] = (u8)(c * 4 + k);
+			}
+		}
+		memcpy(&dxtLineShuffles[line], bytes, sizeof(bytes));
+	}
+}
+
+TARGET_SSSE3 static inline __m128i DXTColorLine(__m128i colors, u8 line) {
+	return _mm_shuffle_epi8(colors, _mm_load_si128(&dxtLineShuffles[line]));
+}
+
+TARGET_SSSE3 static void DecodeDXT1BlocksSSSE3(u32 *dst, const DXT1Block *src, int count, int pitch, int height, bool ignore1bitAlpha) {
+	DXTDecoder dxt;
+	for (int i = 0; i < count; ++i) {
+		dxt.DecodeColors(&src[i], ignore1bitAlpha);
+		__m128i colors = _mm_loadu_si128((const __m128i *)dxt.Colors());
+		u32 *d = dst + i * 4;
+		for (int y = 0; y < height; y++) {
+			_mm_storeu_si128((__m128i *)d, DXTColorLine(colors, src[i].lines[y]));
+			d += pitch;
+		}
+	}
+}
+
+TARGET_SSSE3 static void DecodeDXT3BlocksSSSE3(u32 *dst, const DXT3Block *src, int count, int pitch, int height) {
+	DXTDecoder dxt;
+	for (int i = 0; i < count; ++i) {
+		dxt.DecodeColors(&src[i].color, true);
+		__m128i colors = _mm_loadu_si128((const __m128i *)dxt.Colors());
+		u32 *d = dst + i * 4;
+		for (int y = 0; y < height; y++) {
+			u32 a = src[i].alphaLines[y];
+			// The shift drops the other nibbles.
+			__m128i alpha = _mm_slli_epi32(_mm_setr_epi32(a, a >> 4, a >> 8, a >> 12), 28);
+			_mm_storeu_si128((__m128i *)d, _mm_or_si128(DXTColorLine(colors, src[i].color.lines[y]), alpha));
+			d += pitch;
+		}
+	}
+}
+
+TARGET_SSSE3 static void DecodeDXT5BlocksSSSE3(u32 *dst, const DXT5Block *src, int count, int pitch, int height) {
+	DXTDecoder dxt;
+	for (int i = 0; i < count; ++i) {
+		dxt.DecodeColors(&src[i].color, true);
+		dxt.DecodeAlphaDXT5(&src[i]);
+		__m128i colors = _mm_loadu_si128((const __m128i *)dxt.Colors());
+		__m128i alphas = _mm_loadl_epi64((const __m128i *)dxt.Alpha());
+		u64 alphadata = ((u64)(u16)src[i].alphadata1 << 32) | (u32)src[i].alphadata2;
+		u32 *d = dst + i * 4;
+		for (int y = 0; y < height; y++) {
+			// Pick the alpha into the top byte of each texel, 0x80 zeroes the rest.
+			u32 a = (u32)(alphadata >> (y * 12));
+			__m128i pick = _mm_setr_epi32(((a & 7) << 24) | 0x808080, (((a >> 3) & 7) << 24) | 0x808080, (((a >> 6) & 7) << 24) | 0x808080, (((a >> 9) & 7) << 24) | 0x808080);
+			__m128i alpha = _mm_shuffle_epi8(alphas, pick);
+			_mm_storeu_si128((__m128i *)d, _mm_or_si128(DXTColorLine(colors, src[i].color.lines[y]), alpha));
+			d += pitch;
+		}
+	}
+}
+#endif
+
+void DecodeDXT1Blocks(u32 *dst, const DXT1Block *src, int count, int pitch, int height, bool ignore1bitAlpha) {
+#ifdef _M_SSE
+	if (useSSSE3DXT) {
+		DecodeDXT1BlocksSSSE3(dst, src, count, pitch, height, ignore1bitAlpha);
+		return;
+	}
+#endif
+	DXTDecoder dxt;
+	for (int i = 0; i < count; ++i) {
+		dxt.DecodeColors(&src[i], ignore1bitAlpha);
+		dxt.WriteColorsDXT1(dst + i * 4, &src[i], pitch, height);
+	}
+}
+
+void DecodeDXT3Blocks(u32 *dst, const DXT3Block *src, int count, int pitch, int height) {
+#ifdef _M_SSE
+	if (useSSSE3DXT) {
+		DecodeDXT3BlocksSSSE3(dst, src, count, pitch, height);
+		return;
+	}
+#endif
+	DXTDecoder dxt;
+	for (int i = 0; i < count; ++i) {
+		dxt.DecodeColors(&src[i].color, true);
+		dxt.WriteColorsDXT3(dst + i * 4, &src[i], pitch, height);
+	}
+}
+
+void DecodeDXT5Blocks(u32 *dst, const DXT5Block *src, int count, int pitch, int height) {
+#ifdef _M_SSE
+	if (useSSSE3DXT) {
+		DecodeDXT5BlocksSSSE3(dst, src, count, pitch, height);
+		return;
+	}
+#endif
+	DXTDecoder dxt;
+	for (int i = 0; i < count; ++i) {
+		dxt.DecodeColors(&src[i].color, true);
+		dxt.DecodeAlphaDXT5(&src[i]);
+		dxt.WriteColorsDXT5(dst + i * 4, &src[i], pitch, height);
+	}
+}
+
 #ifdef _M_SSE
 static inline u32 CombineSSEBitsToDWORD(const __m128i &v) {
 	__m128i temp;
@@ -37,10 +37,15 @@ void SetupTextureDecoder();
 // Pitch must be aligned to 16 bits (as is the case on a PSP)
 void DoSwizzleTex16(const u32 *ysrcp, u8 *texptr, int bxc, int byc, u32 pitch);
 
-// For SSE, we statically link the SSE2 algorithms.
+typedef u32 (*QuickTexHashFunc)(const void *checkp, u32 size);
+
+// For SSE, we statically link the SSE2 algorithms, except the quick hash which may use AVX2.
+// That one gives different results per CPU, so it's only for cache keys. Anything saved
+// (like texture pack names) must use StableQuickTexHash.
 #if defined(_M_SSE)
 u32 QuickTexHashSSE2(const void *checkp, u32 size);
-#define DoQuickTexHash QuickTexHashSSE2
+u32 QuickTexHashAVX2(const void *checkp, u32 size);
+extern QuickTexHashFunc DoQuickTexHash;
 #define StableQuickTexHash QuickTexHashSSE2
 
 // Pitch must be aligned to 16 bytes (as is the case on a PSP)
@@ -53,7 +58,6 @@ void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32
 #define StableQuickTexHash QuickTexHashNEON
 #define DoUnswizzleTex16 DoUnswizzleTex16NEON
 #else
-typedef u32 (*QuickTexHashFunc)(const void *checkp, u32 size);
 extern QuickTexHashFunc DoQuickTexHash;
 extern QuickTexHashFunc StableQuickTexHash;
 
@@ -92,6 +96,11 @@ void DecodeDXT1Block(u32 *dst, const DXT1Block *src, int pitch, int height, bool
 void DecodeDXT3Block(u32 *dst, const DXT3Block *src, int pitch, int height);
 void DecodeDXT5Block(u32 *dst, const DXT5Block *src, int pitch, int height);
 
+// Decode a row of count blocks, left to right, 4 texels apart in dst.
+void DecodeDXT1Blocks(u32 *dst, const DXT1Block *src, int count, int pitch, int height, bool ignore1bitAlpha);
+void DecodeDXT3Blocks(u32 *dst, const DXT3Block *src, int count, int pitch, int height);
+void DecodeDXT5Blocks(u32 *dst, const DXT5Block *src, int count, int pitch, int height);
+
 uint32_t GetDXT1Texel(const DXT1Block *src, int x, int y);
 uint32_t GetDXT3Texel(const DXT3Block *src, int x, int y);
 uint32_t GetDXT5Texel(const DXT5Block *src, int x, int y);
@@ -124,8 +133,20 @@ inline void DeIndexTexture(ClutT *dest, const IndexT *indexed, int length, const
 
 	if (nakedIndex) {
 		if (sizeof(IndexT) == 1) {
-			for (int i = 0; i < length; ++i) {
-				*dest++ = clut[*indexed++];
+			// 256 entries don't fit in registers, but reading 8 indices per load still helps.
+			const u8 *indexed8 = (const u8 *)indexed;
+			int i = 0;
+#if COMMON_LITTLE_ENDIAN
+			for (; i + 8 <= length; i += 8) {
+				u64 indices;
+				memcpy(&indices, indexed8 + i, sizeof(indices));
+				for (int j = 0; j < 8; ++j) {
+					dest[i + j] = clut[(indices >> (j * 8)) & 0xFF];
+				}
+			}
+#endif
+			for (; i < length; ++i) {
+				dest[i] = clut[indexed8[i]];
 			}
 		} else {
 			for (int i = 0; i < length; ++i) {
@@ -145,17 +166,27 @@ inline void DeIndexTexture(ClutT *dest, const u32 texaddr, int length, const Clu
 	DeIndexTexture(dest, indexed, length, clut);
 }
 
+// CLUT4 lookup without any shift, mask, or offset.  Picked at runtime (SSSE3/AVX2 on x86.)
+typedef void (*DeIndexTexture4To16Func)(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+typedef void (*DeIndexTexture4To32Func)(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+extern DeIndexTexture4To16Func DoDeIndexTexture4To16;
+extern DeIndexTexture4To32Func DoDeIndexTexture4To32;
+
+inline void DeIndexTexture4Naked(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	DoDeIndexTexture4To16(dest, indexed, length, clut);
+}
+
+inline void DeIndexTexture4Naked(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	DoDeIndexTexture4To32(dest, indexed, length, clut);
+}
+
 template <typename ClutT>
 inline void DeIndexTexture4(ClutT *dest, const u8 *indexed, int length, const ClutT *clut) {
 	// Usually, there is no special offset, mask, or shift.
 	const bool nakedIndex = gstate.isClutIndexSimple();
 
 	if (nakedIndex) {
-		for (int i = 0; i < length; i += 2) {
-			u8 index = *indexed++;
-			dest[i + 0] = clut[(index >> 0) & 0xf];
-			dest[i + 1] = clut[(index >> 4) & 0xf];
-		}
+		DeIndexTexture4Naked(dest, indexed, length, clut);
 	} else {
 		for (int i = 0; i < length; i += 2) {
 			u8 index = *indexed++;
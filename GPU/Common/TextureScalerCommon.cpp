@@ -16,17 +16,26 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/. 
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <mutex>
+#include <zstd.h>
 
 #include "GPU/Common/TextureScalerCommon.h"
 
 #include "Core/Config.h"
+#include "Core/ELF/ParamSFO.h"
+#include "Core/System.h"
 #include "Common/Common.h"
 #include "Common/Log.h"
 #include "Common/CommonFuncs.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
 #include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/ThreadPools.h"
 #include "Common/CPUDetect.h"
 #include "ext/xbrz/xbrz.h"
@@ -486,6 +495,172 @@ void dbgPGM(int w, int h, u32* pixels, const char* prefix = "dbg") { // 1 compon
 
 }
 
+/////////////////////////////////////// Disk cache
+
+// Scaled textures are stored zstd compressed, since decompression is much faster than scaling.
+static const char SCALED_CACHE_MAGIC[4] = { 'P', 'P', 'S', 'T' };
+static const u32 SCALED_CACHE_VERSION = 1;
+
+struct ScaledCacheHeader {
+	char magic[4];
+	u32 version;
+	u32 width;
+	u32 height;
+	u32 compressedSize;
+};
+
+// Returns an empty path if the cache is off.  Call on the emu/GPU thread.
+static Path ScaledCachePath(u64 key, u32 hash, int factor) {
+	if (!g_Config.bTexScalingDiskCache)
+		return Path();
+	std::string gameID = g_paramSFO.GetDiscID();
+	if (gameID.empty())
+		return Path();
+
+	// Everything that affects the output goes in the name.
+	std::string filename = StringFromFormat("%016llx%08x_%d%s_%dx.ppst", (unsigned long long)key, hash, g_Config.iTexScalingType, g_Config.bTexDeposterize ? "d" : "", factor);
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / "ScaledTextures" / gameID / filename;
+}
+
+static bool LoadScaledFromDisk(const Path &filename, u32 *out, int width, int height) {
+	FILE *fp = File::OpenCFile(filename, "rb");
+	if (!fp)
+		return false;
+
+	// Only a file that is actually wrong gets deleted, not one we just failed to read this time.
+	bool success = false;
+	bool bad = false;
+	ScaledCacheHeader header;
+	if (fread(&header, sizeof(header), 1, fp) != 1) {
+		bad = !ferror(fp);
+	} else if (memcmp(header.magic, SCALED_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != SCALED_CACHE_VERSION) {
+		bad = true;
+	} else if (header.width != (u32)width || header.height != (u32)height) {
+		bad = true;
+	} else {
+		std::vector<u8> compressed(header.compressedSize);
+		if (fread(compressed.data(), 1, compressed.size(), fp) != compressed.size()) {
+			bad = !ferror(fp);
+		} else {
+			size_t expected = (size_t)width * height * sizeof(u32);
+			size_t size = ZSTD_decompress(out, expected, compressed.data(), compressed.size());
+			success = !ZSTD_isError(size) && size == expected;
+			bad = !success;
+		}
+	}
+	fclose(fp);
+
+	if (bad) {
+		WARN_LOG(G3D, "Discarding bad scaled texture cache file %s", filename.c_str());
+		File::Delete(filename);
+	}
+	return success;
+}
+
+// The cache is trimmed back under this, oldest files first, each time this much more has been written.
+static const u64 MAX_SCALED_CACHE_BYTES = 1024ULL * 1024 * 1024;
+static const u64 SCALED_CACHE_TRIM_INTERVAL = 64 * 1024 * 1024;
+// Starts full, so the first save of a session trims.
+static std::atomic<u64> g_scaledBytesSinceTrim(SCALED_CACHE_TRIM_INTERVAL);
+static std::mutex g_scaledTrimLock;
+
+// The root holds a directory per game.
+static void TrimScaledCache(const Path &root) {
+	std::unique_lock<std::mutex> guard(g_scaledTrimLock, std::try_to_lock);
+	if (!guard.owns_lock())
+		return;
+
+	std::vector<File::FileInfo> files;
+	std::vector<File::FileInfo> gameDirs;
+	File::GetFilesInDir(root, &gameDirs);
+	for (const File::FileInfo &dir : gameDirs) {
+		if (!dir.isDirectory)
+			continue;
+		std::vector<File::FileInfo> gameFiles;
+		// Includes temp files left behind by a crash.
+		File::GetFilesInDir(dir.fullName, &gameFiles, "ppst:tmp");
+		for (File::FileInfo &file : gameFiles) {
+			if (!file.isDirectory)
+				files.push_back(std::move(file));
+		}
+	}
+
+	u64 total = 0;
+	for (const File::FileInfo &file : files)
+		total += file.size;
+	if (total <= MAX_SCALED_CACHE_BYTES)
+		return;
+
+	// Go a bit below the cap, so we don't have to trim again right away.
+	std::sort(files.begin(), files.end(), [](const File::FileInfo &a, const File::FileInfo &b) {
+		return a.mtime < b.mtime;
+	});
+	int deleted = 0;
+	for (const File::FileInfo &file : files) {
+		if (total <= MAX_SCALED_CACHE_BYTES / 4 * 3)
+			break;
+		if (File::Delete(file.fullName)) {
+			total -= file.size;
+			deleted++;
+		}
+	}
+	INFO_LOG(G3D, "Trimmed %d old files from the scaled texture cache", deleted);
+}
+
+static void SaveScaledToDisk(const Path &filename, const u32 *data, int width, int height) {
+	File::CreateFullPath(filename.NavigateUp());
+
+	size_t size = (size_t)width * height * sizeof(u32);
+	std::vector<u8> compressed(ZSTD_compressBound(size));
+	size_t compressedSize = ZSTD_compress(compressed.data(), compressed.size(), data, size, 1);
+	if (ZSTD_isError(compressedSize))
+		return;
+
+	ScaledCacheHeader header;
+	memcpy(header.magic, SCALED_CACHE_MAGIC, sizeof(header.magic));
+	header.version = SCALED_CACHE_VERSION;
+	header.width = width;
+	header.height = height;
+	header.compressedSize = (u32)compressedSize;
+
+	// Write under a unique name and rename into place, so readers never see a partial file.
+	static std::atomic<int> tempCounter(0);
+	Path tempFilename = filename.WithExtraExtension(StringFromFormat(".%d.tmp", tempCounter++));
+	FILE *fp = File::OpenCFile(tempFilename, "wb");
+	if (!fp)
+		return;
+	bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+	success = success && fwrite(compressed.data(), 1, compressedSize, fp) == compressedSize;
+	success = fclose(fp) == 0 && success;
+	// The rename can fail if another thread already saved the same texture, that's fine.
+	if (!success || !File::Rename(tempFilename, filename)) {
+		File::Delete(tempFilename);
+		return;
+	}
+
+	if (g_scaledBytesSinceTrim.fetch_add(sizeof(header) + compressedSize) >= SCALED_CACHE_TRIM_INTERVAL) {
+		g_scaledBytesSinceTrim = 0;
+		TrimScaledCache(filename.NavigateUp().NavigateUp());
+	}
+}
+
+class ScaledTextureSaveTask : public Task {
+public:
+	ScaledTextureSaveTask(const Path &filename, const u32 *data, int width, int height)
+		: filename_(filename), data_(data, data + width * height), width_(width), height_(height) {
+	}
+
+	void Run() override {
+		SaveScaledToDisk(filename_, data_.data(), width_, height_);
+	}
+
+private:
+	Path filename_;
+	std::vector<u32> data_;
+	int width_;
+	int height_;
+};
+
 /////////////////////////////////////// Texture Scaler
 
 TextureScalerCommon::TextureScalerCommon() {
@@ -493,6 +668,13 @@ TextureScalerCommon::TextureScalerCommon() {
 }
 
 TextureScalerCommon::~TextureScalerCommon() {
+	{
+		std::lock_guard<std::mutex> guard(asyncLock_);
+		asyncStop_ = true;
+		asyncCond_.notify_one();
+	}
+	if (asyncThread_.joinable())
+		asyncThread_.join();
 }
 
 bool TextureScalerCommon::IsEmptyOrFlat(u32* data, int pixels, int fmt) {
@@ -546,12 +728,31 @@ bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, u32 &dstFmt, int &
 
 	// convert texture to correct format for scaling
 	ConvertTo8888(dstFmt, src, inputBuf, width, height);
+	ScaleConverted(renderBufs_, outputBuf, inputBuf, width, height, factor);
+
+	// update values accordingly
+	dstFmt = Get8888Format();
+	width *= factor;
+	height *= factor;
+
+#ifdef SCALING_MEASURE_TIME
+	if (width*height > 64 * 64 * factor*factor) {
+		double t = time_now_d() - t_start;
+		NOTICE_LOG(G3D, "TextureScaler: processed %9d pixels in %6.5lf seconds. (%9.2lf Mpixels/second)",
+			width*height, t, (width*height) / (t * 1000 * 1000));
+	}
+#endif
+
+	return true;
+}
 
+// The background thread passes its own buffers, so it never waits on the render thread or the other way around.
+void TextureScalerCommon::ScaleConverted(ScaleBuffers &bufs, u32 *outputBuf, u32 *inputBuf, int width, int height, int factor) {
 	// deposterize
 	if (g_Config.bTexDeposterize) {
-		bufDeposter.resize(width*height);
-		DePosterize(inputBuf, bufDeposter.data(), width, height);
-		inputBuf = bufDeposter.data();
+		bufs.deposter.resize(width*height);
+		DePosterize(bufs, inputBuf, bufs.deposter.data(), width, height);
+		inputBuf = bufs.deposter.data();
 	}
 
 	// scale 
@@ -560,34 +761,172 @@ bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, u32 &dstFmt, int &
 		ScaleXBRZ(factor, inputBuf, outputBuf, width, height);
 		break;
 	case HYBRID:
-		ScaleHybrid(factor, inputBuf, outputBuf, width, height);
+		ScaleHybrid(bufs, factor, inputBuf, outputBuf, width, height);
 		break;
 	case BICUBIC:
 		ScaleBicubicMitchell(factor, inputBuf, outputBuf, width, height);
 		break;
 	case HYBRID_BICUBIC:
-		ScaleHybrid(factor, inputBuf, outputBuf, width, height, true);
+		ScaleHybrid(bufs, factor, inputBuf, outputBuf, width, height, true);
 		break;
 	default:
 		ERROR_LOG(G3D, "Unknown scaling type: %d", g_Config.iTexScalingType);
 	}
+}
 
-	// update values accordingly
-	dstFmt = Get8888Format();
-	width *= factor;
-	height *= factor;
+// Caps queued plus finished-but-not-taken results, which hold full size scaled textures.
+static const size_t MAX_ASYNC_SCALE_JOBS = 32;
 
-#ifdef SCALING_MEASURE_TIME
-	if (width*height > 64 * 64 * factor*factor) {
-		double t = time_now_d() - t_start;
-		NOTICE_LOG(G3D, "TextureScaler: processed %9d pixels in %6.5lf seconds. (%9.2lf Mpixels/second)",
-			width*height, t, (width*height) / (t * 1000 * 1000));
+bool TextureScalerCommon::ScaleAsync(u64 key, u32 hash, const u8 *src, int srcPitch, u32 srcFmt, int width, int height, int factor) {
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	AsyncKey k(key, hash);
+	if (asyncJobs_.find(k) != asyncJobs_.end())
+		return true;
+
+	if (asyncJobs_.size() >= MAX_ASYNC_SCALE_JOBS) {
+		// Make room by dropping a result nobody has come back for.  Never drop queued work.
+		auto it = asyncJobs_.begin();
+		while (it != asyncJobs_.end() && !it->second.ready)
+			++it;
+		if (it == asyncJobs_.end())
+			return false;
+		asyncJobs_.erase(it);
+	}
+
+	// The conversion is cheap, and keeps virtual calls off the background thread.
+	int bpp = BytesPerPixel(srcFmt);
+	std::vector<u32> packed;
+	const u32 *packedSrc = (const u32 *)src;
+	if (srcPitch != width * bpp) {
+		packed.resize((width * height * bpp + 3) / 4);
+		for (int y = 0; y < height; ++y) {
+			memcpy((u8 *)packed.data() + y * width * bpp, src + y * srcPitch, width * bpp);
+		}
+		packedSrc = packed.data();
+	}
+
+	AsyncJob &job = asyncJobs_[k];
+	job.width = width;
+	job.height = height;
+	job.factor = factor;
+	job.dstFmt = Get8888Format();
+	job.ready = false;
+	job.diskPath = ScaledCachePath(key, hash, factor);
+	job.data.resize(width * height);
+	u32 *converted = job.data.data();
+	ConvertTo8888(srcFmt, (u32 *)packedSrc, converted, width, height);
+	if (converted != job.data.data()) {
+		// Already 8888, and it pointed us back at the source.
+		memcpy(job.data.data(), converted, width * height * sizeof(u32));
 	}
-#endif
 
+	asyncQueue_.push_back(k);
+	if (!asyncThread_.joinable())
+		asyncThread_ = std::thread(&TextureScalerCommon::AsyncThreadFunc, this);
+	asyncCond_.notify_one();
 	return true;
 }
 
+bool TextureScalerCommon::IsScalePending(u64 key, u32 hash) {
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	return asyncJobs_.find(AsyncKey(key, hash)) != asyncJobs_.end();
+}
+
+bool TextureScalerCommon::IsScaleReady(u64 key, u32 hash) {
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	auto it = asyncJobs_.find(AsyncKey(key, hash));
+	return it != asyncJobs_.end() && it->second.ready;
+}
+
+bool TextureScalerCommon::TakeScaled(u64 key, u32 hash, u32 *out, u32 &dstFmt, int &width, int &height, int factor) {
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	auto it = asyncJobs_.find(AsyncKey(key, hash));
+	if (it == asyncJobs_.end() || !it->second.ready)
+		return false;
+
+	const AsyncJob &job = it->second;
+	bool valid = job.width == width && job.height == height && job.factor == factor;
+	if (valid) {
+		memcpy(out, job.data.data(), job.data.size() * sizeof(u32));
+		dstFmt = job.dstFmt;
+		width *= factor;
+		height *= factor;
+	}
+	asyncJobs_.erase(it);
+	return valid;
+}
+
+void TextureScalerCommon::ScaleCached(u64 key, u32 hash, u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor) {
+	if (TakeScaled(key, hash, out, dstFmt, width, height, factor))
+		return;
+
+	Path diskPath = ScaledCachePath(key, hash, factor);
+	if (!diskPath.empty() && LoadScaledFromDisk(diskPath, out, width * factor, height * factor)) {
+		dstFmt = Get8888Format();
+		width *= factor;
+		height *= factor;
+		return;
+	}
+
+	// Flat textures are cheaper to scale than to load.
+	bool save = !diskPath.empty() && !IsEmptyOrFlat(src, width * height, dstFmt);
+	ScaleAlways(out, src, dstFmt, width, height, factor);
+	if (save)
+		g_threadManager.EnqueueTask(new ScaledTextureSaveTask(diskPath, out, width, height), TaskType::IO_BLOCKING);
+}
+
+void TextureScalerCommon::ClearAsync() {
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	asyncJobs_.clear();
+	asyncQueue_.clear();
+	asyncGeneration_++;
+}
+
+void TextureScalerCommon::AsyncThreadFunc() {
+	SetCurrentThreadName("TexScaler");
+
+	std::unique_lock<std::mutex> guard(asyncLock_);
+	while (!asyncStop_) {
+		if (asyncQueue_.empty()) {
+			asyncCond_.wait(guard);
+			continue;
+		}
+
+		AsyncKey k = asyncQueue_.front();
+		asyncQueue_.pop_front();
+		auto it = asyncJobs_.find(k);
+		if (it == asyncJobs_.end())
+			continue;
+
+		std::vector<u32> input;
+		input.swap(it->second.data);
+		int width = it->second.width;
+		int height = it->second.height;
+		int factor = it->second.factor;
+		Path diskPath = it->second.diskPath;
+		int generation = asyncGeneration_;
+		guard.unlock();
+
+		// Not a pool thread, so the scalers can still use ParallelRangeLoop without deadlocking.
+		std::vector<u32> output(width * factor * height * factor);
+		bool flat = std::all_of(input.begin(), input.end(), [&](u32 c) { return c == input[0]; });
+		if (flat) {
+			std::fill(output.begin(), output.end(), input[0]);
+		} else if (diskPath.empty() || !LoadScaledFromDisk(diskPath, output.data(), width * factor, height * factor)) {
+			ScaleConverted(asyncBufs_, output.data(), input.data(), width, height, factor);
+			if (!diskPath.empty())
+				SaveScaledToDisk(diskPath, output.data(), width * factor, height * factor);
+		}
+
+		guard.lock();
+		it = asyncJobs_.find(k);
+		if (it != asyncJobs_.end() && generation == asyncGeneration_) {
+			it->second.data.swap(output);
+			it->second.ready = true;
+		}
+	}
+}
+
 bool TextureScalerCommon::Scale(u32* &data, u32 &dstFmt, int &width, int &height, int factor) {
 	// prevent processing empty or flat textures (this happens a lot in some games)
 	// doesn't hurt the standard case, will be very quick for textures with actual texture
@@ -613,9 +952,9 @@ void TextureScalerCommon::ScaleXBRZ(int factor, u32* source, u32* dest, int widt
 	ParallelRangeLoop(&g_threadManager, std::bind(&xbrz::scale, factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
 
-void TextureScalerCommon::ScaleBilinear(int factor, u32* source, u32* dest, int width, int height) {
-	bufTmp1.resize(width * height * factor);
-	u32 *tmpBuf = bufTmp1.data();
+void TextureScalerCommon::ScaleBilinear(ScaleBuffers &bufs, int factor, u32* source, u32* dest, int width, int height) {
+	bufs.tmp1.resize(width * height * factor);
+	u32 *tmpBuf = bufs.tmp1.data();
 	ParallelRangeLoop(&g_threadManager, std::bind(&bilinearH, factor, source, tmpBuf, width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 	ParallelRangeLoop(&g_threadManager, std::bind(&bilinearV, factor, tmpBuf, dest, width, 0, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
@@ -628,7 +967,7 @@ void TextureScalerCommon::ScaleBicubicMitchell(int factor, u32* source, u32* des
 	ParallelRangeLoop(&g_threadManager,std::bind(&scaleBicubicMitchell, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
 
-void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int width, int height, bool bicubic) {
+void TextureScalerCommon::ScaleHybrid(ScaleBuffers &bufs, int factor, u32* source, u32* dest, int width, int height, bool bicubic) {
 	// Basic algorithm:
 	// 1) determine a feature mask C based on a sobel-ish filter + splatting, and upscale that mask bilinearly
 	// 2) generate 2 scaled images: A - using Bilinear filtering, B - using xBRZ
@@ -638,31 +977,31 @@ void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int wi
 			{ 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 }
 	};
 
-	bufTmp1.resize(width*height);
-	bufTmp2.resize(width*height*factor*factor);
-	bufTmp3.resize(width*height*factor*factor);
+	bufs.tmp1.resize(width*height);
+	bufs.tmp2.resize(width*height*factor*factor);
+	bufs.tmp3.resize(width*height*factor*factor);
 
-	ParallelRangeLoop(&g_threadManager,std::bind(&generateDistanceMask, source, bufTmp1.data(), width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&convolve3x3, bufTmp1.data(), bufTmp2.data(), KERNEL_SPLAT, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ScaleBilinear(factor, bufTmp2.data(), bufTmp3.data(), width, height);
-	// mask C is now in bufTmp3
+	ParallelRangeLoop(&g_threadManager,std::bind(&generateDistanceMask, source, bufs.tmp1.data(), width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&convolve3x3, bufs.tmp1.data(), bufs.tmp2.data(), KERNEL_SPLAT, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ScaleBilinear(bufs, factor, bufs.tmp2.data(), bufs.tmp3.data(), width, height);
+	// mask C is now in bufs.tmp3
 
-	ScaleXBRZ(factor, source, bufTmp2.data(), width, height);
-	// xBRZ upscaled source is in bufTmp2
+	ScaleXBRZ(factor, source, bufs.tmp2.data(), width, height);
+	// xBRZ upscaled source is in bufs.tmp2
 
 	if (bicubic) ScaleBicubicBSpline(factor, source, dest, width, height);
-	else ScaleBilinear(factor, source, dest, width, height);
+	else ScaleBilinear(bufs, factor, source, dest, width, height);
 	// Upscaled source is in dest
 
 	// Now we can mix it all together
 	// The factor 8192 was found through practical testing on a variety of textures
-	ParallelRangeLoop(&g_threadManager,std::bind(&mix, dest, bufTmp2.data(), bufTmp3.data(), 8192, width*factor, std::placeholders::_1, std::placeholders::_2), 0, height*factor, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&mix, dest, bufs.tmp2.data(), bufs.tmp3.data(), 8192, width*factor, std::placeholders::_1, std::placeholders::_2), 0, height*factor, MIN_LINES_PER_THREAD);
 }
 
-void TextureScalerCommon::DePosterize(u32* source, u32* dest, int width, int height) {
-	bufTmp3.resize(width*height);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, source, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, dest, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+void TextureScalerCommon::DePosterize(ScaleBuffers &bufs, u32* source, u32* dest, int width, int height) {
+	bufs.tmp3.resize(width*height);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, source, bufs.tmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufs.tmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, dest, bufs.tmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufs.tmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
@@ -19,7 +19,13 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
+#include "Common/File/Path.h"
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
@@ -33,25 +39,70 @@ class TextureScalerCommon {
 	bool Scale(u32 *&data, u32 &dstfmt, int &width, int &height, int factor);
 	bool ScaleInto(u32 *out, u32 *src, u32 &dstfmt, int &width, int &height, int factor);
 
+	// Background scaling.  The source is converted right away, so the caller may reuse it.
+	// Results are identified by key and hash, and are picked up later with TakeScaled().
+	bool ScaleAsync(u64 key, u32 hash, const u8 *src, int srcPitch, u32 srcFmt, int width, int height, int factor);
+	// True if queued, in progress, or ready.
+	bool IsScalePending(u64 key, u32 hash);
+	bool IsScaleReady(u64 key, u32 hash);
+	// Like ScaleAlways(), but copies a finished background result.  Returns false if there's none.
+	bool TakeScaled(u64 key, u32 hash, u32 *out, u32 &dstFmt, int &width, int &height, int factor);
+	// Like ScaleAlways(), but tries a background result and the disk cache first.
+	void ScaleCached(u64 key, u32 hash, u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor);
+	void ClearAsync();
+
 	enum { XBRZ = 0, HYBRID = 1, BICUBIC = 2, HYBRID_BICUBIC = 3 };
 
 protected:
+	// Scratch space for one scale at a time.
+	struct ScaleBuffers {
+		SimpleBuf<u32> deposter, tmp1, tmp2, tmp3;
+	};
+
 	virtual void ConvertTo8888(u32 format, u32 *source, u32 *&dest, int width, int height) = 0;
 	virtual int BytesPerPixel(u32 format) = 0;
 	virtual u32 Get8888Format() = 0;
 
 	void ScaleXBRZ(int factor, u32* source, u32* dest, int width, int height);
-	void ScaleBilinear(int factor, u32* source, u32* dest, int width, int height);
+	void ScaleBilinear(ScaleBuffers &bufs, int factor, u32* source, u32* dest, int width, int height);
 	void ScaleBicubicBSpline(int factor, u32* source, u32* dest, int width, int height);
 	void ScaleBicubicMitchell(int factor, u32* source, u32* dest, int width, int height);
-	void ScaleHybrid(int factor, u32* source, u32* dest, int width, int height, bool bicubic = false);
+	void ScaleHybrid(ScaleBuffers &bufs, int factor, u32* source, u32* dest, int width, int height, bool bicubic = false);
 
-	void DePosterize(u32* source, u32* dest, int width, int height);
+	void DePosterize(ScaleBuffers &bufs, u32* source, u32* dest, int width, int height);
 
 	bool IsEmptyOrFlat(u32* data, int pixels, int fmt);
+	void ScaleConverted(ScaleBuffers &bufs, u32 *out, u32 *input, int width, int height, int factor);
+
+	void AsyncThreadFunc();
 
 	// depending on the factor and texture sizes, these can get pretty large 
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
 	// of course, scaling factor 5 is totally silly anyway
-	SimpleBuf<u32> bufInput, bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+	SimpleBuf<u32> bufInput, bufOutput;
+	ScaleBuffers renderBufs_;
+	// Only used by the background thread.
+	ScaleBuffers asyncBufs_;
+
+	typedef std::pair<u64, u32> AsyncKey;
+	struct AsyncJob {
+		int width;
+		int height;
+		int factor;
+		u32 dstFmt;
+		bool ready;
+		// Empty if the disk cache is off.
+		Path diskPath;
+		// 8888 input while queued, scaled output once ready.
+		std::vector<u32> data;
+	};
+
+	std::thread asyncThread_;
+	std::mutex asyncLock_;
+	std::condition_variable asyncCond_;
+	std::map<AsyncKey, AsyncJob> asyncJobs_;
+	std::deque<AsyncKey> asyncQueue_;
+	// Bumped on clear, so in-progress results can be discarded.
+	int asyncGeneration_ = 0;
+	bool asyncStop_ = false;
 };
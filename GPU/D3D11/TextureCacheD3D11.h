@@ -75,6 +75,7 @@ class TextureCacheD3D11 : public TextureCacheCommon {
 
 	void ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, GETextureFormat texFormat, FramebufferNotificationChannel channel) override;
 	void BuildTexture(TexCacheEntry *const entry) override;
+	TextureScalerCommon &GetScaler() override { return scaler; }
 
 	ID3D11Device *device_;
 	ID3D11DeviceContext *context_;
@@ -80,6 +80,7 @@ class TextureCacheGLES : public TextureCacheCommon {
 	void ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, GETextureFormat texFormat, FramebufferNotificationChannel channel) override;
 
 	void BuildTexture(TexCacheEntry *const entry) override;
+	TextureScalerCommon &GetScaler() override { return scaler; }
 
 	GLRenderManager *render_;
 
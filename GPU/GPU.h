@@ -68,6 +68,9 @@ struct GPUStatistics {
 		numTexturesHashed = 0;
 		numTextureSwitches = 0;
 		numTextureDataBytesHashed = 0;
+		numTextureLookups = 0;
+		numTextureLookupMisses = 0;
+		numTextureRehashesDeferred = 0;
 		numShaderSwitches = 0;
 		numFlushes = 0;
 		numTexturesDecoded = 0;
@@ -76,6 +79,8 @@ struct GPUStatistics {
 		numUploads = 0;
 		numClears = 0;
 		msProcessingDisplayLists = 0;
+		msDecodingTextures = 0;
+		msHashingTextures = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 		memset(gpuCommandsAtCallLevel, 0, sizeof(gpuCommandsAtCallLevel));
@@ -93,6 +98,9 @@ struct GPUStatistics {
 	int numTextureInvalidationsByFramebuffer;
 	int numTexturesHashed;
 	int numTextureDataBytesHashed;
+	int numTextureLookups;
+	int numTextureLookupMisses;
+	int numTextureRehashesDeferred;
 	int numTextureSwitches;
 	int numShaderSwitches;
 	int numTexturesDecoded;
@@ -101,6 +109,8 @@ struct GPUStatistics {
 	int numUploads;
 	int numClears;
 	double msProcessingDisplayLists;
+	double msDecodingTextures;
+	double msHashingTextures;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 	int gpuCommandsAtCallLevel[4];
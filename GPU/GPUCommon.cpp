@@ -2907,15 +2907,19 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 	float vertexAverageCycles = gpuStats.numVertsSubmitted > 0 ? (float)gpuStats.vertexGPUCycles / (float)gpuStats.numVertsSubmitted : 0.0f;
 	return snprintf(buffer, size,
 		"DL processing time: %0.2f ms\n"
+		"Texture decode: %0.2f ms, hash: %0.2f ms\n"
 		"Draw calls: %d, flushes %d, clears %d (cached: %d)\n"
 		"Num Tracked Vertex Arrays: %d\n"
 		"Commands per call level: %i %i %i %i\n"
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
 		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
+		"Texture lookups: %d (misses: %d), rehashes deferred: %d\n"
 		"Readbacks: %d, uploads: %d\n"
 		"GPU cycles executed: %d (%f per vertex)\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
+		gpuStats.msDecodingTextures * 1000.0f,
+		gpuStats.msHashingTextures * 1000.0f,
 		gpuStats.numDrawCalls,
 		gpuStats.numFlushes,
 		gpuStats.numClears,
@@ -2931,6 +2935,9 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numTexturesDecoded,
 		gpuStats.numTextureInvalidations,
 		gpuStats.numTextureDataBytesHashed / 1024,
+		gpuStats.numTextureLookups,
+		gpuStats.numTextureLookupMisses,
+		gpuStats.numTextureRehashesDeferred,
 		gpuStats.numReadbacks,
 		gpuStats.numUploads,
 		gpuStats.vertexGPUCycles + gpuStats.otherGPUCycles,
@@ -18,6 +18,10 @@
 #include <cmath>
 #include <algorithm>
 
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#endif
+
 #include "Common/CPUDetect.h"
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
@@ -156,10 +160,9 @@ ScreenCoords TransformUnit::DrawingToScreen(const DrawingCoords& coords)
 	return ret;
 }
 
-VertexData TransformUnit::ReadVertex(VertexReader& vreader)
-{
-	VertexData vertex;
-
+// Reads the attributes of one decoded vertex.  The (skinned) position is left in modelpos,
+// even in through mode, so positions can be transformed later in batches.
+static void ReadVertexInputs(VertexReader &vreader, VertexData &vertex) {
 	float pos[3];
 	// VertexDecoder normally scales z, but we want it unscaled.
 	vreader.ReadPosThroughZ16(pos);
@@ -216,80 +219,170 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 		vertex.color1 = Vec3<int>(0, 0, 0);
 	}
 
-	if (!gstate.isModeThrough()) {
-		vertex.modelpos = ModelCoords(pos[0], pos[1], pos[2]);
+	vertex.modelpos = ModelCoords(pos[0], pos[1], pos[2]);
+}
+
+static void GetFogParams(float *fog_end, float *fog_slope) {
+	*fog_end = getFloat24(gstate.fog1);
+	*fog_slope = getFloat24(gstate.fog2);
+	// Same fixup as in ShaderManagerGLES.cpp
+	if (my_isnanorinf(*fog_end)) {
+		// Not really sure what a sensible value might be, but let's try 64k.
+		*fog_end = std::signbit(*fog_end) ? -65535.0f : 65535.0f;
+	}
+	if (my_isnanorinf(*fog_slope)) {
+		*fog_slope = std::signbit(*fog_slope) ? -65535.0f : 65535.0f;
+	}
+}
+
+// Computes worldpos, clippos and fogdepth from modelpos for count vertices.
+// The SSE path works on four vertices at a time in SoA form, but performs the same operations
+// in the same order as ModelToWorld/WorldToView/ViewToClip, so results are identical.
+static void TransformVertexPositions(VertexData *verts, int count) {
+	const bool fogEnabled = gstate.isFogEnabled();
+	float fog_end = 0.0f, fog_slope = 0.0f;
+	if (fogEnabled)
+		GetFogParams(&fog_end, &fog_slope);
+
+	int i = 0;
+#if defined(_M_SSE)
+	const float *w = gstate.worldMatrix;
+	const float *v = gstate.viewMatrix;
+	const float *p = gstate.projMatrix;
+	for (; i + 4 <= count; i += 4) {
+		VertexData *vd = verts + i;
+		__m128 mx = _mm_setr_ps(vd[0].modelpos.x, vd[1].modelpos.x, vd[2].modelpos.x, vd[3].modelpos.x);
+		__m128 my = _mm_setr_ps(vd[0].modelpos.y, vd[1].modelpos.y, vd[2].modelpos.y, vd[3].modelpos.y);
+		__m128 mz = _mm_setr_ps(vd[0].modelpos.z, vd[1].modelpos.z, vd[2].modelpos.z, vd[3].modelpos.z);
+
+#define MAT3_ROW(m, r, x, y, z) _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[r]), x), _mm_mul_ps(_mm_set1_ps(m[r + 3]), y)), _mm_mul_ps(_mm_set1_ps(m[r + 6]), z)), _mm_set1_ps(m[r + 9]))
+#define MAT4_ROW(m, r, x, y, z) _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[r]), x), _mm_mul_ps(_mm_set1_ps(m[r + 4]), y)), _mm_mul_ps(_mm_set1_ps(m[r + 8]), z)), _mm_set1_ps(m[r + 12]))
+		__m128 wx = MAT3_ROW(w, 0, mx, my, mz);
+		__m128 wy = MAT3_ROW(w, 1, mx, my, mz);
+		__m128 wz = MAT3_ROW(w, 2, mx, my, mz);
+		__m128 vx = MAT3_ROW(v, 0, wx, wy, wz);
+		__m128 vy = MAT3_ROW(v, 1, wx, wy, wz);
+		__m128 vz = MAT3_ROW(v, 2, wx, wy, wz);
+		__m128 cx = MAT4_ROW(p, 0, vx, vy, vz);
+		__m128 cy = MAT4_ROW(p, 1, vx, vy, vz);
+		__m128 cz = MAT4_ROW(p, 2, vx, vy, vz);
+		__m128 cw = MAT4_ROW(p, 3, vx, vy, vz);
+#undef MAT3_ROW
+#undef MAT4_ROW
+
+		float out[8][4];
+		_mm_storeu_ps(out[0], wx);
+		_mm_storeu_ps(out[1], wy);
+		_mm_storeu_ps(out[2], wz);
+		_mm_storeu_ps(out[3], cx);
+		_mm_storeu_ps(out[4], cy);
+		_mm_storeu_ps(out[5], cz);
+		_mm_storeu_ps(out[6], cw);
+		if (fogEnabled)
+			_mm_storeu_ps(out[7], _mm_mul_ps(_mm_add_ps(vz, _mm_set1_ps(fog_end)), _mm_set1_ps(fog_slope)));
+
+		for (int j = 0; j < 4; ++j) {
+			vd[j].worldpos = WorldCoords(out[0][j], out[1][j], out[2][j]);
+			vd[j].clippos = ClipCoords(out[3][j], out[4][j], out[5][j], out[6][j]);
+			vd[j].fogdepth = fogEnabled ? out[7][j] : 1.0f;
+		}
+	}
+#endif
+
+	for (; i < count; ++i) {
+		VertexData &vertex = verts[i];
 		vertex.worldpos = WorldCoords(TransformUnit::ModelToWorld(vertex.modelpos));
 		ModelCoords viewpos = TransformUnit::WorldToView(vertex.worldpos);
 		vertex.clippos = ClipCoords(TransformUnit::ViewToClip(viewpos));
-		if (gstate.isFogEnabled()) {
-			float fog_end = getFloat24(gstate.fog1);
-			float fog_slope = getFloat24(gstate.fog2);
-			// Same fixup as in ShaderManagerGLES.cpp
-			if (my_isnanorinf(fog_end)) {
-				// Not really sure what a sensible value might be, but let's try 64k.
-				fog_end = std::signbit(fog_end) ? -65535.0f : 65535.0f;
-			}
-			if (my_isnanorinf(fog_slope)) {
-				fog_slope = std::signbit(fog_slope) ? -65535.0f : 65535.0f;
-			}
-			vertex.fogdepth = (viewpos.z + fog_end) * fog_slope;
-		} else {
-			vertex.fogdepth = 1.0f;
-		}
-		vertex.screenpos = ClipToScreenInternal(vertex.clippos, &outside_range_flag);
+		vertex.fogdepth = fogEnabled ? (viewpos.z + fog_end) * fog_slope : 1.0f;
+	}
+}
 
-		if (vreader.hasNormal()) {
-			vertex.worldnormal = TransformUnit::ModelToWorldNormal(vertex.normal);
-			vertex.worldnormal /= vertex.worldnormal.Length();
-		} else {
-			vertex.worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
-		}
+// Everything after the position transform: screen mapping, normals, texgen and lighting.
+static void FinishVertex(VertexData &vertex, bool hasNormal, bool hasColor0, bool *outside_range_flag) {
+	if (gstate.isModeThrough()) {
+		vertex.screenpos.x = (int)(vertex.modelpos.x * 16) + gstate.getOffsetX16();
+		vertex.screenpos.y = (int)(vertex.modelpos.y * 16) + gstate.getOffsetY16();
+		vertex.screenpos.z = vertex.modelpos.z;
+		vertex.clippos.w = 1.f;
+		vertex.fogdepth = 1.f;
+		return;
+	}
 
-		// Time to generate some texture coords.  Lighting will handle shade mapping.
-		if (gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX) {
-			Vec3f source;
-			switch (gstate.getUVProjMode()) {
-			case GE_PROJMAP_POSITION:
-				source = vertex.modelpos;
-				break;
+	vertex.screenpos = ClipToScreenInternal(vertex.clippos, outside_range_flag);
 
-			case GE_PROJMAP_UV:
-				source = Vec3f(vertex.texturecoords, 0.0f);
-				break;
+	if (hasNormal) {
+		vertex.worldnormal = TransformUnit::ModelToWorldNormal(vertex.normal);
+		vertex.worldnormal /= vertex.worldnormal.Length();
+	} else {
+		vertex.worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
+	}
 
-			case GE_PROJMAP_NORMALIZED_NORMAL:
-				source = vertex.normal.NormalizedOr001(cpu_info.bSSE4_1);
-				break;
+	// Time to generate some texture coords.  Lighting will handle shade mapping.
+	if (gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX) {
+		Vec3f source;
+		switch (gstate.getUVProjMode()) {
+		case GE_PROJMAP_POSITION:
+			source = vertex.modelpos;
+			break;
 
-			case GE_PROJMAP_NORMAL:
-				source = vertex.normal;
-				break;
+		case GE_PROJMAP_UV:
+			source = Vec3f(vertex.texturecoords, 0.0f);
+			break;
 
-			default:
-				source = Vec3f::AssignToAll(0.0f);
-				ERROR_LOG_REPORT(G3D, "Software: Unsupported UV projection mode %x", gstate.getUVProjMode());
-				break;
-			}
+		case GE_PROJMAP_NORMALIZED_NORMAL:
+			source = vertex.normal.NormalizedOr001(cpu_info.bSSE4_1);
+			break;
+
+		case GE_PROJMAP_NORMAL:
+			source = vertex.normal;
+			break;
 
-			// TODO: What about uv scale and offset?
-			Mat3x3<float> tgen(gstate.tgenMatrix);
-			Vec3<float> stq = tgen * source + Vec3<float>(gstate.tgenMatrix[9], gstate.tgenMatrix[10], gstate.tgenMatrix[11]);
-			float z_recip = 1.0f / stq.z;
-			vertex.texturecoords = Vec2f(stq.x * z_recip, stq.y * z_recip);
+		default:
+			source = Vec3f::AssignToAll(0.0f);
+			ERROR_LOG_REPORT(G3D, "Software: Unsupported UV projection mode %x", gstate.getUVProjMode());
+			break;
 		}
 
-		Lighting::Process(vertex, vreader.hasColor0());
-	} else {
-		vertex.screenpos.x = (int)(pos[0] * 16) + gstate.getOffsetX16();
-		vertex.screenpos.y = (int)(pos[1] * 16) + gstate.getOffsetY16();
-		vertex.screenpos.z = pos[2];
-		vertex.clippos.w = 1.f;
-		vertex.fogdepth = 1.f;
+		// TODO: What about uv scale and offset?
+		Mat3x3<float> tgen(gstate.tgenMatrix);
+		Vec3<float> stq = tgen * source + Vec3<float>(gstate.tgenMatrix[9], gstate.tgenMatrix[10], gstate.tgenMatrix[11]);
+		float z_recip = 1.0f / stq.z;
+		vertex.texturecoords = Vec2f(stq.x * z_recip, stq.y * z_recip);
 	}
 
+	Lighting::Process(vertex, hasColor0);
+}
+
+VertexData TransformUnit::ReadVertex(VertexReader& vreader)
+{
+	VertexData vertex;
+	ReadVertexInputs(vreader, vertex);
+	if (!gstate.isModeThrough())
+		TransformVertexPositions(&vertex, 1);
+	FinishVertex(vertex, vreader.hasNormal(), vreader.hasColor0(), &outside_range_flag);
 	return vertex;
 }
 
+void TransformUnit::ReadVertices(VertexReader &vreader, int count) {
+	if ((int)transformed_.size() < count) {
+		transformed_.resize(count);
+		transformedOutside_.resize(count);
+	}
+
+	for (int i = 0; i < count; ++i) {
+		vreader.Goto(i);
+		ReadVertexInputs(vreader, transformed_[i]);
+	}
+	if (!gstate.isModeThrough())
+		TransformVertexPositions(&transformed_[0], count);
+	for (int i = 0; i < count; ++i) {
+		bool outside = false;
+		FinishVertex(transformed_[i], vreader.hasNormal(), vreader.hasColor0(), &outside);
+		transformedOutside_[i] = outside;
+	}
+}
+
 #define START_OPEN_U 1
 #define END_OPEN_U 2
 #define START_OPEN_V 4
@@ -345,8 +438,23 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	default: vtcs_per_prim = 0; break;
 	}
 
-	// TODO: Do this in two passes - first process the vertices (before indexing/stripping),
-	// then resolve the indices. This lets us avoid transforming shared vertices twice.
+	// When the index range is dense enough, process every decoded vertex once up front and
+	// resolve the indices against the results.  This avoids transforming shared vertices twice.
+	const int index_range = index_upper_bound - index_lower_bound + 1;
+	const bool pretransformed = index_range <= vertex_count * 2;
+	if (pretransformed)
+		ReadVertices(vreader, index_range);
+
+	auto readVertex = [&](int vtx) -> VertexData {
+		int index = indices ? ConvertIndex(vtx) - index_lower_bound : vtx;
+		if (pretransformed) {
+			if (transformedOutside_[index])
+				outside_range_flag = true;
+			return transformed_[index];
+		}
+		vreader.Goto(index);
+		return ReadVertex(vreader);
+	};
 
 	switch (prim_type) {
 	case GE_PRIM_POINTS:
@@ -355,13 +463,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	case GE_PRIM_RECTANGLES:
 		{
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[data_index++] = ReadVertex(vreader);
+				data[data_index++] = readVertex(vtx);
 				if (data_index < vtcs_per_prim) {
 					// Keep reading.  Note: an incomplete prim will stay read for GE_PRIM_KEEP_PREVIOUS.
 					continue;
@@ -414,13 +516,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			// If data_index is 1 or 2, etc., it means we're continuing a line strip.
 			int skip_count = data_index == 0 ? 1 : 0;
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) & 1] = ReadVertex(vreader);
+				data[(data_index++) & 1] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -447,13 +543,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			// This is for Darkstalkers (and should speed up many 2D games).
 			if (vertex_count == 4 && gstate.isModeThrough()) {
 				for (int vtx = 0; vtx < 4; ++vtx) {
-					if (indices) {
-						vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-					}
-					else {
-						vreader.Goto(vtx);
-					}
-					data[vtx] = ReadVertex(vreader);
+					data[vtx] = readVertex(vtx);
 				}
 
 				// If a strip is effectively a rectangle, draw it as such!
@@ -464,14 +554,8 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			}
 
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
 				int provoking_index = (data_index++) % 3;
-				data[provoking_index] = ReadVertex(vreader);
+				data[provoking_index] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -507,25 +591,14 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 			// Only read the central vertex if we're not continuing.
 			if (data_index == 0) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(0) - index_lower_bound);
-				} else {
-					vreader.Goto(0);
-				}
-				data[0] = ReadVertex(vreader);
+				data[0] = readVertex(0);
 				data_index++;
 				start_vtx = 1;
 			}
 
 			for (int vtx = start_vtx; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
 				int provoking_index = 2 - ((data_index++) % 2);
-				data[provoking_index] = ReadVertex(vreader);
+				data[provoking_index] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -133,9 +133,15 @@ class TransformUnit {
 
 	bool GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices);
 	VertexData ReadVertex(VertexReader& vreader);
+	// Reads and transforms the first count decoded vertices into transformed_.
+	void ReadVertices(VertexReader &vreader, int count);
 
 	bool outside_range_flag = false;
 	u8 *buf;
+
+private:
+	std::vector<VertexData> transformed_;
+	std::vector<u8> transformedOutside_;
 };
 
 class SoftwareDrawEngine : public DrawEngineCommon {
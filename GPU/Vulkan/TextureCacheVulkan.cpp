@@ -444,6 +444,8 @@ void TextureCacheVulkan::StartFrame() {
 	timesInvalidatedAllThisFrame_ = 0;
 	texelsScaledThisFrame_ = 0;
 	replacementTimeThisFrame_ = 0.0;
+	rehashBytesThisFrame_ = 0;
+	scaledSwapTimeThisFrame_ = 0.0;
 
 	if (clearCacheNextFrame_) {
 		Clear(true);
@@ -795,9 +797,11 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
 		scaleFactor = 1;
 	}
+	if (!hardwareScaling)
+		DeferScaling(entry, scaleFactor);
 
 	if (scaleFactor != 1) {
-		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED && !hardwareScaling) {
+		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED && !hardwareScaling && !g_Config.bTexScalingAsync) {
 			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
 			scaleFactor = 1;
 		} else {
@@ -1118,11 +1122,12 @@ void TextureCacheVulkan::LoadTextureLevel(TexCacheEntry &entry, uint8_t *writePt
 			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
 		}
 
+		QueueDeferredScaling(entry, (const u8 *)pixelData, decPitch, (u32)dstFmt, w, h);
 		if (scaleFactor > 1) {
 			u32 fmt = dstFmt;
 			// CPU scaling reads from the destination buffer so we want cached RAM.
 			uint8_t *rearrange = (uint8_t *)AllocateAlignedMemory(w * scaleFactor * h * scaleFactor * 4, 16);
-			scaler.ScaleAlways((u32 *)rearrange, pixelData, fmt, w, h, scaleFactor);
+			scaler.ScaleCached(entry.CacheKey(), entry.fullhash, (u32 *)rearrange, pixelData, fmt, w, h, scaleFactor);
 			pixelData = (u32 *)writePtr;
 			dstFmt = (VkFormat)fmt;
 
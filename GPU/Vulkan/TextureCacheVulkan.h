@@ -115,6 +115,7 @@ class TextureCacheVulkan : public TextureCacheCommon {
 
 	void ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, GETextureFormat texFormat, FramebufferNotificationChannel channel) override;
 	void BuildTexture(TexCacheEntry *const entry) override;
+	TextureScalerCommon &GetScaler() override { return scaler; }
 
 	void CompileScalingShader();
 
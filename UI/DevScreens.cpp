@@ -26,6 +26,7 @@
 #include "Common/GPU/OpenGL/GLFeatures.h"
 #include "Common/File/AndroidStorage.h"
 #include "Common/Data/Text/I18n.h"
+#include "Common/File/FileUtil.h"
 #include "Common/Net/HTTPClient.h"
 #include "Common/UI/Context.h"
 #include "Common/UI/View.h"
@@ -54,6 +55,7 @@
 #include "UI/MainScreen.h"
 #include "UI/ControlMappingScreen.h"
 #include "UI/GameSettingsScreen.h"
+#include "UI/OnScreenDisplay.h"
 
 #ifdef _WIN32
 #include "Common/CommonWindows.h"
@@ -98,6 +100,7 @@ void DevMenu::CreatePopupContents(UI::ViewGroup *parent) {
 	items->Add(new CheckBox(&g_Config.bShowFrameProfiler, dev->T("Frame Profiler"), ""));
 #endif
 	items->Add(new CheckBox(&g_Config.bDrawFrameGraph, dev->T("Draw Frametimes Graph")));
+	items->Add(new Choice(Profiler_IsTracing() ? dev->T("Stop Trace Recording") : dev->T("Start Trace Recording")))->OnClick.Handle(this, &DevMenu::OnToggleTrace);
 	items->Add(new Choice(dev->T("Reset limited logging")))->OnClick.Handle(this, &DevMenu::OnResetLimitedLogging);
 
 	scroll->Add(items);
@@ -114,6 +117,25 @@ UI::EventReturn DevMenu::OnToggleAudioDebug(UI::EventParams &e) {
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DevMenu::OnToggleTrace(UI::EventParams &e) {
+	auto dev = GetI18NCategory("Developer");
+	if (!Profiler_IsTracing()) {
+		Profiler_StartTrace();
+		osm.Show(dev->T("Trace recording started"), 2.0f);
+	} else {
+		Profiler_StopTrace();
+		const Path dumpDir = GetSysDirectory(DIRECTORY_DUMP);
+		File::CreateFullPath(dumpDir);
+		Path filename = dumpDir / "trace.json";
+		if (Profiler_ExportChromeTrace(filename))
+			osm.Show(filename.ToVisualString(), 3.0f);
+		else
+			osm.Show(dev->T("Failed to save trace"), 3.0f, 0xFF3030FF);
+	}
+	TriggerFinish(DR_OK);
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DevMenu::OnResetLimitedLogging(UI::EventParams &e) {
 	Reporting::ResetCounts();
 	return UI::EVENT_DONE;
@@ -65,6 +65,7 @@ using namespace std::placeholders;
 #include "Core/HLE/sceCtrl.h"
 #include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceSas.h"
+#include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/SaveState.h"
 #include "Core/MIPS/MIPS.h"
@@ -481,10 +482,12 @@ void EmuScreen::sendMessage(const char *message, const char *value) {
 		if (gpu)
 			gpu->DumpNextFrame();
 	} else if (!strcmp(message, "clear jit")) {
-		currentMIPS->ClearJitCache();
 		if (PSP_IsInited()) {
 			currentMIPS->UpdateCore((CPUCore)g_Config.iCpuCore);
 		}
+		// The core and fast memory decide whether memchecks can use page protection.
+		CBreakPoints::UpdateMemCheckProtection();
+		currentMIPS->ClearJitCache();
 	} else if (!strcmp(message, "window minimized")) {
 		if (!strcmp(value, "true")) {
 			gstate_c.skipDrawReason |= SKIPDRAW_WINDOW_MINIMIZED;
@@ -22,11 +22,16 @@
 #include <memory>
 #include <algorithm>
 
+#include "ext/xxhash.h"
 #include "Common/GPU/thin3d.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Common/File/VFS/VFS.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Serialize/SerializeMap.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/FileSystems/ISOFileSystem.h"
@@ -43,6 +48,127 @@
 
 GameInfoCache *g_gameInfoCache;
 
+static const char *const GAMEINFO_INDEX_FILENAME = "index.ppgi";
+
+// Remembers what we read from game files across runs, keyed by path, size and modification time.
+// With large libraries on network storage, reopening every ISO on each launch is very slow.
+// Icons are stored as separate files next to the index, and only read when an entry is shown.
+class GameInfoDiskIndex {
+public:
+	struct Entry {
+		u64 size = 0;
+		u64 mtime = 0;
+		IdentifiedFileType fileType = IdentifiedFileType::UNKNOWN;
+		std::string paramSFO;
+		bool hasIcon = false;
+
+		void DoState(PointerWrap &p) {
+			auto s = p.Section("GameInfoIndexEntry", 1);
+			if (!s)
+				return;
+
+			Do(p, size);
+			Do(p, mtime);
+			int type = (int)fileType;
+			Do(p, type);
+			fileType = (IdentifiedFileType)type;
+			Do(p, paramSFO);
+			Do(p, hasIcon);
+		}
+	};
+
+	// Only plain local files, we can't cheaply tell if anything else changed.
+	static bool IsIndexable(const Path &gamePath, File::FileInfo *fileInfo) {
+		if (gamePath.Type() != PathType::NATIVE)
+			return false;
+		return File::GetFileInfo(gamePath, fileInfo) && fileInfo->exists && !fileInfo->isDirectory;
+	}
+
+	bool Lookup(const Path &gamePath, const File::FileInfo &fileInfo, Entry *entry) {
+		std::lock_guard<std::mutex> guard(lock_);
+		EnsureLoaded();
+		auto iter = entries_.find(gamePath.ToString());
+		if (iter == entries_.end() || iter->second.size != fileInfo.size || iter->second.mtime != fileInfo.mtime)
+			return false;
+		*entry = iter->second;
+		return true;
+	}
+
+	void Store(const Path &gamePath, const File::FileInfo &fileInfo, Entry entry, const std::string &iconData) {
+		entry.size = fileInfo.size;
+		entry.mtime = fileInfo.mtime;
+		entry.hasIcon = !iconData.empty();
+
+		std::lock_guard<std::mutex> guard(lock_);
+		EnsureLoaded();
+		if (entry.hasIcon) {
+			File::CreateFullPath(dir_);
+			FILE *f = File::OpenCFile(IconPath(gamePath), "wb");
+			if (!f)
+				return;
+			bool success = fwrite(iconData.data(), 1, iconData.size(), f) == iconData.size();
+			fclose(f);
+			if (!success)
+				return;
+		}
+		entries_[gamePath.ToString()] = entry;
+		dirty_ = true;
+	}
+
+	bool ReadIcon(const Path &gamePath, std::string *iconData) {
+		return File::ReadFileToString(false, IconPath(gamePath), *iconData);
+	}
+
+	void Save() {
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!dirty_)
+			return;
+		File::CreateFullPath(dir_);
+		if (CChunkFileReader::Save(dir_ / GAMEINFO_INDEX_FILENAME, "GameInfo", PPSSPP_GIT_VERSION, *this) != CChunkFileReader::ERROR_NONE) {
+			WARN_LOG(LOADER, "Failed to save game info index");
+			return;
+		}
+		dirty_ = false;
+	}
+
+	void DoState(PointerWrap &p) {
+		auto s = p.Section("GameInfoIndex", 1);
+		if (!s)
+			return;
+
+		Do(p, entries_);
+	}
+
+private:
+	void EnsureLoaded() {
+		if (loaded_)
+			return;
+		loaded_ = true;
+		dir_ = GetSysDirectory(DIRECTORY_APP_CACHE) / "GameInfo";
+
+		Path indexPath = dir_ / GAMEINFO_INDEX_FILENAME;
+		if (!File::Exists(indexPath))
+			return;
+		std::string gitVersion, errorString;
+		if (CChunkFileReader::Load(indexPath, &gitVersion, *this, &errorString) != CChunkFileReader::ERROR_NONE) {
+			WARN_LOG(LOADER, "Discarding game info index: %s", errorString.c_str());
+			entries_.clear();
+		}
+		INFO_LOG(LOADER, "Loaded game info index with %d entries", (int)entries_.size());
+	}
+
+	Path IconPath(const Path &gamePath) {
+		const std::string pathStr = gamePath.ToString();
+		return dir_ / StringFromFormat("%016llx.png", (unsigned long long)XXH64(pathStr.data(), pathStr.size(), 0));
+	}
+
+	std::mutex lock_;
+	std::map<std::string, Entry> entries_;
+	Path dir_;
+	bool loaded_ = false;
+	bool dirty_ = false;
+};
+
 GameInfo::GameInfo() : fileType(IdentifiedFileType::UNKNOWN) {
 	pending = true;
 }
@@ -192,6 +318,17 @@ u64 GameInfo::GetInstallDataSizeInBytes() {
 	return totalSize;
 }
 
+void GameInfo::SetPathWithoutLoading(const Path &gamePath) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (filePath_ != gamePath) {
+		fileLoader.reset();
+		filePath_ = gamePath;
+
+		// This is a fallback title, while we're loading / if unable to load.
+		title = filePath_.GetFilename();
+	}
+}
+
 bool GameInfo::LoadFromPath(const Path &gamePath) {
 	std::lock_guard<std::mutex> guard(lock);
 	// No need to rebuild if we already have it loaded.
@@ -326,11 +463,26 @@ static bool ReadVFSToString(const char *filename, std::string *contents, std::mu
 	return data != nullptr;
 }
 
+// For games without an ICON0.PNG.
+static void ReadFallbackIcon(GameInfo *info) {
+	Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info->id + "_00000.jpg");
+	Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info->id + "_00000.png");
+	// Try using png/jpg screenshots first
+	if (File::Exists(screenshot_png))
+		File::ReadFileToString(false, screenshot_png, info->icon.data);
+	else if (File::Exists(screenshot_jpg))
+		File::ReadFileToString(false, screenshot_jpg, info->icon.data);
+	else {
+		DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
+		ReadVFSToString("unknown.png", &info->icon.data, &info->lock);
+	}
+}
+
 
 class GameInfoWorkItem : public Task {
 public:
-	GameInfoWorkItem(const Path &gamePath, std::shared_ptr<GameInfo> &info)
-		: gamePath_(gamePath), info_(info) {
+	GameInfoWorkItem(const Path &gamePath, std::shared_ptr<GameInfo> &info, GameInfoDiskIndex *diskIndex)
+		: gamePath_(gamePath), info_(info), diskIndex_(diskIndex) {
 	}
 
 	~GameInfoWorkItem() override {
@@ -343,6 +495,10 @@ class GameInfoWorkItem : public Task {
 	void Run() override {
 		// An early-return will result in the destructor running, where we can set
 		// flags like working and pending.
+		if (LoadFromDiskIndex()) {
+			return;
+		}
+
 		if (!info_->LoadFromPath(gamePath_)) {
 			return;
 		}
@@ -381,6 +537,7 @@ class GameInfoWorkItem : public Task {
 				std::vector<u8> sfoData;
 				if (pbp.GetSubFile(PBP_PARAM_SFO, &sfoData)) {
 					std::lock_guard<std::mutex> lock(info_->lock);
+					sfoData_.assign((const char *)sfoData.data(), sfoData.size());
 					info_->paramSFO.ReadSFO(sfoData);
 					info_->ParseParamSFO();
 
@@ -398,17 +555,9 @@ class GameInfoWorkItem : public Task {
 				if (pbp.GetSubFileSize(PBP_ICON0_PNG) > 0) {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					pbp.GetSubFileAsString(PBP_ICON0_PNG, &info_->icon.data);
+					iconFromGame_ = true;
 				} else {
-					Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
-					Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						File::ReadFileToString(false, screenshot_png, info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						File::ReadFileToString(false, screenshot_jpg, info_->icon.data);
-					else
-						// Read standard icon
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
+					ReadFallbackIcon(info_.get());
 				}
 				info_->icon.dataLoaded = true;
 
@@ -553,6 +702,7 @@ class GameInfoWorkItem : public Task {
 				std::string paramSFOcontents;
 				if (ReadFileToString(&umd, "/PSP_GAME/PARAM.SFO", &paramSFOcontents, nullptr)) {
 					std::lock_guard<std::mutex> lock(info_->lock);
+					sfoData_ = paramSFOcontents;
 					info_->paramSFO.ReadSFO((const u8 *)paramSFOcontents.data(), paramSFOcontents.size());
 					info_->ParseParamSFO();
 
@@ -569,18 +719,10 @@ class GameInfoWorkItem : public Task {
 				}
 
 				// Fall back to unknown icon if ISO is broken/is a homebrew ISO, override is allowed though
-				if (!ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
-					Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
-					Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						File::ReadFileToString(false, screenshot_png, info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						File::ReadFileToString(false, screenshot_jpg, info_->icon.data);
-					else {
-						DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
-					}
+				if (ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
+					iconFromGame_ = true;
+				} else {
+					ReadFallbackIcon(info_.get());
 				}
 				info_->icon.dataLoaded = true;
 				break;
@@ -625,12 +767,71 @@ class GameInfoWorkItem : public Task {
 			info_->installDataSize = info_->GetInstallDataSizeInBytes();
 		}
 
+		StoreToDiskIndex();
+
 		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
 	}
 
 private:
+	// Only covers what the game list needs (PARAM.SFO and the icon.)
+	bool LoadFromDiskIndex() {
+		if (!diskIndex_ || (info_->wantFlags & (GAMEINFO_WANTBG | GAMEINFO_WANTSND)) != 0)
+			return false;
+		File::FileInfo fileInfo;
+		GameInfoDiskIndex::Entry entry;
+		if (!GameInfoDiskIndex::IsIndexable(gamePath_, &fileInfo) || !diskIndex_->Lookup(gamePath_, fileInfo, &entry))
+			return false;
+
+		info_->SetPathWithoutLoading(gamePath_);
+		info_->working = true;
+		info_->fileType = entry.fileType;
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->paramSFO.ReadSFO((const u8 *)entry.paramSFO.data(), entry.paramSFO.size());
+			info_->ParseParamSFO();
+		}
+
+		std::string iconData;
+		if (entry.hasIcon && diskIndex_->ReadIcon(gamePath_, &iconData)) {
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->icon.data = std::move(iconData);
+		} else {
+			ReadFallbackIcon(info_.get());
+		}
+		info_->icon.dataLoaded = true;
+
+		info_->hasConfig = g_Config.hasGameConfig(info_->id);
+
+		if (info_->wantFlags & GAMEINFO_WANTSIZE) {
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->gameSize = fileInfo.size;
+			info_->saveDataSize = info_->GetSaveDataSizeInBytes();
+			info_->installDataSize = info_->GetInstallDataSizeInBytes();
+		}
+		return true;
+	}
+
+	void StoreToDiskIndex() {
+		if (!diskIndex_ || sfoData_.empty())
+			return;
+		if (info_->fileType != IdentifiedFileType::PSP_ISO && info_->fileType != IdentifiedFileType::PSP_PBP)
+			return;
+		File::FileInfo fileInfo;
+		if (!GameInfoDiskIndex::IsIndexable(gamePath_, &fileInfo))
+			return;
+
+		GameInfoDiskIndex::Entry entry;
+		entry.fileType = info_->fileType;
+		entry.paramSFO = sfoData_;
+		std::lock_guard<std::mutex> lock(info_->lock);
+		diskIndex_->Store(gamePath_, fileInfo, entry, iconFromGame_ ? info_->icon.data : std::string());
+	}
+
 	Path gamePath_;
 	std::shared_ptr<GameInfo> info_;
+	GameInfoDiskIndex *diskIndex_;
+	std::string sfoData_;
+	bool iconFromGame_ = false;
 	DISALLOW_COPY_AND_ASSIGN(GameInfoWorkItem);
 };
 
@@ -643,16 +844,22 @@ GameInfoCache::~GameInfoCache() {
 	Shutdown();
 }
 
-void GameInfoCache::Init() {}
+void GameInfoCache::Init() {
+	diskIndex_.reset(new GameInfoDiskIndex());
+}
 
 void GameInfoCache::Shutdown() {
 	CancelAll();
+	if (diskIndex_)
+		diskIndex_->Save();
 }
 
 void GameInfoCache::Clear() {
 	CancelAll();
 
 	info_.clear();
+	if (diskIndex_)
+		diskIndex_->Save();
 }
 
 void GameInfoCache::CancelAll() {
@@ -737,7 +944,7 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 		info->pending = true;
 	}
 
-	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info);
+	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, diskIndex_.get());
 	g_threadManager.EnqueueTask(item, TaskType::IO_BLOCKING);
 
 	// Don't re-insert if we already have it.
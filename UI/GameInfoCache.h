@@ -59,6 +59,7 @@ enum GameInfoWantFlags {
 };
 
 class FileLoader;
+class GameInfoDiskIndex;
 enum class IdentifiedFileType;
 
 struct GameInfoTex {
@@ -86,6 +87,8 @@ class GameInfo {
 	bool Delete();  // Better be sure what you're doing when calling this.
 	bool DeleteAllSaveData();
 	bool LoadFromPath(const Path &gamePath);
+	// Like LoadFromPath, but doesn't open the file until something needs it.
+	void SetPathWithoutLoading(const Path &gamePath);
 
 	std::shared_ptr<FileLoader> GetFileLoader();
 	void DisposeFileLoader();
@@ -185,6 +188,9 @@ class GameInfoCache {
 	// Maps ISO path to info. Need to use shared_ptr as we can return these pointers - 
 	// and if they get destructed while being in use, that's bad.
 	std::map<std::string, std::shared_ptr<GameInfo> > info_;
+
+	// Persists PARAM.SFO and icons between runs, so we don't have to open every file again.
+	std::unique_ptr<GameInfoDiskIndex> diskIndex_;
 };
 
 // This one can be global, no good reason not to.
@@ -64,6 +64,7 @@
 #include "Core/System.h"
 #include "Core/Reporting.h"
 #include "Core/TextureReplacer.h"
+#include "Core/ThreadPools.h"
 #include "Core/WebServer.h"
 #include "Core/HLE/sceUsbCam.h"
 #include "Core/HLE/sceUsbMic.h"
@@ -564,6 +565,16 @@ void GameSettingsScreen::CreateViews() {
 		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling();
 	});
 
+	CheckBox *texScalingAsync = graphicsSettings->Add(new CheckBox(&g_Config.bTexScalingAsync, gr->T("Upscale in background")));
+	texScalingAsync->SetEnabledFunc([]() {
+		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling() && g_Config.iTexScalingLevel != 1;
+	});
+
+	CheckBox *texScalingDiskCache = graphicsSettings->Add(new CheckBox(&g_Config.bTexScalingDiskCache, gr->T("Save upscaled textures to disk")));
+	texScalingDiskCache->SetEnabledFunc([]() {
+		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling() && g_Config.iTexScalingLevel != 1;
+	});
+
 	ChoiceWithValueDisplay *textureShaderChoice = graphicsSettings->Add(new ChoiceWithValueDisplay(&g_Config.sTextureShaderName, gr->T("Texture Shader"), &TextureTranslateName));
 	textureShaderChoice->OnClick.Handle(this, &GameSettingsScreen::OnTextureShader);
 	textureShaderChoice->SetEnabledFunc([]() {
@@ -1787,8 +1798,11 @@ void DeveloperToolsScreen::CreateViews() {
 #if !defined(MOBILE_DEVICE)
 	Choice *createTextureIni = list->Add(new Choice(dev->T("Create/Open textures.ini file for current game")));
 	createTextureIni->OnClick.Handle(this, &DeveloperToolsScreen::OnOpenTexturesIniFile);
+	Choice *createTextureArchive = list->Add(new Choice(dev->T("Pack textures for current game into one file")));
+	createTextureArchive->OnClick.Handle(this, &DeveloperToolsScreen::OnCreateTextureArchive);
 	if (!PSP_IsInited()) {
 		createTextureIni->SetEnabled(false);
+		createTextureArchive->SetEnabled(false);
 	}
 #endif
 }
@@ -1853,6 +1867,32 @@ UI::EventReturn DeveloperToolsScreen::OnOpenTexturesIniFile(UI::EventParams &e)
 	return UI::EVENT_DONE;
 }
 
+class TextureArchiveTask : public Task {
+public:
+	TextureArchiveTask(const std::string &gameID) : gameID_(gameID) {}
+
+	void Run() override {
+		auto dev = GetI18NCategory("Developer");
+		Path generatedFilename;
+		if (TextureReplacer::GenerateArchive(gameID_, generatedFilename)) {
+			host->NotifyUserMessage(dev->T("Texture pack archive created"), 3.0f);
+			// Makes the texture replacer pick up the new archive.
+			NativeMessageReceived("gpu_resized", "");
+		} else {
+			host->NotifyUserMessage(dev->T("Failed to create texture pack archive"), 3.0f, 0xFF3030FF);
+		}
+	}
+
+private:
+	std::string gameID_;
+};
+
+UI::EventReturn DeveloperToolsScreen::OnCreateTextureArchive(UI::EventParams &e) {
+	// Packing decodes every image in the pack, so keep it off the UI thread.
+	g_threadManager.EnqueueTask(new TextureArchiveTask(g_paramSFO.GetDiscID()), TaskType::IO_BLOCKING);
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DeveloperToolsScreen::OnLogConfig(UI::EventParams &e) {
 	screenManager()->push(new LogConfigScreen());
 	return UI::EVENT_DONE;
@@ -27,6 +27,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
 #include "Core/SaveState.h"
@@ -126,6 +127,8 @@ int printUsage(const char *progname, const char *reason)
 	}
 #endif
 	fprintf(stderr, "  --timeout=SECONDS     abort test it if takes longer than SECONDS\n");
+	fprintf(stderr, "  --trace=FILE          record profiler scopes as a Chrome trace to FILE\n");
+	fprintf(stderr, "  --frame-stats=FILE    write per-frame timing to FILE (.csv or .json)\n");
 
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
@@ -250,6 +253,8 @@ int main(int argc, const char* argv[])
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *traceFilename = nullptr;
+	const char *frameStatsFilename = nullptr;
 	float timeout = std::numeric_limits<float>::infinity();
 
 	for (int i = 1; i < argc; i++)
@@ -306,6 +311,10 @@ int main(int argc, const char* argv[])
 			screenshotFilename = argv[i] + strlen("--screenshot=");
 		else if (!strncmp(argv[i], "--timeout=", strlen("--timeout=")) && strlen(argv[i]) > strlen("--timeout="))
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
+		else if (!strncmp(argv[i], "--trace=", strlen("--trace=")) && strlen(argv[i]) > strlen("--trace="))
+			traceFilename = argv[i] + strlen("--trace=");
+		else if (!strncmp(argv[i], "--frame-stats=", strlen("--frame-stats=")) && strlen(argv[i]) > strlen("--frame-stats="))
+			frameStatsFilename = argv[i] + strlen("--frame-stats=");
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
 		else if (!strcmp(argv[i], "--teamcity"))
@@ -452,6 +461,11 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(Path(stateToLoad), -1);
 
+	if (traceFilename)
+		Profiler_StartTrace();
+	if (frameStatsFilename)
+		__DisplayStartFrameStats();
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -485,6 +499,15 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (traceFilename) {
+		Profiler_StopTrace();
+		Profiler_ExportChromeTrace(Path(std::string(traceFilename)));
+	}
+	if (frameStatsFilename) {
+		__DisplayStopFrameStats();
+		__DisplayExportFrameStats(Path(std::string(frameStatsFilename)));
+	}
+
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
 	}
@@ -29,13 +29,33 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <deque>
+#include <memory>
+#include <thread>
 #include <vector>
 #include <string>
 #include <sstream>
 
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0x00
+#endif
+
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
 #endif
@@ -43,22 +63,35 @@
 #include "Common/Data/Text/Parsers.h"
 #include "Common/Data/Text/WrapText.h"
 #include "Common/Data/Encoding/Utf8.h"
+#include "Common/File/FileDescriptor.h"
+#include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
 #include "Common/Input/InputState.h"
 #include "Common/Math/math_util.h"
+#include "Common/Net/HTTPClient.h"
+#include "Common/Net/HTTPServer.h"
+#include "Common/Net/Resolve.h"
 #include "Common/Render/DrawBuffer.h"
+#include "Common/StringUtils.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
+#include "Common/TimeUtil.h"
 
 #include "Common/ArmEmitter.h"
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
 #include "Core/Config.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HLE/proAdhocServer.h"
+#include "Core/WebServer.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/GPUState.h"
+#include "ext/xxhash.h"
 
 #include "android/jni/AndroidContentURI.h"
 
@@ -453,6 +486,74 @@ bool TestParseLBN() {
 	return true;
 }
 
+// A tiny in-memory disc, just enough directory records for ISOFileSystem to walk.
+class MemoryBlockDevice : public BlockDevice {
+public:
+	MemoryBlockDevice(u32 blocks) : data_(blocks * 2048) {}
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override {
+		if ((u32)blockNumber >= GetNumBlocks())
+			return false;
+		memcpy(outPtr, &data_[blockNumber * 2048], 2048);
+		return true;
+	}
+	u32 GetNumBlocks() override { return (u32)(data_.size() / 2048); }
+	bool IsDisc() override { return true; }
+
+	// Appends a record at pos, moving to the next sector if it won't fit.  Returns the new pos.
+	size_t AddRecord(size_t pos, const std::string &name, u32 sector, u32 size, bool isDir) {
+		size_t len = (33 + name.size() + 1) & ~1;
+		if ((pos & 2047) + len > 2048)
+			pos = (pos + 2047) & ~2047;
+		u8 *rec = &data_[pos];
+		rec[0] = (u8)len;
+		for (int i = 0; i < 4; ++i) {
+			rec[2 + i] = (u8)(sector >> (i * 8));
+			rec[10 + i] = (u8)(size >> (i * 8));
+		}
+		rec[25] = isDir ? 2 : 0;
+		rec[32] = (u8)name.size();
+		memcpy(rec + 33, name.data(), name.size());
+		return pos + len;
+	}
+
+	std::vector<u8> data_;
+};
+
+bool TestISOFileSystem() {
+	const u32 rootSector = 20, rootSectors = 4, subSector = 30;
+	MemoryBlockDevice *device = new MemoryBlockDevice(32);
+	u8 *desc = &device->data_[16 * 2048];
+	memcpy(desc + 1, "CD001", 5);
+	// The root directory record in the volume descriptor.
+	device->AddRecord(16 * 2048 + 156, std::string(1, '\0'), rootSector, rootSectors * 2048, true);
+
+	size_t pos = rootSector * 2048;
+	pos = device->AddRecord(pos, std::string(1, '\0'), rootSector, rootSectors * 2048, true);
+	pos = device->AddRecord(pos, std::string(1, '\1'), rootSector, rootSectors * 2048, true);
+	for (int i = 0; i < 60; ++i) {
+		pos = device->AddRecord(pos, StringFromFormat("FILE%02d.BIN", i), 100 + i, 1000 + i, false);
+	}
+	device->AddRecord(pos, "SUB", subSector, 2048, true);
+	pos = subSector * 2048;
+	pos = device->AddRecord(pos, std::string(1, '\0'), subSector, 2048, true);
+	pos = device->AddRecord(pos, std::string(1, '\1'), rootSector, rootSectors * 2048, true);
+	device->AddRecord(pos, "INNER.TXT", 200, 42, false);
+
+	SequentialHandleAllocator handles;
+	ISOFileSystem fs(&handles, device);
+
+	// Listing the root must work before anything else has read it.
+	EXPECT_EQ_INT((int)fs.GetDirListing("/").size(), 61);
+	EXPECT_EQ_INT((int)fs.GetFileInfo("/FILE17.BIN").size, 1017);
+	EXPECT_EQ_INT((int)fs.GetFileInfo("/FILE59.BIN").size, 1059);
+	EXPECT_TRUE(fs.GetFileInfo("/SUB").type == FILETYPE_DIRECTORY);
+	EXPECT_EQ_INT((int)fs.GetFileInfo("/SUB/INNER.TXT").size, 42);
+	EXPECT_FALSE(fs.GetFileInfo("/file17.bin").exists);
+	EXPECT_FALSE(fs.GetFileInfo("/SUB/FILE17.BIN").exists);
+	EXPECT_FALSE(fs.GetFileInfo("/MISSING/INNER.TXT").exists);
+	return true;
+}
+
 // So we can use EXPECT_TRUE, etc.
 struct AlignedMem {
 	AlignedMem(size_t sz, size_t alignment = 16) {
@@ -481,23 +582,23 @@ bool TestQuickTexHash() {
 	AlignedMem buf(BUF_SIZE, 16);
 
 	memset(buf, 0, BUF_SIZE);
-	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), 0xaa756edc);
+	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0xaa756edc);
 
 	memset(buf, 1, BUF_SIZE);
-	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), 0x66f81b1c);
+	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0x66f81b1c);
 
 	strncpy(buf, "hello", BUF_SIZE);
-	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), 0xf6028131);
+	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0xf6028131);
 
 	strncpy(buf, "goodbye", BUF_SIZE);
-	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), 0xef81b54f);
+	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0xef81b54f);
 
 	// Simple patterns.
 	for (int i = 0; i < BUF_SIZE; ++i) {
 		char *p = buf;
 		p[i] = i & 0xFF;
 	}
-	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), 0x0d64531c);
+	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0x0d64531c);
 
 	int j = 573;
 	for (int i = 0; i < BUF_SIZE; ++i) {
@@ -505,11 +606,222 @@ bool TestQuickTexHash() {
 		j += ((i * 7) + (i & 3)) * 11;
 		p[i] = j & 0xFF;
 	}
-	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), 0x58de8dbc);
+	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0x58de8dbc);
+
+	// The dispatched hash may differ from the stable one, but must be consistent and see changes.
+	u32 quick = DoQuickTexHash(buf, BUF_SIZE);
+	EXPECT_EQ_HEX(DoQuickTexHash(buf, BUF_SIZE), quick);
+	for (int i = 0; i < BUF_SIZE; i += 97) {
+		char *p = buf;
+		p[i] ^= 0x10;
+		EXPECT_TRUE(DoQuickTexHash(buf, BUF_SIZE) != quick);
+		p[i] ^= 0x10;
+	}
 
 	return true;
 }
 
+// Throughput across texture sizes, for comparing the variants.
+bool BenchQuickTexHash() {
+	SetupTextureDecoder();
+
+	static const u32 BENCH_MAX = 1024 * 1024;
+	AlignedMem bench(BENCH_MAX, 16);
+	for (u32 i = 0; i < BENCH_MAX; ++i) {
+		char *p = bench;
+		p[i] = (char)(i * 2654435761U >> 24);
+	}
+	struct Variant {
+		const char *name;
+		QuickTexHashFunc func;
+	};
+	static const Variant variants[] = {
+		{ "stable", [](const void *p, u32 size) { return StableQuickTexHash(p, size); } },
+		{ "quick", [](const void *p, u32 size) { return DoQuickTexHash(p, size); } },
+		{ "xxh32", [](const void *p, u32 size) { return (u32)XXH32(p, size, 0xBACD7814); } },
+		{ "xxh3", [](const void *p, u32 size) { return (u32)XXH3_64bits(p, size); } },
+	};
+	for (u32 size = 4096; size <= BENCH_MAX; size *= 4) {
+		std::string line = StringFromFormat("%s: %4d kB:", __FUNCTION__, size / 1024);
+		for (const Variant &v : variants) {
+			volatile u32 check = 0;
+			int reps = (32 * 1024 * 1024) / size;
+			double start = time_now_d();
+			for (int i = 0; i < reps; ++i) {
+				// Change the data so the calls can't be folded.
+				((volatile u32 *)(char *)bench)[0] = i;
+				check += v.func(bench, size);
+			}
+			double elapsed = time_now_d() - start;
+			line += StringFromFormat(" %s %0.0f MB/s", v.name, (double)reps * size / (1024.0 * 1024.0) / elapsed);
+		}
+		printf("%s\n", line.c_str());
+	}
+
+	return true;
+}
+
+bool TestTextureDecoders() {
+	SetupTextureDecoder();
+
+	u8 raw[2048];
+	u32 seed = 0x1234567;
+	for (u8 &b : raw) {
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+	u16 clut16[16];
+	u32 clut32[16];
+	for (int i = 0; i < 16; ++i) {
+		clut16[i] = (u16)(0x1111 * i + 7);
+		clut32[i] = 0x01020304 * i + 0x80;
+	}
+
+	// The dispatched CLUT4 lookups must match a plain lookup, including the tails.
+	static const int MAX_W = 512;
+	u16 out16[MAX_W];
+	u32 out32[MAX_W];
+	for (int w = 2; w <= MAX_W; w += 2) {
+		DoDeIndexTexture4To16(out16, raw, w, clut16);
+		DoDeIndexTexture4To32(out32, raw, w, clut32);
+		for (int i = 0; i < w; ++i) {
+			int index = (raw[i / 2] >> ((i & 1) * 4)) & 0xF;
+			EXPECT_EQ_INT(out16[i], clut16[index]);
+			EXPECT_EQ_HEX(out32[i], clut32[index]);
+		}
+	}
+
+	// Block rows must match decoding one block at a time.
+	static const int BLOCKS = 64;
+	static const int PITCH = BLOCKS * 4;
+	std::vector<u32> rowOut(PITCH * 4), blockOut(PITCH * 4);
+	for (int height = 1; height <= 4; ++height) {
+		DecodeDXT1Blocks(&rowOut[0], (const DXT1Block *)raw, BLOCKS, PITCH, height, false);
+		for (int i = 0; i < BLOCKS; ++i)
+			DecodeDXT1Block(&blockOut[i * 4], (const DXT1Block *)raw + i, PITCH, height, false);
+		EXPECT_TRUE(memcmp(&rowOut[0], &blockOut[0], PITCH * height * 4) == 0);
+		DecodeDXT3Blocks(&rowOut[0], (const DXT3Block *)raw, BLOCKS, PITCH, height);
+		for (int i = 0; i < BLOCKS; ++i)
+			DecodeDXT3Block(&blockOut[i * 4], (const DXT3Block *)raw + i, PITCH, height);
+		EXPECT_TRUE(memcmp(&rowOut[0], &blockOut[0], PITCH * height * 4) == 0);
+		DecodeDXT5Blocks(&rowOut[0], (const DXT5Block *)raw, BLOCKS, PITCH, height);
+		for (int i = 0; i < BLOCKS; ++i)
+			DecodeDXT5Block(&blockOut[i * 4], (const DXT5Block *)raw + i, PITCH, height);
+		EXPECT_TRUE(memcmp(&rowOut[0], &blockOut[0], PITCH * height * 4) == 0);
+	}
+
+	return true;
+}
+
+// Throughput per format, in millions of texels per second.
+bool BenchTextureDecoders() {
+	SetupTextureDecoder();
+
+	u8 raw[2048];
+	u32 seed = 0x1234567;
+	for (u8 &b : raw) {
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+	u16 clut16[16];
+	u32 clut32[16];
+	for (int i = 0; i < 16; ++i) {
+		clut16[i] = (u16)(0x1111 * i + 7);
+		clut32[i] = 0x01020304 * i + 0x80;
+	}
+
+	static const int MAX_W = 512;
+	static const int BLOCKS = 64;
+	static const int PITCH = BLOCKS * 4;
+	u16 out16[MAX_W];
+	u32 out32[MAX_W];
+	std::vector<u32> rowOut(PITCH * 4);
+
+	static const int REPS = 20000;
+	double start = time_now_d();
+	for (int i = 0; i < REPS; ++i) {
+		raw[0] = (u8)i;
+		DoDeIndexTexture4To16(out16, raw, MAX_W, clut16);
+	}
+	double clut4To16 = REPS * MAX_W / (time_now_d() - start) / 1000000.0;
+	start = time_now_d();
+	for (int i = 0; i < REPS; ++i) {
+		raw[0] = (u8)i;
+		DoDeIndexTexture4To32(out32, raw, MAX_W, clut32);
+	}
+	double clut4To32 = REPS * MAX_W / (time_now_d() - start) / 1000000.0;
+	start = time_now_d();
+	for (int i = 0; i < REPS; ++i) {
+		raw[0] = (u8)i;
+		DecodeDXT1Blocks(&rowOut[0], (const DXT1Block *)raw, BLOCKS, PITCH, 4, false);
+	}
+	double dxt1 = REPS * BLOCKS * 16 / (time_now_d() - start) / 1000000.0;
+	start = time_now_d();
+	for (int i = 0; i < REPS; ++i) {
+		raw[0] = (u8)i;
+		DecodeDXT3Blocks(&rowOut[0], (const DXT3Block *)raw, BLOCKS, PITCH, 4);
+	}
+	double dxt3 = REPS * BLOCKS * 16 / (time_now_d() - start) / 1000000.0;
+	start = time_now_d();
+	for (int i = 0; i < REPS; ++i) {
+		raw[0] = (u8)i;
+		DecodeDXT5Blocks(&rowOut[0], (const DXT5Block *)raw, BLOCKS, PITCH, 4);
+	}
+	double dxt5 = REPS * BLOCKS * 16 / (time_now_d() - start) / 1000000.0;
+	printf("%s: CLUT4 to 16-bit %0.0f, to 32-bit %0.0f, DXT1 %0.0f, DXT3 %0.0f, DXT5 %0.0f Mtexels/s\n", __FUNCTION__, clut4To16, clut4To32, dxt1, dxt3, dxt5);
+
+	return true;
+}
+
+static bool TestTessellationCacheKey() {
+	Vec3f pos[16];
+	Vec2f tex[16];
+	Vec4f col[16];
+	for (int i = 0; i < 16; ++i) {
+		pos[i] = Vec3f((float)(i & 3), (float)(i >> 2), 0.0f);
+		tex[i] = Vec2f((i & 3) / 3.0f, (i >> 2) / 3.0f);
+		col[i] = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+	Spline::ControlPoints points;
+	points.pos = pos;
+	points.tex = tex;
+	points.col = col;
+	points.defcolor = 0xFFFFFFFF;
+	points.size = 16;
+
+	Spline::SurfaceInfo surface{};
+	surface.tess_u = 4;
+	surface.tess_v = 4;
+	surface.num_points_u = 4;
+	surface.num_points_v = 4;
+	surface.num_patches_u = 1;
+	surface.num_patches_v = 1;
+	surface.primType = GE_PATCHPRIM_TRIANGLES;
+
+	const u32 savedLighting = gstate.lightingEnable;
+	gstate.lightingEnable = GE_CMD_LIGHTINGENABLE << 24;
+	const u64 u8TexUnlit = Spline::TessellationCacheKey(surface, points, GE_VTYPE_TC_8BIT);
+	const u64 plainUnlit = Spline::TessellationCacheKey(surface, points, 0);
+	const u64 normals = Spline::TessellationCacheKey(surface, points, GE_VTYPE_NRM_8BIT);
+	const u64 colors = Spline::TessellationCacheKey(surface, points, GE_VTYPE_COL_8888);
+	gstate.lightingEnable = (GE_CMD_LIGHTINGENABLE << 24) | 1;
+	const u64 plainLit = Spline::TessellationCacheKey(surface, points, 0);
+	gstate.lightingEnable = savedLighting;
+
+	// Lighting needs normals generated, which must not collide with any vertex type bit.
+	EXPECT_TRUE(u8TexUnlit != plainLit);
+	EXPECT_TRUE(plainUnlit != plainLit);
+	EXPECT_TRUE(u8TexUnlit != plainUnlit);
+	EXPECT_TRUE(normals != plainUnlit && normals != plainLit);
+	EXPECT_TRUE(colors != plainUnlit);
+
+	// Same inputs, same key, and the control points matter.
+	EXPECT_TRUE(Spline::TessellationCacheKey(surface, points, GE_VTYPE_TC_8BIT) == u8TexUnlit);
+	pos[5].z = 1.0f;
+	EXPECT_TRUE(Spline::TessellationCacheKey(surface, points, GE_VTYPE_TC_8BIT) != u8TexUnlit);
+	return true;
+}
+
 bool TestCLZ() {
 	static const uint32_t input[] = {
 		0xFFFFFFFF,
@@ -740,6 +1052,381 @@ static bool TestWrapText() {
 	return true;
 }
 
+static bool TestAdhocServer() {
+	net::Init();
+	__AdhocServerInit();
+	// Port 0 picks a free one, so parallel runs don't collide.
+	adhocServerThread = std::thread(proAdhocServerThread, 0);
+
+	// Wait for the server to start listening.
+	double deadline = time_now_d() + 5.0;
+	while (!adhocServerRunning && time_now_d() < deadline)
+		sleep_ms(1);
+	if (!adhocServerRunning) {
+		printf("%s: Server didn't start\n", __FUNCTION__);
+		adhocServerThread.join();
+		net::Shutdown();
+		return false;
+	}
+
+	int failed = proAdhocServerLoadTest(adhocServerPort, 256, 4);
+	adhocServerRunning = false;
+	adhocServerThread.join();
+	net::Shutdown();
+
+	if (failed == -2) {
+		printf("%s: Skipped, no 127.1.x.y loopback addresses on this host\n", __FUNCTION__);
+		return true;
+	}
+	EXPECT_EQ_INT(failed, 0);
+	return true;
+}
+
+// Reads one response of the disc server, checking its body against the file contents.
+static bool ReadDiscResponse(uintptr_t sock, std::string &pending, const std::vector<uint8_t> &data, int64_t begin, int64_t len, bool *keepAlive) {
+	std::vector<char> buf(256 * 1024);
+	size_t headerEnd = std::string::npos;
+	int64_t contentLength = -1;
+	while (true) {
+		if (headerEnd == std::string::npos) {
+			headerEnd = pending.find("\r\n\r\n");
+			if (headerEnd != std::string::npos) {
+				std::string headers = pending.substr(0, headerEnd);
+				size_t pos = headers.find("Content-Length: ");
+				if (pos == std::string::npos || headers.compare(0, 12, "HTTP/1.1 206") != 0)
+					return false;
+				contentLength = atoll(headers.c_str() + pos + 16);
+				*keepAlive = headers.find("Connection: keep-alive") != std::string::npos;
+				headerEnd += 4;
+			}
+		}
+		if (headerEnd != std::string::npos && pending.size() >= headerEnd + contentLength)
+			break;
+
+		if (!fd_util::WaitUntilReady((int)sock, 10.0, false))
+			return false;
+		int received = recv(sock, &buf[0], (int)buf.size(), 0);
+		if (received <= 0)
+			return false;
+		pending.append(&buf[0], received);
+	}
+
+	if (contentLength != len || memcmp(pending.data() + headerEnd, &data[begin], (size_t)len) != 0)
+		return false;
+	pending.erase(0, headerEnd + (size_t)contentLength);
+	return true;
+}
+
+static const int64_t DISC_RANGE_SIZE = 1024 * 1024;
+
+// Serves a generated disc image over HTTP, and cleans up the file, server and thread however the test exits.
+class DiscServingFixture {
+public:
+	DiscServingFixture(const char *filename, int64_t size, uint32_t seed) : filename_(filename), size_(size), seed_(seed), server_(new NewThreadExecutor()) {}
+	~DiscServingFixture() {
+		stop_ = true;
+		if (serverThread_.joinable())
+			serverThread_.join();
+		if (listening_)
+			server_.Stop();
+		if (netInit_)
+			net::Shutdown();
+		if (written_)
+			File::Delete(filename_);
+	}
+
+	bool Start() {
+		data_.resize((size_t)size_);
+		uint32_t seed = seed_;
+		for (auto &b : data_) {
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			b = (uint8_t)seed;
+		}
+		written_ = File::WriteDataToFile(false, &data_[0], (unsigned int)data_.size(), filename_);
+		if (!written_)
+			return false;
+
+		net::Init();
+		netInit_ = true;
+		server_.SetFallbackHandler([&](const http::Request &request) {
+			HandleDiscRequest(request, filename_);
+		});
+		listening_ = server_.Listen(0, net::DNSType::IPV4);
+		if (!listening_)
+			return false;
+		serverThread_ = std::thread([&] {
+			while (!stop_)
+				server_.RunSlice(0.1);
+		});
+		return true;
+	}
+
+	// Fetches scattered ranges, either over one kept-alive connection or reconnecting for each range like before.
+	bool FetchRanges(int requests, bool reuse) {
+		http::Client client;
+		std::string pending;
+		bool connected = false;
+		bool success = true;
+		for (int i = 0; i < requests && success; ++i) {
+			if (!connected) {
+				success = client.Resolve("127.0.0.1", server_.Port(), net::DNSType::IPV4) && client.Connect();
+				connected = true;
+				pending.clear();
+			}
+
+			int64_t begin = ((int64_t)i * 7919 * 4096) % (size_ - DISC_RANGE_SIZE);
+			net::Buffer req;
+			req.Printf("GET /disc.iso HTTP/1.1\r\nHost: 127.0.0.1\r\nRange: bytes=%lld-%lld\r\n%s\r\n", (long long)begin, (long long)(begin + DISC_RANGE_SIZE - 1), reuse ? "" : "Connection: close\r\n");
+			bool keepAlive = false;
+			success = success && req.FlushSocket(client.sock(), 10.0);
+			success = success && ReadDiscResponse(client.sock(), pending, data_, begin, DISC_RANGE_SIZE, &keepAlive);
+			success = success && keepAlive == reuse;
+			if (!reuse) {
+				client.Disconnect();
+				connected = false;
+			}
+		}
+		if (connected)
+			client.Disconnect();
+		return success;
+	}
+
+	int Port() {
+		return server_.Port();
+	}
+	const std::vector<uint8_t> &Data() const {
+		return data_;
+	}
+
+private:
+	Path filename_;
+	int64_t size_;
+	uint32_t seed_;
+	std::vector<uint8_t> data_;
+	http::Server server_;
+	std::thread serverThread_;
+	std::atomic<bool> stop_{ false };
+	bool written_ = false;
+	bool netInit_ = false;
+	bool listening_ = false;
+};
+
+static bool TestRemoteDiscServing() {
+	DiscServingFixture fixture("unittest_remote_disc.iso", 32 * 1024 * 1024, 0x12345678);
+	EXPECT_TRUE(fixture.Start());
+	EXPECT_TRUE(fixture.FetchRanges(32, true));
+	EXPECT_TRUE(fixture.FetchRanges(32, false));
+	return true;
+}
+
+bool BenchRemoteDiscServing() {
+	const int REQUESTS = 256;
+	DiscServingFixture fixture("unittest_remote_disc.iso", 32 * 1024 * 1024, 0x12345678);
+	EXPECT_TRUE(fixture.Start());
+	for (int pass = 0; pass < 2; ++pass) {
+		bool reuse = pass == 0;
+		double start = time_now_d();
+		EXPECT_TRUE(fixture.FetchRanges(REQUESTS, reuse));
+		double elapsed = time_now_d() - start;
+		printf("%s: %d x %lld KB ranges %s: %0.1f MB/s\n", __FUNCTION__, REQUESTS, (long long)(DISC_RANGE_SIZE / 1024), reuse ? "over one connection" : "with a connection each", (REQUESTS * DISC_RANGE_SIZE) / (1024.0 * 1024.0) / elapsed);
+	}
+	return true;
+}
+
+// Relays TCP connections to a local port, holding every chunk back to simulate network latency.
+class LatencyProxy {
+public:
+	LatencyProxy(int targetPort, double delay) : targetPort_(targetPort), delay_(delay) {}
+	~LatencyProxy() {
+		Stop();
+	}
+
+	bool Start() {
+		listener_ = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		socklen_t len = sizeof(addr);
+		if (bind(listener_, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener_, 8) < 0 || getsockname(listener_, (sockaddr *)&addr, &len) < 0)
+			return false;
+		port_ = ntohs(addr.sin_port);
+		fd_util::SetNonBlocking(listener_, true);
+		thread_ = std::thread([this] { Run(); });
+		return true;
+	}
+
+	void Stop() {
+		stop_ = true;
+		if (thread_.joinable())
+			thread_.join();
+		if (listener_ != -1)
+			closesocket(listener_);
+		listener_ = -1;
+	}
+
+	int Port() const {
+		return port_;
+	}
+
+private:
+	struct Chunk {
+		double due;
+		std::string data;
+	};
+	struct Link {
+		int client;
+		net::Connection upstream;
+		std::deque<Chunk> toUpstream;
+		std::deque<Chunk> toClient;
+		bool closed = false;
+	};
+
+	// Returns false once the connection is closed.
+	bool Receive(int from, std::deque<Chunk> &queue) {
+		char buf[65536];
+		while (true) {
+			int received = recv(from, buf, sizeof(buf), 0);
+			if (received == 0)
+				return false;
+			if (received < 0) {
+#ifdef _WIN32
+				return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+				return errno == EWOULDBLOCK || errno == EAGAIN;
+#endif
+			}
+			queue.push_back({ time_now_d() + delay_, std::string(buf, received) });
+		}
+	}
+
+	void Deliver(int to, std::deque<Chunk> &queue) {
+		while (!queue.empty() && queue.front().due <= time_now_d()) {
+			std::string &data = queue.front().data;
+			int sent = send(to, data.data(), (int)data.size(), MSG_NOSIGNAL);
+			if (sent <= 0)
+				return;
+			if (sent < (int)data.size()) {
+				data.erase(0, sent);
+				return;
+			}
+			queue.pop_front();
+		}
+	}
+
+	void Run() {
+		std::vector<std::unique_ptr<Link>> links;
+		while (!stop_) {
+			int client = (int)accept(listener_, nullptr, nullptr);
+			if (client != -1) {
+				std::unique_ptr<Link> link(new Link());
+				link->client = client;
+				fd_util::SetNonBlocking(client, true);
+				if (link->upstream.Resolve("127.0.0.1", targetPort_, net::DNSType::IPV4) && link->upstream.Connect()) {
+					links.push_back(std::move(link));
+				} else {
+					closesocket(client);
+				}
+			}
+
+			for (auto &link : links) {
+				int upstream = (int)link->upstream.sock();
+				if (!Receive(link->client, link->toUpstream) || !Receive(upstream, link->toClient))
+					link->closed = true;
+				Deliver(upstream, link->toUpstream);
+				Deliver(link->client, link->toClient);
+			}
+			for (size_t i = 0; i < links.size(); ) {
+				Link &link = *links[i];
+				if (link.closed && link.toUpstream.empty() && link.toClient.empty()) {
+					closesocket(link.client);
+					links.erase(links.begin() + i);
+				} else {
+					++i;
+				}
+			}
+			sleep_ms(1);
+		}
+		for (auto &link : links)
+			closesocket(link->client);
+	}
+
+	int targetPort_;
+	double delay_;
+	int listener_ = -1;
+	int port_ = 0;
+	std::atomic<bool> stop_{ false };
+	std::thread thread_;
+};
+
+static const int64_t HTTP_LOADER_FILE_SIZE = 8 * 1024 * 1024;
+
+// Streams through the whole file the way the caching loaders do, a block at a time.
+static bool ReadHTTPLoaderSequential(HTTPFileLoader &loader, const std::vector<uint8_t> &data) {
+	const size_t BLOCK = 65536;
+	std::vector<uint8_t> buf(BLOCK);
+	for (int64_t pos = 0; pos < HTTP_LOADER_FILE_SIZE; pos += BLOCK) {
+		if (loader.ReadAt(pos, BLOCK, &buf[0]) != BLOCK || memcmp(&buf[0], &data[(size_t)pos], BLOCK) != 0)
+			return false;
+	}
+	return true;
+}
+
+// Scattered sector runs, which can't be predicted and have to take the round trip.
+static bool ReadHTTPLoaderScattered(HTTPFileLoader &loader, const std::vector<uint8_t> &data, int reads) {
+	std::vector<uint8_t> buf(2048 * 64);
+	for (int i = 0; i < reads; ++i) {
+		int64_t pos = ((int64_t)i * 7919 * 2048) % (HTTP_LOADER_FILE_SIZE - (int64_t)buf.size());
+		size_t bytes = 2048 * (1 + (i % 64));
+		if (loader.ReadAt(pos, bytes, &buf[0]) != bytes || memcmp(&buf[0], &data[(size_t)pos], bytes) != 0)
+			return false;
+	}
+	return true;
+}
+
+static bool TestHTTPFileLoader() {
+	DiscServingFixture fixture("unittest_http_loader.iso", HTTP_LOADER_FILE_SIZE, 0x87654321);
+	EXPECT_TRUE(fixture.Start());
+	const std::vector<uint8_t> &data = fixture.Data();
+
+	// 10ms each way, so every request that has to wait for the last costs 20ms.
+	LatencyProxy proxy(fixture.Port(), 0.010);
+	EXPECT_TRUE(proxy.Start());
+
+	HTTPFileLoader loader(Path(StringFromFormat("http://127.0.0.1:%d/disc.iso", proxy.Port())));
+	EXPECT_TRUE(loader.FileSize() == HTTP_LOADER_FILE_SIZE);
+	EXPECT_TRUE(ReadHTTPLoaderSequential(loader, data));
+	EXPECT_TRUE(ReadHTTPLoaderScattered(loader, data, 16));
+
+	// Reading past the end is clipped to the file.
+	std::vector<uint8_t> buf(4096);
+	EXPECT_TRUE(loader.ReadAt(HTTP_LOADER_FILE_SIZE - 1000, 4096, &buf[0]) == 1000);
+	EXPECT_TRUE(memcmp(&buf[0], &data[(size_t)HTTP_LOADER_FILE_SIZE - 1000], 1000) == 0);
+	return true;
+}
+
+bool BenchHTTPFileLoader() {
+	DiscServingFixture fixture("unittest_http_loader.iso", HTTP_LOADER_FILE_SIZE, 0x87654321);
+	EXPECT_TRUE(fixture.Start());
+	LatencyProxy proxy(fixture.Port(), 0.010);
+	EXPECT_TRUE(proxy.Start());
+
+	HTTPFileLoader loader(Path(StringFromFormat("http://127.0.0.1:%d/disc.iso", proxy.Port())));
+	double start = time_now_d();
+	EXPECT_TRUE(ReadHTTPLoaderSequential(loader, fixture.Data()));
+	double elapsed = time_now_d() - start;
+	printf("%s: sequential blocks: %0.1f MB/s\n", __FUNCTION__, HTTP_LOADER_FILE_SIZE / (1024.0 * 1024.0) / elapsed);
+
+	const int READS = 64;
+	start = time_now_d();
+	EXPECT_TRUE(ReadHTTPLoaderScattered(loader, fixture.Data(), READS));
+	elapsed = time_now_d() - start;
+	printf("%s: scattered sectors: %0.1f ms per read\n", __FUNCTION__, elapsed * 1000.0 / READS);
+	return true;
+}
+
 typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
@@ -747,6 +1434,7 @@ struct TestItem {
 };
 
 #define TEST_ITEM(name) { #name, &Test ##name, }
+#define BENCH_ITEM(name) { #name "Bench", &Bench ##name, }
 
 bool TestArmEmitter();
 bool TestArm64Emitter();
@@ -773,7 +1461,10 @@ TestItem availableTests[] = {
 	TEST_ITEM(Jit),
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
+	TEST_ITEM(ISOFileSystem),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(TextureDecoders),
+	TEST_ITEM(TessellationCacheKey),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
 	TEST_ITEM(ShaderGenerators),
@@ -781,6 +1472,17 @@ TestItem availableTests[] = {
 	TEST_ITEM(AndroidContentURI),
 	TEST_ITEM(ThreadManager),
 	TEST_ITEM(WrapText),
+	TEST_ITEM(AdhocServer),
+	TEST_ITEM(RemoteDiscServing),
+	TEST_ITEM(HTTPFileLoader),
+};
+
+// Timing loops, not run with "all" but only when named (or with "bench".)
+TestItem availableBenchmarks[] = {
+	BENCH_ITEM(QuickTexHash),
+	BENCH_ITEM(TextureDecoders),
+	BENCH_ITEM(RemoteDiscServing),
+	BENCH_ITEM(HTTPFileLoader),
 };
 
 int main(int argc, const char *argv[]) {
@@ -791,10 +1493,13 @@ int main(int argc, const char *argv[]) {
 	g_Config.bEnableLogging = true;
 
 	bool allTests = false;
+	bool allBenchmarks = false;
 	TestFunc testFunc = nullptr;
 	if (argc >= 2) {
 		if (!strcasecmp(argv[1], "all")) {
 			allTests = true;
+		} else if (!strcasecmp(argv[1], "bench")) {
+			allBenchmarks = true;
 		}
 		for (auto f : availableTests) {
 			if (!strcasecmp(argv[1], f.name)) {
@@ -802,9 +1507,21 @@ int main(int argc, const char *argv[]) {
 				break;
 			}
 		}
+		for (auto f : availableBenchmarks) {
+			if (!strcasecmp(argv[1], f.name)) {
+				testFunc = f.func;
+				break;
+			}
+		}
 	}
 
-	if (allTests) {
+	if (allBenchmarks) {
+		for (auto f : availableBenchmarks) {
+			if (!f.func()) {
+				printf("%s: FAILED\n", f.name);
+			}
+		}
+	} else if (allTests) {
 		int passes = 0;
 		int fails = 0;
 		for (auto f : availableTests) {
@@ -828,6 +1545,11 @@ int main(int argc, const char *argv[]) {
 		for (auto f : availableTests) {
 			fprintf(stderr, "  * %s\n", f.name);
 		}
+		fprintf(stderr, "\n");
+		fprintf(stderr, "Available benchmarks (or \"bench\" for all):\n");
+		for (auto f : availableBenchmarks) {
+			fprintf(stderr, "  * %s\n", f.name);
+		}
 		return 1;
 	} else {
 		if (!testFunc()) {